@@ -26,6 +26,7 @@
 #endif
 
 #if defined(CONF_FAMILY_UNIX)
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -89,7 +90,17 @@
 #include <emscripten/emscripten.h>
 #endif
 
-static NETSTATS network_stats = {0};
+// updated by the game thread and the network threads of the server
+static struct
+{
+	std::atomic<uint64_t> sent_packets{0};
+	std::atomic<uint64_t> sent_bytes{0};
+	std::atomic<uint64_t> recv_packets{0};
+	std::atomic<uint64_t> recv_bytes{0};
+	std::atomic<uint64_t> send_calls{0};
+	std::atomic<uint64_t> recv_calls{0};
+	std::atomic<uint64_t> send_errors{0};
+} network_stats;
 
 #define VLEN 128
 #define PACKETSIZE 1400
@@ -107,6 +118,20 @@ typedef struct
 #endif
 } NETSOCKET_BUFFER;
 
+// Packets queued between net_udp_batch_begin and net_udp_batch_end
+typedef struct
+{
+	bool batching;
+#ifdef CONF_PLATFORM_LINUX
+	int size;
+	int socks[VLEN];
+	struct mmsghdr msgs[VLEN];
+	struct iovec iovecs[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+	sockaddr_storage sockaddrs[VLEN];
+#endif
+} NETSOCKET_SEND_BUFFER;
+
 void net_buffer_init(NETSOCKET_BUFFER *buffer);
 void net_buffer_reinit(NETSOCKET_BUFFER *buffer);
 void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size);
@@ -120,6 +145,7 @@ struct NETSOCKET_INTERNAL
 	int web_ipv6sock;
 
 	NETSOCKET_BUFFER buffer;
+	NETSOCKET_SEND_BUFFER send_buffer;
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1, -1};
 
@@ -350,6 +376,38 @@ int io_sync(IOHANDLE io)
 #endif
 }
 
+void *io_map(IOHANDLE io, int64_t size)
+{
+	dbg_assert(size > 0, "Invalid size: %" PRId64, size);
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE mapping = CreateFileMappingW((HANDLE)_get_osfhandle(_fileno((FILE *)io)), nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		return nullptr;
+	}
+	// the view keeps the mapping alive
+	void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+	CloseHandle(mapping);
+	return data;
+#else
+	void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno((FILE *)io), 0);
+	if(data == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	return data;
+#endif
+}
+
+void io_unmap(void *data, int64_t size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
 int io_error(IOHANDLE io)
 {
 	return ferror((FILE *)io);
@@ -1618,6 +1676,77 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+static void priv_net_udp_flush(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_BUFFER *buffer = &sock->send_buffer;
+	int first = 0;
+	while(first < buffer->size)
+	{
+		// send the packets to the same socket with one call
+		int last = first + 1;
+		while(last < buffer->size && buffer->socks[last] == buffer->socks[first])
+			last++;
+
+		// a partial send stops at the first packet that failed, the next call reports its error
+		const int sent = sendmmsg(buffer->socks[first], &buffer->msgs[first], last - first, 0);
+		network_stats.send_calls.fetch_add(1, std::memory_order_relaxed);
+		if(sent < 0)
+		{
+			// drop the packet that failed, like a failed sendto
+			network_stats.send_errors.fetch_add(1, std::memory_order_relaxed);
+			log_error("net", "Failed to send a batched packet (%s)", net_error_message().c_str());
+		}
+		first += sent > 0 ? sent : 1;
+	}
+	buffer->size = 0;
+#endif
+}
+
+static int priv_net_udp_sendto(NETSOCKET sock, int sockfd, const void *data, int size, const sockaddr *addr, socklen_t addrlen)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	NETSOCKET_SEND_BUFFER *buffer = &sock->send_buffer;
+	if(buffer->batching && size <= PACKETSIZE)
+	{
+		if(buffer->size == VLEN)
+			priv_net_udp_flush(sock);
+
+		const int i = buffer->size++;
+		buffer->socks[i] = sockfd;
+		mem_copy(buffer->bufs[i], data, size);
+		mem_copy(&buffer->sockaddrs[i], addr, addrlen);
+		buffer->iovecs[i].iov_base = buffer->bufs[i];
+		buffer->iovecs[i].iov_len = size;
+		mem_zero(&buffer->msgs[i], sizeof(buffer->msgs[i]));
+		buffer->msgs[i].msg_hdr.msg_iov = &buffer->iovecs[i];
+		buffer->msgs[i].msg_hdr.msg_iovlen = 1;
+		buffer->msgs[i].msg_hdr.msg_name = &buffer->sockaddrs[i];
+		buffer->msgs[i].msg_hdr.msg_namelen = addrlen;
+		return size;
+	}
+
+	// keep the order of the packets
+	priv_net_udp_flush(sock);
+#endif
+	network_stats.send_calls.fetch_add(1, std::memory_order_relaxed);
+	const int sent = sendto(sockfd, (const char *)data, size, 0, addr, addrlen);
+	if(sent < 0)
+		network_stats.send_errors.fetch_add(1, std::memory_order_relaxed);
+	return sent;
+}
+
+void net_udp_batch_begin(NETSOCKET sock)
+{
+	sock->send_buffer.batching = true;
+}
+
+void net_udp_batch_end(NETSOCKET sock)
+{
+	priv_net_udp_flush(sock);
+	sock->send_buffer.batching = false;
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
@@ -1639,7 +1768,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in(addr, &sa);
 			}
 
-			d = sendto(sock->ipv4sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			d = priv_net_udp_sendto(sock, sock->ipv4sock, data, size, (sockaddr *)&sa, sizeof(sa));
 		}
 		else
 		{
@@ -1687,7 +1816,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 				netaddr_to_sockaddr_in6(addr, &sa);
 			}
 
-			d = sendto(sock->ipv6sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			d = priv_net_udp_sendto(sock, sock->ipv6sock, data, size, (sockaddr *)&sa, sizeof(sa));
 		}
 		else
 		{
@@ -1716,8 +1845,8 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 	}
 #endif
 
-	network_stats.sent_bytes += size;
-	network_stats.sent_packets++;
+	network_stats.sent_bytes.fetch_add(size, std::memory_order_relaxed);
+	network_stats.sent_packets.fetch_add(1, std::memory_order_relaxed);
 	return d;
 }
 
@@ -1765,8 +1894,8 @@ void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size)
 int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 {
 	static const auto &&update_stats = [](int bytes) {
-		network_stats.recv_bytes += bytes;
-		network_stats.recv_packets++;
+		network_stats.recv_bytes.fetch_add(bytes, std::memory_order_relaxed);
+		network_stats.recv_packets.fetch_add(1, std::memory_order_relaxed);
 	};
 
 	int bytes = 0;
@@ -1777,6 +1906,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		{
 			net_buffer_reinit(&sock->buffer);
 			sock->buffer.size = recvmmsg(sock->ipv4sock, sock->buffer.msgs, VLEN, 0, NULL);
+			network_stats.recv_calls.fetch_add(1, std::memory_order_relaxed);
 			sock->buffer.pos = 0;
 		}
 	}
@@ -1787,6 +1917,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		{
 			net_buffer_reinit(&sock->buffer);
 			sock->buffer.size = recvmmsg(sock->ipv6sock, sock->buffer.msgs, VLEN, 0, NULL);
+			network_stats.recv_calls.fetch_add(1, std::memory_order_relaxed);
 			sock->buffer.pos = 0;
 		}
 	}
@@ -1806,6 +1937,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		sockaddr_storage recv_addr;
 		socklen_t fromlen = sizeof(recv_addr);
 		bytes = recvfrom(sock->ipv4sock, sock->buffer.buf, sizeof(sock->buffer.buf), 0, (sockaddr *)&recv_addr, &fromlen);
+		network_stats.recv_calls.fetch_add(1, std::memory_order_relaxed);
 		*data = (unsigned char *)sock->buffer.buf;
 		if(bytes > 0)
 		{
@@ -1820,6 +1952,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		sockaddr_storage recv_addr;
 		socklen_t fromlen = sizeof(recv_addr);
 		bytes = recvfrom(sock->ipv6sock, sock->buffer.buf, sizeof(sock->buffer.buf), 0, (sockaddr *)&recv_addr, &fromlen);
+		network_stats.recv_calls.fetch_add(1, std::memory_order_relaxed);
 		*data = (unsigned char *)sock->buffer.buf;
 		if(bytes > 0)
 		{
@@ -1865,6 +1998,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 
 void net_udp_close(NETSOCKET sock)
 {
+	priv_net_udp_flush(sock);
 	priv_net_close_all_sockets(sock);
 }
 
@@ -2225,6 +2359,7 @@ void fs_listdir_fileinfo(const char *dir, FS_LISTDIR_CALLBACK_FILEINFO cb, int t
 		info.m_pName = current_entry.value().c_str();
 		info.m_TimeCreated = filetime_to_unixtime(&finddata.ftCreationTime);
 		info.m_TimeModified = filetime_to_unixtime(&finddata.ftLastWriteTime);
+		info.m_Size = ((int64_t)finddata.nFileSizeHigh << 32) | finddata.nFileSizeLow;
 
 		if(cb(&info, (finddata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0, type, user))
 			break;
@@ -2251,15 +2386,27 @@ void fs_listdir_fileinfo(const char *dir, FS_LISTDIR_CALLBACK_FILEINFO cb, int t
 			continue;
 		}
 		str_copy(buffer + length, entry->d_name, sizeof(buffer) - length);
-		time_t created = -1, modified = -1;
-		fs_file_time(buffer, &created, &modified);
 
+		// one stat for the times, the size and whether it is a directory
 		CFsFileInfo info;
 		info.m_pName = entry->d_name;
-		info.m_TimeCreated = created;
-		info.m_TimeModified = modified;
+		int is_dir = 0;
+		struct stat sb;
+		if(stat(buffer, &sb) == 0)
+		{
+			info.m_TimeCreated = sb.st_ctime;
+			info.m_TimeModified = sb.st_mtime;
+			info.m_Size = sb.st_size;
+			is_dir = S_ISDIR(sb.st_mode) ? 1 : 0;
+		}
+		else
+		{
+			info.m_TimeCreated = -1;
+			info.m_TimeModified = -1;
+			info.m_Size = -1;
+		}
 
-		if(cb(&info, fs_is_dir(buffer), type, user))
+		if(cb(&info, is_dir, type, user))
 			break;
 	}
 
@@ -2882,7 +3029,13 @@ int str_utf8_dist_buffer(const char *a_utf8, const char *b_utf8, int *buf, int b
 
 void net_stats(NETSTATS *stats_inout)
 {
-	*stats_inout = network_stats;
+	stats_inout->sent_packets = network_stats.sent_packets.load(std::memory_order_relaxed);
+	stats_inout->sent_bytes = network_stats.sent_bytes.load(std::memory_order_relaxed);
+	stats_inout->recv_packets = network_stats.recv_packets.load(std::memory_order_relaxed);
+	stats_inout->recv_bytes = network_stats.recv_bytes.load(std::memory_order_relaxed);
+	stats_inout->send_calls = network_stats.send_calls.load(std::memory_order_relaxed);
+	stats_inout->recv_calls = network_stats.recv_calls.load(std::memory_order_relaxed);
+	stats_inout->send_errors = network_stats.send_errors.load(std::memory_order_relaxed);
 }
 
 static_assert(sizeof(unsigned) == 4, "unsigned must be 4 bytes in size");
@@ -271,6 +271,31 @@ int io_flush(IOHANDLE io);
  */
 int io_sync(IOHANDLE io);
 
+/**
+ * Maps the contents of a file into memory for reading.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param size Number of bytes to map from the start of the file, must be larger than `0`.
+ *
+ * @return Pointer to the mapped contents, `nullptr` on failure.
+ *
+ * @remark The mapping is private, changes to the memory are not written to the file.
+ * @remark The mapping stays valid after the file is closed, it must be released with @link io_unmap @endlink.
+ */
+void *io_map(IOHANDLE io, int64_t size);
+
+/**
+ * Releases memory that was mapped with @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param data Pointer returned by @link io_map @endlink.
+ * @param size Size that was passed to @link io_map @endlink.
+ */
+void io_unmap(void *data, int64_t size);
+
 /**
  * Checks whether an error occurred during I/O with the file.
  *
@@ -783,6 +808,30 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
  */
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
+/**
+ * Starts queueing the packets sent over an UDP socket, so they can be sent
+ * with fewer system calls.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ *
+ * @remark Only has an effect on Linux, where the queued packets are sent with `sendmmsg`.
+ * @remark @link net_udp_send @endlink reports queued packets as sent.
+ *
+ * @see net_udp_batch_end
+ */
+void net_udp_batch_begin(NETSOCKET sock);
+
+/**
+ * Sends the packets queued since @link net_udp_batch_begin @endlink and stops queueing.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ */
+void net_udp_batch_end(NETSOCKET sock);
+
 /**
  * Receives a packet over an UDP socket.
  *
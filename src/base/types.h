@@ -32,6 +32,7 @@ typedef struct
 	const char *m_pName;
 	time_t m_TimeCreated; // seconds since UNIX Epoch
 	time_t m_TimeModified; // seconds since UNIX Epoch
+	int64_t m_Size; // in bytes, -1 if unknown
 } CFsFileInfo;
 
 typedef int (*FS_LISTDIR_CALLBACK_FILEINFO)(const CFsFileInfo *info, int is_dir, int dir_type, void *user);
@@ -94,6 +95,9 @@ typedef struct NETSTATS
 	uint64_t sent_bytes;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
+	uint64_t send_calls;
+	uint64_t recv_calls;
+	uint64_t send_errors;
 } NETSTATS;
 
 #if defined(CONF_FAMILY_WINDOWS)
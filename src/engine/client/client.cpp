@@ -920,7 +920,8 @@ const void *CClient::SnapFindItem(int SnapId, int Type, int Id) const
 	if(!m_aapSnapshots[g_Config.m_ClDummy][SnapId])
 		return nullptr;
 
-	return m_aapSnapshots[g_Config.m_ClDummy][SnapId]->m_pAltSnap->FindItem(Type, Id);
+	CSnapshotStorage::CHolder *pHolder = m_aapSnapshots[g_Config.m_ClDummy][SnapId];
+	return pHolder->AltSnapIndex().FindItem(pHolder->m_pAltSnap, Type, Id);
 }
 
 int CClient::SnapNumItems(int SnapId) const
@@ -987,6 +988,9 @@ void CClient::RenderDebug()
 	str_format(aBuffer, sizeof(aBuffer), "%16s: %" PRIu64 " KiB", "Staging memory", Graphics()->StagingMemoryUsage() / 1024);
 	Graphics()->QuadsText(32.0f * FontSize, 2 + 3 * FontSize, FontSize, aBuffer);
 
+	str_format(aBuffer, sizeof(aBuffer), "%16s: %" PRIu64 " KiB", "Demo cache", (uint64_t)m_DemoPlayer.SnapshotCacheMemoryUsage() / 1024);
+	Graphics()->QuadsText(32.0f * FontSize, 2 + 5 * FontSize, FontSize, aBuffer);
+
 	// Network
 	{
 		const uint64_t OverheadSize = 14 + 20 + 8; // ETH + IP + UDP
@@ -1186,6 +1190,8 @@ const char *CClient::LoadMap(const char *pName, const char *pFilename, const std
 	if((bool)m_LoadingCallback)
 		m_LoadingCallback(IClient::LOADING_CALLBACK_DETAIL_MAP);
 
+	m_pMap->SetMappedData(g_Config.m_ClMapMapped);
+	m_pMap->SetPrefetchData(g_Config.m_ClMapMapped);
 	if(!m_pMap->Load(pFilename, IStorage::TYPE_ALL))
 	{
 		str_format(s_aErrorMsg, sizeof(s_aErrorMsg), "map '%s' not found", pFilename);
@@ -2727,6 +2733,7 @@ void CClient::OnDemoPlayerSnapshot(void *pData, int Size)
 	std::swap(m_aapSnapshots[0][SNAP_PREV], m_aapSnapshots[0][SNAP_CURRENT]);
 	mem_copy(m_aapSnapshots[0][SNAP_CURRENT]->m_pSnap, pData, Size);
 	mem_copy(m_aapSnapshots[0][SNAP_CURRENT]->m_pAltSnap, pAltSnapBuffer, AltSnapSize);
+	m_aapSnapshots[0][SNAP_CURRENT]->m_AltSnapIndexValid = false;
 
 	GameClient()->OnNewSnapshot();
 }
@@ -4076,6 +4083,8 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 		m_aapSnapshots[0][SnapshotType]->m_SnapSize = 0;
 		m_aapSnapshots[0][SnapshotType]->m_AltSnapSize = 0;
 		m_aapSnapshots[0][SnapshotType]->m_Tick = -1;
+		m_aapSnapshots[0][SnapshotType]->m_pAltSnapIndex = &m_aDemorecSnapshotIndices[SnapshotType];
+		m_aapSnapshots[0][SnapshotType]->m_AltSnapIndexValid = false;
 	}
 
 	m_DemoPlayer.Play();
@@ -4175,7 +4184,7 @@ void CClient::DemoRecorder_HandleAutoStart()
 		{
 			// clean up auto recorded demos
 			CFileCollection AutoDemos;
-			AutoDemos.Init(Storage(), "demos/auto", "" /* empty for wild card */, ".demo", g_Config.m_ClAutoDemoMax);
+			AutoDemos.Init(Storage(), "demos/auto", "" /* empty for wild card */, ".demo", g_Config.m_ClAutoDemoMax, CDemoIndex::Remove);
 		}
 	}
 
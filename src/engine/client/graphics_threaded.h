@@ -770,6 +770,7 @@ class CGraphics_Threaded : public IEngineGraphics
 	CCommandBuffer::SVertex m_aVertices[CCommandBuffer::MAX_VERTICES];
 	CCommandBuffer::SVertexTex3DStream m_aVerticesTex3D[CCommandBuffer::MAX_VERTICES];
 	int m_NumVertices;
+	uint64_t m_StreamedDrawCalls = 0;
 
 	CCommandBuffer::SColor m_aColor[4];
 	CCommandBuffer::STexCoord m_aTexture[4];
@@ -911,6 +912,7 @@ public:
 	uint64_t BufferMemoryUsage() const override;
 	uint64_t StreamedMemoryUsage() const override;
 	uint64_t StagingMemoryUsage() const override;
+	uint64_t StreamedDrawCalls() const override { return m_StreamedDrawCalls; }
 
 	const TTwGraphicsGpuList &GetGpus() const override;
 
@@ -1177,6 +1179,7 @@ public:
 		});
 
 		m_pCommandBuffer->AddRenderCalls(1);
+		m_StreamedDrawCalls++;
 	}
 
 	void FlushVertices(bool KeepVertices = false) override;
@@ -280,6 +280,8 @@ public:
 	virtual uint64_t BufferMemoryUsage() const = 0;
 	virtual uint64_t StreamedMemoryUsage() const = 0;
 	virtual uint64_t StagingMemoryUsage() const = 0;
+	// number of draw calls flushed from the streamed vertices of QuadsBegin, LinesBegin etc. so far
+	virtual uint64_t StreamedDrawCalls() const = 0;
 
 	virtual const TTwGraphicsGpuList &GetGpus() const = 0;
 
@@ -37,6 +37,29 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap")
 public:
 	[[nodiscard]] virtual bool Load(const char *pMapName, int StorageType) = 0;
+	/**
+	 * Loads the map from the given storage instead of the one of the kernel, so instances
+	 * that are not registered in the kernel can load maps, e.g. on another thread.
+	 */
+	[[nodiscard]] virtual bool Load(class IStorage *pStorage, const char *pMapName, int StorageType) = 0;
+	/**
+	 * Unloads the current map and takes over the map loaded by another instance, which is unloaded afterwards.
+	 */
+	virtual void Replace(IEngineMap *pOther) = 0;
+	/**
+	 * Sets whether maps loaded afterwards are memory-mapped instead of read. Mapped maps
+	 * must not be overwritten while they are loaded.
+	 *
+	 * Only the client enables this. The server already reads map data lazily from the open
+	 * file and keeps its own copy of the whole file for downloads, so mapping would save it
+	 * little while making in-place map updates crash it.
+	 */
+	virtual void SetMappedData(bool Mapped) = 0;
+	/**
+	 * Sets whether the data of maps loaded afterwards is decompressed on a background thread.
+	 * Only has an effect on memory-mapped maps.
+	 */
+	virtual void SetPrefetchData(bool Prefetch) = 0;
 	virtual void Unload() = 0;
 	virtual bool IsLoaded() const = 0;
 	virtual IOHANDLE File() const = 0;
@@ -246,6 +246,18 @@ public:
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
+	/**
+	 * Per tick cache for snap items that many clients get the same. Items
+	 * created between @link SnapCacheBegin @endlink and @link SnapCacheEnd @endlink
+	 * are stored under the key and variant.
+	 *
+	 * @return `true` if items were cached for the key and variant this tick
+	 *         and have been added to the current snapshot
+	 */
+	virtual bool SnapCacheAdd(const void *pKey, int Variant) = 0;
+	virtual void SnapCacheBegin() = 0;
+	virtual void SnapCacheEnd(const void *pKey, int Variant) = 0;
+
 	enum
 	{
 		RCON_CID_SERV = -1,
@@ -262,6 +274,14 @@ public:
 	virtual void RedirectClient(int ClientId, int Port) = 0;
 	virtual void ChangeMap(const char *pMap) = 0;
 	virtual void ReloadMap() = 0;
+	/**
+	 * Loads a map that will likely be changed to soon in the background, so the map change does not stall the server.
+	 */
+	virtual void PrepareMap(const char *pMap) = 0;
+	/**
+	 * Drops the map loaded by @link PrepareMap @endlink, e.g. because the vote for it failed.
+	 */
+	virtual void CancelPrepareMap() = 0;
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
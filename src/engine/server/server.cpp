@@ -40,11 +40,13 @@
 #include <engine/shared/snapshot.h>
 #include <engine/storage.h>
 
+#include <game/mapitems.h>
 #include <game/version.h>
 
 #include <zlib.h>
 
 #include <chrono>
+#include <thread>
 #include <vector>
 
 using namespace std::chrono_literals;
@@ -1001,8 +1003,14 @@ void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 
 void CServer::DoSnapshot()
 {
+	const std::chrono::nanoseconds Start = time_get_nanoseconds();
 	bool IsGlobalSnap = Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0;
 
+	// cached items are only valid for one tick
+	m_SnapCache.clear();
+	m_vSnapCacheItems.clear();
+	m_vSnapCacheData.clear();
+
 	if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording() || m_aDemoRecorder[RECORDER_AUTO].IsRecording())
 	{
 		// create snapshot for demo recording
@@ -1021,6 +1029,8 @@ void CServer::DoSnapshot()
 	}
 
 	// create snapshots for all clients
+	// game code isn't thread safe, so the snapshots are built here and only compressed in parallel
+	m_vSnapshotJobs.clear();
 	for(int i = 0; i < MaxClients(); i++)
 	{
 		// client must be ingame to receive snapshots
@@ -1056,8 +1066,6 @@ void CServer::DoSnapshot()
 				m_aDemoRecorder[i].RecordSnapshot(Tick(), aData, SnapshotSize);
 			}
 
-			int Crc = pData->Crc();
-
 			// remove old snapshots
 			// keep 3 seconds worth of snapshots
 			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
@@ -1080,64 +1088,111 @@ void CServer::DoSnapshot()
 				}
 			}
 
-			// create delta
+			// demo recorders share this delta, keep its static sizes as they were without parallel compression
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+			CSnapshotJob &Job = m_vSnapshotJobs.emplace_back();
+			Job.m_ClientId = i;
+			Job.m_DeltaTick = DeltaTick;
+			Job.m_pSnapshot = m_aClients[i].m_Snapshots.m_pLast->m_pSnap;
+			Job.m_pDeltashot = pDeltashot;
+		}
+	}
 
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+	if(m_SnapshotWorkers.NumThreads() != Config()->m_SvSnapshotThreads)
+		m_SnapshotWorkers.Init(Config()->m_SvSnapshotThreads);
+	for(int Sixup = 0; Sixup < 2; Sixup++)
+	{
+		m_aClientSnapshotDelta[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, Sixup);
+		m_aClientSnapshotDelta[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, Sixup);
+	}
+	// a client dropped while snapping the others has its snapshots purged already
+	std::erase_if(m_vSnapshotJobs, [this](const CSnapshotJob &Job) { return m_aClients[Job.m_ClientId].m_State != CClient::STATE_INGAME; });
+	m_SnapshotWorkers.Run(m_vSnapshotJobs.size(), CompressSnapshot, this);
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+	// send them in the same order as before
+	for(const CSnapshotJob &Job : m_vSnapshotJobs)
+	{
+		const int i = Job.m_ClientId;
+		if(m_aClients[i].m_State != CClient::STATE_INGAME)
+			continue;
+		const int DeltaTick = Job.m_DeltaTick;
+		const int Crc = Job.m_Crc;
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
-			}
-			else
+		if(!Job.m_Empty)
+		{
+			// compressed in CompressSnapshot
+			const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+
+			const int SnapshotSize = Job.m_CompSize;
+			int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+			for(int n = 0, Left = SnapshotSize; Left > 0; n++)
 			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				int Chunk = Left < MaxSize ? Left : MaxSize;
+				Left -= Chunk;
+
+				if(NumPackets == 1)
+				{
+					CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&Job.m_aCompData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				}
+				else
+				{
+					CMsgPacker Msg(NETMSG_SNAP, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(NumPackets);
+					Msg.AddInt(n);
+					Msg.AddInt(Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&Job.m_aCompData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				}
 			}
 		}
+		else
+		{
+			CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+			Msg.AddInt(m_CurrentGameTick);
+			Msg.AddInt(m_CurrentGameTick - DeltaTick);
+			SendMsg(&Msg, MSGFLAG_FLUSH, i);
+		}
 	}
 
 	if(IsGlobalSnap)
 	{
 		GameServer()->OnPostGlobalSnap();
 	}
+
+	m_LastSnapshotTime = time_get_nanoseconds() - Start;
+	m_MaxSnapshotTime = std::max(m_MaxSnapshotTime, m_LastSnapshotTime);
+	m_TotalSnapshotTime += m_LastSnapshotTime;
+	m_NumSnapshotTicks++;
+}
+
+void CServer::CompressSnapshot(void *pUser, int Index)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	CSnapshotJob &Job = pThis->m_vSnapshotJobs[Index];
+	const CClient &Client = pThis->m_aClients[Job.m_ClientId];
+
+	Job.m_Crc = Job.m_pSnapshot->Crc();
+
+	// create delta
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	const int DeltaSize = pThis->m_aClientSnapshotDelta[Client.m_Sixup].CreateDelta(Job.m_pDeltashot, Job.m_pSnapshot, aDeltaData);
+
+	// compress it, an empty delta is sent as NETMSG_SNAPEMPTY
+	Job.m_Empty = DeltaSize == 0;
+	if(!Job.m_Empty)
+		Job.m_CompSize = CVariableInt::Compress(aDeltaData, DeltaSize, Job.m_aCompData, sizeof(Job.m_aCompData));
 }
 
 int CServer::ClientRejoinCallback(int ClientId, void *pUser)
@@ -2174,31 +2229,93 @@ CServer::CCache::CCacheChunk::CCacheChunk(const void *pData, int Size)
 	m_vData.assign((const uint8_t *)pData, (const uint8_t *)pData + Size);
 }
 
-void CServer::CCache::AddChunk(const void *pData, int Size)
+void CServer::CCache::AddChunk(const void *pData, int Size, int EndClient, int ClientsBefore)
 {
-	m_vCache.emplace_back(pData, Size);
+	CCacheChunk &Chunk = m_vCache.emplace_back(pData, Size);
+	Chunk.m_EndClient = EndClient;
+	Chunk.m_ClientsBefore = ClientsBefore;
 }
 
 void CServer::CCache::Clear()
 {
 	m_vCache.clear();
+	m_vPrefix.clear();
 }
 
-void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
+int CServer::UpdateServerInfoClients()
 {
-	pCache->Clear();
+	int FirstChanged = MAX_CLIENTS;
+	CPacker Packer;
+	char aBuf[128];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CServerInfoClient &Client = m_aServerInfoClients[i];
+		const bool Included = m_aClients[i].IncludedInServerInfo();
+		bool Changed = Included != Client.m_Included;
+		Client.m_Included = Included;
+		if(Included)
+		{
+			Client.m_Player = GameServer()->IsClientPlayer(i);
 
+			int Score;
+			if(m_aClients[i].m_Score.has_value())
+			{
+				Score = m_aClients[i].m_Score.value();
+				if(Score == -FinishTime::NOT_FINISHED_TIMESCORE)
+					Score = FinishTime::NOT_FINISHED_TIMESCORE - 1;
+				else if(Score == 0) // 0 time isn't displayed otherwise.
+					Score = -1;
+				else
+					Score = -Score;
+			}
+			else
+			{
+				Score = FinishTime::NOT_FINISHED_TIMESCORE;
+			}
+
+			Packer.Reset();
+			Packer.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
+			Packer.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
+			str_format(aBuf, sizeof(aBuf), "%d", m_aClients[i].m_Country);
+			Packer.AddString(aBuf, 0); // client country (ISO 3166-1 numeric)
+			str_format(aBuf, sizeof(aBuf), "%d", Score);
+			Packer.AddString(aBuf, 0); // client score
+			Packer.AddString(Client.m_Player ? "1" : "0", 0); // is player?
+			if(Client.m_vEntry.size() != (size_t)Packer.Size() || mem_comp(Client.m_vEntry.data(), Packer.Data(), Packer.Size()) != 0)
+			{
+				Client.m_vEntry.assign(Packer.Data(), Packer.Data() + Packer.Size());
+				Changed = true;
+			}
+
+			// the sixup entries are always packed together, no need to track their changes
+			Packer.Reset();
+			Packer.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
+			Packer.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
+			Packer.AddInt(m_aClients[i].m_Country); // client country (ISO 3166-1 numeric)
+			Packer.AddInt(m_aClients[i].m_Score.value_or(-1)); // client score
+			Packer.AddInt(Client.m_Player ? 0 : 1); // flag spectator=1, bot=2 (player=0)
+			Client.m_vEntrySixup.assign(Packer.Data(), Packer.Data() + Packer.Size());
+		}
+
+		if(Changed && FirstChanged == MAX_CLIENTS)
+			FirstChanged = i;
+	}
+	return FirstChanged;
+}
+
+void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients, int FirstChanged)
+{
 	// One chance to improve the protocol!
 	CPacker p;
 	char aBuf[128];
 
 	// count the players
 	int PlayerCount = 0, ClientCount = 0;
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(const CServerInfoClient &Client : m_aServerInfoClients)
 	{
-		if(m_aClients[i].IncludedInServerInfo())
+		if(Client.m_Included)
 		{
-			if(GameServer()->IsClientPlayer(i))
+			if(Client.m_Player)
 				PlayerCount++;
 
 			ClientCount++;
@@ -2207,7 +2324,6 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 	p.Reset();
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
 #define ADD_INT(p, x) \
 	do \
 	{ \
@@ -2273,44 +2389,88 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 	if(Type == SERVERINFO_EXTENDED)
 		p.AddString("", 0); // extra info, reserved
 
-	const void *pPrefix = p.Data();
-	int PrefixSize = p.Size();
+	CacheServerInfoChunks(pCache, m_aServerInfoClients, Type, SendClients, p.Data(), p.Size(), FirstChanged);
+#undef ADD_INT
+}
 
-	CPacker q;
-	int ChunksStored = 0;
-	int PlayersStored = 0;
+void CServer::CacheServerInfoChunks(CCache *pCache, const CServerInfoClient *pClients, int Type, bool SendClients, const void *pHeader, int HeaderSize, int FirstChanged)
+{
+	char aBuf[128];
 
-#define SAVE(size) \
+#define ADD_INT(p, x) \
 	do \
 	{ \
-		pCache->AddChunk(q.Data(), size); \
-		ChunksStored++; \
+		str_format(aBuf, sizeof(aBuf), "%d", x); \
+		(p).AddString(aBuf, 0); \
 	} while(0)
 
-#define RESET() \
-	do \
-	{ \
-		q.Reset(); \
-		q.AddRaw(pPrefix, PrefixSize); \
-	} while(0)
+	// the header changes with the player counts, map and config, and is
+	// part of all chunks except for the extended ones after the first
+	if(pCache->m_vPrefix.size() != (size_t)HeaderSize || mem_comp(pCache->m_vPrefix.data(), pHeader, HeaderSize) != 0)
+	{
+		if(Type == SERVERINFO_EXTENDED && pCache->m_vPrefix.size() != (size_t)HeaderSize)
+		{
+			// extended chunks are split by size, a longer or shorter header moves all of the splits
+			FirstChanged = 0;
+		}
+		else
+		{
+			// the other chunks are split by the number of clients, only their header is replaced
+			for(size_t i = 0; i < pCache->m_vCache.size() && (Type != SERVERINFO_EXTENDED || i == 0); i++)
+			{
+				std::vector<uint8_t> &vData = pCache->m_vCache[i].m_vData;
+				vData.erase(vData.begin(), vData.begin() + pCache->m_vPrefix.size());
+				vData.insert(vData.begin(), (const uint8_t *)pHeader, (const uint8_t *)pHeader + HeaderSize);
+			}
+		}
+		pCache->m_vPrefix.assign((const uint8_t *)pHeader, (const uint8_t *)pHeader + HeaderSize);
+	}
+	if(FirstChanged == MAX_CLIENTS && !pCache->m_vCache.empty())
+		return;
 
-	RESET();
+	// keep the chunks that only depend on clients before the first changed one
+	size_t NumKept = 0;
+	while(NumKept < pCache->m_vCache.size() && pCache->m_vCache[NumKept].m_EndClient < FirstChanged)
+		NumKept++;
+	if(!pCache->m_vCache.empty() && NumKept == pCache->m_vCache.size())
+		return;
 
-	if(Type == SERVERINFO_64_LEGACY)
-		q.AddInt(PlayersStored); // offset
+	const int StartClient = NumKept > 0 ? pCache->m_vCache[NumKept - 1].m_EndClient : 0;
+	int PlayersStored = NumKept < pCache->m_vCache.size() ? pCache->m_vCache[NumKept].m_ClientsBefore : 0;
+	int ChunksStored = NumKept;
+	while(pCache->m_vCache.size() > NumKept)
+		pCache->m_vCache.pop_back();
+
+	CPacker q;
+	int ChunkClientsBefore = PlayersStored;
+	auto Save = [&](int Size, int EndClient) {
+		pCache->AddChunk(q.Data(), Size, EndClient, ChunkClientsBefore);
+		ChunksStored++;
+	};
+	auto StartChunk = [&]() {
+		q.Reset();
+		ChunkClientsBefore = PlayersStored;
+		if(Type == SERVERINFO_EXTENDED && ChunksStored > 0)
+		{
+			ADD_INT(q, ChunksStored);
+			q.AddString("", 0); // extra info, reserved
+		}
+		else
+		{
+			q.AddRaw(pCache->m_vPrefix.data(), pCache->m_vPrefix.size());
+			if(Type == SERVERINFO_64_LEGACY)
+				q.AddInt(PlayersStored); // offset
+		}
+	};
+
+	StartChunk();
 
 	if(!SendClients)
 	{
-		SAVE(q.Size());
+		Save(q.Size(), MAX_CLIENTS);
 		return;
 	}
 
-	if(Type == SERVERINFO_EXTENDED)
-	{
-		pPrefix = "";
-		PrefixSize = 0;
-	}
-
 	int Remaining;
 	switch(Type)
 	{
@@ -2325,76 +2485,53 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 	// For vanilla, send the first 16 players.
 	// For legacy 64p, send 24 players per packet.
 	// For extended, send as much players as possible.
+	// Every chunk remembers the client it ended at, the chunks before a
+	// changed client stay as they are.
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	int EndClient = MAX_CLIENTS;
+	for(int i = StartClient; i < MAX_CLIENTS; i++)
 	{
-		if(m_aClients[i].IncludedInServerInfo())
-		{
-			if(Remaining == 0)
-			{
-				if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-					break;
+		const CServerInfoClient &Client = pClients[i];
+		if(!Client.m_Included)
+			continue;
 
-				// Otherwise we're SERVERINFO_64_LEGACY.
-				SAVE(q.Size());
-				RESET();
-				q.AddInt(PlayersStored); // offset
-				Remaining = 24;
-			}
-			if(Remaining > 0)
+		if(Remaining == 0)
+		{
+			if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
 			{
-				Remaining--;
+				EndClient = i;
+				break;
 			}
 
-			int PreviousSize = q.Size();
-
-			q.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-			q.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-
-			ADD_INT(q, m_aClients[i].m_Country); // client country (ISO 3166-1 numeric)
-
-			int Score;
-			if(m_aClients[i].m_Score.has_value())
-			{
-				Score = m_aClients[i].m_Score.value();
-				if(Score == -FinishTime::NOT_FINISHED_TIMESCORE)
-					Score = FinishTime::NOT_FINISHED_TIMESCORE - 1;
-				else if(Score == 0) // 0 time isn't displayed otherwise.
-					Score = -1;
-				else
-					Score = -Score;
-			}
-			else
-			{
-				Score = FinishTime::NOT_FINISHED_TIMESCORE;
-			}
+			// Otherwise we're SERVERINFO_64_LEGACY.
+			Save(q.Size(), i);
+			StartChunk();
+			Remaining = 24;
+		}
+		if(Remaining > 0)
+		{
+			Remaining--;
+		}
 
-			ADD_INT(q, Score); // client score
-			ADD_INT(q, GameServer()->IsClientPlayer(i) ? 1 : 0); // is player?
-			if(Type == SERVERINFO_EXTENDED)
-				q.AddString("", 0); // extra info, reserved
+		int PreviousSize = q.Size();
 
-			if(Type == SERVERINFO_EXTENDED)
+		q.AddRaw(Client.m_vEntry.data(), Client.m_vEntry.size());
+		if(Type == SERVERINFO_EXTENDED)
+		{
+			q.AddString("", 0); // extra info, reserved
+			if(q.Size() >= NET_MAX_PAYLOAD - 18) // 8 bytes for type, 10 bytes for the largest token
 			{
-				if(q.Size() >= NET_MAX_PAYLOAD - 18) // 8 bytes for type, 10 bytes for the largest token
-				{
-					// Retry current player.
-					i--;
-					SAVE(PreviousSize);
-					RESET();
-					ADD_INT(q, ChunksStored);
-					q.AddString("", 0); // extra info, reserved
-					continue;
-				}
+				// Retry current player.
+				Save(PreviousSize, i);
+				StartChunk();
+				i--;
+				continue;
 			}
-			PlayersStored++;
 		}
+		PlayersStored++;
 	}
 
-	SAVE(q.Size());
-#undef SAVE
-#undef RESET
-#undef ADD_RAW
+	Save(q.Size(), EndClient);
 #undef ADD_INT
 }
 
@@ -2410,12 +2547,12 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxCons
 	int PlayerCount = 0, ClientCount = 0, ClientCountAll = 0;
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(m_aClients[i].IncludedInServerInfo())
+		if(m_aServerInfoClients[i].m_Included)
 		{
 			ClientCountAll++;
 			if(i < MaxConsideredClients)
 			{
-				if(GameServer()->IsClientPlayer(i))
+				if(m_aServerInfoClients[i].m_Player)
 					PlayerCount++;
 
 				ClientCount++;
@@ -2459,13 +2596,10 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxCons
 	{
 		for(int i = 0; i < MaxConsideredClients; i++)
 		{
-			if(m_aClients[i].IncludedInServerInfo())
+			const CServerInfoClient &Client = m_aServerInfoClients[i];
+			if(Client.m_Included)
 			{
-				Packer.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-				Packer.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-				Packer.AddInt(m_aClients[i].m_Country); // client country (ISO 3166-1 numeric)
-				Packer.AddInt(m_aClients[i].m_Score.value_or(-1)); // client score
-				Packer.AddInt(GameServer()->IsClientPlayer(i) ? 0 : 1); // flag spectator=1, bot=2 (player=0)
+				Packer.AddRaw(Client.m_vEntrySixup.data(), Client.m_vEntrySixup.size());
 
 				const int MaxPacketSize = NET_MAX_PAYLOAD - 128;
 				if(MaxConsideredClients == MAX_CLIENTS)
@@ -2730,9 +2864,10 @@ void CServer::UpdateServerInfo(bool Resend)
 
 	UpdateRegisterServerInfo();
 
+	const int FirstChanged = UpdateServerInfoClients();
 	for(int i = 0; i < 3; i++)
 		for(int j = 0; j < 2; j++)
-			CacheServerInfo(&m_aServerInfoCache[i * 2 + j], i, j);
+			CacheServerInfo(&m_aServerInfoCache[i * 2 + j], i, j, FirstChanged);
 
 	for(int i = 0; i < 2; i++)
 		CacheServerInfoSixup(&m_aSixupServerInfoCache[i], i, MAX_CLIENTS);
@@ -2876,10 +3011,205 @@ void CServer::ReloadMap()
 	m_SameMapReload = true;
 }
 
+CServer::CPrepareMapJob::CPrepareMapJob(IStorage *pStorage, const char *pMapName, bool Sixup) :
+	m_pStorage(pStorage),
+	m_Sixup(Sixup)
+{
+	Abortable(true);
+	str_copy(m_aMapName, pMapName);
+	str_format(m_aPath, sizeof(m_aPath), "maps/%s.map", pMapName);
+	m_aFullPath[0] = '\0';
+}
+
+CServer::CPrepareMapJob::~CPrepareMapJob()
+{
+	for(unsigned char *pData : m_apData)
+	{
+		free(pData);
+	}
+}
+
+void CServer::CPrepareMapJob::Run()
+{
+	const std::chrono::nanoseconds StartTime = time_get_nanoseconds();
+
+	// read the map for downloads, this also finds its full path to detect changes of the file
+	IOHANDLE File = m_pStorage->OpenFile(m_aPath, IOFLAG_READ, IStorage::TYPE_ALL, m_aFullPath, sizeof(m_aFullPath));
+	if(!File)
+	{
+		return;
+	}
+	void *pData;
+	const bool Read = io_read_all(File, &pData, &m_aSize[MAP_TYPE_SIX]);
+	io_close(File);
+	if(!Read)
+	{
+		return;
+	}
+	m_apData[MAP_TYPE_SIX] = static_cast<unsigned char *>(pData);
+	time_t Created;
+	if(fs_file_time(m_aFullPath, &Created, &m_Modified) != 0 || State() == STATE_ABORTED)
+	{
+		return;
+	}
+
+	// load and decode the map like the server's map
+	m_pMap.reset(CreateEngineMap());
+	if(!m_pMap->Load(m_pStorage, m_aPath, IStorage::TYPE_ALL) || State() == STATE_ABORTED)
+	{
+		return;
+	}
+
+	// only tilemaps of version 4 maps are decompressed while loading, read the
+	// rest of the data of the game now, so only building the collision is left
+	// for the map change. Images and sounds are not used by the server.
+	for(int Index : GameDataIndices(m_pMap.get()))
+	{
+		m_pMap->GetData(Index);
+		if(State() == STATE_ABORTED)
+		{
+			return;
+		}
+	}
+
+	if(m_Sixup)
+	{
+		char aSixupPath[IO_MAX_PATH_LENGTH];
+		str_format(aSixupPath, sizeof(aSixupPath), "maps7/%s.map", m_aMapName);
+		if(m_pStorage->ReadFile(aSixupPath, IStorage::TYPE_ALL, &pData, &m_aSize[MAP_TYPE_SIXUP]))
+		{
+			m_apData[MAP_TYPE_SIXUP] = static_cast<unsigned char *>(pData);
+			m_Sha256Sixup = sha256(m_apData[MAP_TYPE_SIXUP], m_aSize[MAP_TYPE_SIXUP]);
+			m_CrcSixup = crc32(0, m_apData[MAP_TYPE_SIXUP], m_aSize[MAP_TYPE_SIXUP]);
+		}
+	}
+
+	m_PrepareTime = time_get_nanoseconds() - StartTime;
+	m_Success = true;
+}
+
+std::vector<int> CServer::CPrepareMapJob::GameDataIndices(IMap *pMap)
+{
+	// the data read by CLayers, CCollision and the map settings
+	std::vector<int> vIndices;
+	int LayersStart, LayersNum;
+	pMap->GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+	for(int i = 0; i < LayersNum; i++)
+	{
+		const CMapItemLayer *pLayer = static_cast<CMapItemLayer *>(pMap->GetItem(LayersStart + i));
+		if(pLayer->m_Type != LAYERTYPE_TILES)
+		{
+			continue;
+		}
+		const CMapItemLayerTilemap *pTilemap = reinterpret_cast<const CMapItemLayerTilemap *>(pLayer);
+		vIndices.push_back(pTilemap->m_Data);
+
+		// old versions store the indices of the DDRace data at other offsets, see CLayers::Init
+		const int *pOldIndices = reinterpret_cast<const int *>(pTilemap) + 15;
+		const int aFlags[] = {TILESLAYERFLAG_TELE, TILESLAYERFLAG_SPEEDUP, TILESLAYERFLAG_FRONT, TILESLAYERFLAG_SWITCH, TILESLAYERFLAG_TUNE};
+		const int aIndices[] = {pTilemap->m_Tele, pTilemap->m_Speedup, pTilemap->m_Front, pTilemap->m_Switch, pTilemap->m_Tune};
+		for(int Type = 0; Type < (int)std::size(aFlags); Type++)
+		{
+			if(pTilemap->m_Flags & aFlags[Type])
+			{
+				vIndices.push_back(pTilemap->m_Version <= 2 ? pOldIndices[Type] : aIndices[Type]);
+			}
+		}
+	}
+
+	int InfoStart, InfoNum;
+	pMap->GetType(MAPITEMTYPE_INFO, &InfoStart, &InfoNum);
+	for(int i = InfoStart; i < InfoStart + InfoNum; i++)
+	{
+		int ItemId;
+		const CMapItemInfoSettings *pItem = static_cast<CMapItemInfoSettings *>(pMap->GetItem(i, nullptr, &ItemId));
+		if(pItem && ItemId == 0 && pMap->GetItemSize(i) >= (int)sizeof(CMapItemInfoSettings) && pItem->m_Settings > -1)
+		{
+			vIndices.push_back(pItem->m_Settings);
+		}
+	}
+
+	std::sort(vIndices.begin(), vIndices.end());
+	vIndices.erase(std::unique(vIndices.begin(), vIndices.end()), vIndices.end());
+	vIndices.erase(std::remove_if(vIndices.begin(), vIndices.end(), [&](int Index) { return Index < 0 || Index >= pMap->NumData(); }), vIndices.end());
+	return vIndices;
+}
+
+void CServer::PrepareMap(const char *pMap)
+{
+	if(!Config()->m_SvPrepareMaps || str_comp(pMap, m_aCurrentMap) == 0)
+	{
+		return;
+	}
+	if(m_pPrepareMapJob && str_comp(m_pPrepareMapJob->m_aMapName, pMap) == 0)
+	{
+		return;
+	}
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "maps/%s.map", pMap);
+	if(!str_valid_filename(fs_filename(aPath)))
+	{
+		return;
+	}
+
+	// only one map is prepared at a time, the previous one is dropped
+	if(m_pPrepareMapJob)
+	{
+		m_pPrepareMapJob->Abort();
+	}
+	m_pPrepareMapJob = std::make_shared<CPrepareMapJob>(Storage(), pMap, Config()->m_SvSixup);
+	Engine()->AddJob(m_pPrepareMapJob);
+}
+
+void CServer::CancelPrepareMap()
+{
+	if(m_pPrepareMapJob)
+	{
+		m_pPrepareMapJob->Abort();
+		m_pPrepareMapJob = nullptr;
+	}
+}
+
+std::shared_ptr<CServer::CPrepareMapJob> CServer::TakePreparedMap(std::shared_ptr<CPrepareMapJob> pJob, const char *pMapName, const char *pPath, bool Sixup)
+{
+	if(!pJob)
+	{
+		return nullptr;
+	}
+
+	// The path differs if the map settings were imported into a temporary map.
+	// A job that has not started yet would take as long as loading the map now.
+	if(str_comp(pJob->m_aMapName, pMapName) != 0 || str_comp(pJob->m_aPath, pPath) != 0 ||
+		pJob->m_Sixup != Sixup || pJob->State() == IJob::STATE_QUEUED)
+	{
+		pJob->Abort();
+		return nullptr;
+	}
+
+	// the rest of a running job is still faster than loading the map from scratch
+	while(!pJob->Done())
+	{
+		std::this_thread::sleep_for(1ms);
+	}
+	if(pJob->State() != IJob::STATE_DONE || !pJob->m_Success)
+	{
+		return nullptr;
+	}
+
+	time_t Created, Modified;
+	if(fs_file_time(pJob->m_aFullPath, &Created, &Modified) != 0 || Modified != pJob->m_Modified)
+	{
+		log_info("server", "map '%s' changed since it was prepared, loading it again", pMapName);
+		return nullptr;
+	}
+	return pJob;
+}
+
 int CServer::LoadMap(const char *pMapName)
 {
 	m_MapReload = false;
 	m_SameMapReload = false;
+	const std::chrono::nanoseconds StartTime = time_get_nanoseconds();
 
 	char aBuf[IO_MAX_PATH_LENGTH];
 	str_format(aBuf, sizeof(aBuf), "maps/%s.map", pMapName);
@@ -2892,7 +3222,12 @@ int CServer::LoadMap(const char *pMapName)
 	{
 		return 0;
 	}
-	if(!m_pMap->Load(aBuf, IStorage::TYPE_ALL))
+	std::shared_ptr<CPrepareMapJob> pPrepared = TakePreparedMap(std::move(m_pPrepareMapJob), pMapName, aBuf, Config()->m_SvSixup);
+	if(pPrepared)
+	{
+		m_pMap->Replace(pPrepared->m_pMap.get());
+	}
+	else if(!m_pMap->Load(aBuf, IStorage::TYPE_ALL))
 	{
 		return 0;
 	}
@@ -2915,9 +3250,18 @@ int CServer::LoadMap(const char *pMapName)
 	// load complete map into memory for download
 	{
 		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
-		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
+		if(pPrepared)
+		{
+			m_apCurrentMapData[MAP_TYPE_SIX] = pPrepared->m_apData[MAP_TYPE_SIX];
+			m_aCurrentMapSize[MAP_TYPE_SIX] = pPrepared->m_aSize[MAP_TYPE_SIX];
+			pPrepared->m_apData[MAP_TYPE_SIX] = nullptr;
+		}
+		else
+		{
+			void *pData;
+			Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
+			m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
+		}
 	}
 
 	if(Config()->m_SvMapsBaseUrl[0])
@@ -2937,7 +3281,19 @@ int CServer::LoadMap(const char *pMapName)
 	{
 		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pMapName);
 		void *pData;
-		if(!Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIXUP]))
+		bool Loaded;
+		if(pPrepared)
+		{
+			pData = pPrepared->m_apData[MAP_TYPE_SIXUP];
+			m_aCurrentMapSize[MAP_TYPE_SIXUP] = pPrepared->m_aSize[MAP_TYPE_SIXUP];
+			pPrepared->m_apData[MAP_TYPE_SIXUP] = nullptr;
+			Loaded = pData != nullptr;
+		}
+		else
+		{
+			Loaded = Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+		}
+		if(!Loaded)
 		{
 			Config()->m_SvSixup = 0;
 			if(m_pRegister)
@@ -2952,8 +3308,16 @@ int CServer::LoadMap(const char *pMapName)
 			free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
 			m_apCurrentMapData[MAP_TYPE_SIXUP] = (unsigned char *)pData;
 
-			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = sha256(m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
-			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = crc32(0, m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+			if(pPrepared)
+			{
+				m_aCurrentMapSha256[MAP_TYPE_SIXUP] = pPrepared->m_Sha256Sixup;
+				m_aCurrentMapCrc[MAP_TYPE_SIXUP] = pPrepared->m_CrcSixup;
+			}
+			else
+			{
+				m_aCurrentMapSha256[MAP_TYPE_SIXUP] = sha256(m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+				m_aCurrentMapCrc[MAP_TYPE_SIXUP] = crc32(0, m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
+			}
 			sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIXUP], aSha256, sizeof(aSha256));
 			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "sixup", aBufMsg);
@@ -2968,6 +3332,21 @@ int CServer::LoadMap(const char *pMapName)
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_aPrevStates[i] = m_aClients[i].m_State;
 
+	const std::chrono::nanoseconds LoadTime = time_get_nanoseconds() - StartTime;
+	m_NumMapChanges++;
+	m_MaxMapChangeStall = std::max(m_MaxMapChangeStall, LoadTime);
+	m_TotalMapChangeStall += LoadTime;
+	if(pPrepared)
+	{
+		m_NumPreparedMapChanges++;
+		m_TotalMapPrepareTime += pPrepared->m_PrepareTime;
+		log_info("server", "changed to prepared map '%s', prepared in %.2fms, stalled for %.2fms", pMapName, pPrepared->m_PrepareTime.count() / 1000000.0, LoadTime.count() / 1000000.0);
+	}
+	else
+	{
+		log_info("server", "loaded map '%s' in %.2fms", pMapName, LoadTime.count() / 1000000.0);
+	}
+
 	return 1;
 }
 
@@ -3101,6 +3480,9 @@ int CServer::Run()
 	if(Port == 0)
 		log_info("server", "using port %d", BindAddr.port);
 
+	if(Config()->m_SvNetThreads)
+		m_NetServer.StartIoThreads();
+
 #if defined(CONF_UPNP)
 	m_UPnP.Open(BindAddr);
 #endif
@@ -3157,6 +3539,8 @@ int CServer::Run()
 		bool PacketWaiting = false;
 
 		m_GameStartTime = time_get();
+		net_stats(&m_NetStatsLastTick);
+		m_NetStatsStart = m_NetStatsLastTick;
 
 		UpdateServerInfo(false);
 		while(m_RunServer < STOPPING)
@@ -3299,6 +3683,10 @@ int CServer::Run()
 				}
 			}
 
+			// send the snapshots and the replies to the received packets in batches
+			if(Config()->m_SvSendBatch)
+				m_NetServer.BeginSendBatch();
+
 			// snap game
 			if(NewTicks)
 			{
@@ -3383,6 +3771,16 @@ int CServer::Run()
 			if(!NonActive)
 				PumpNetwork(PacketWaiting);
 
+			m_NetServer.EndSendBatch();
+			if(NewTicks)
+			{
+				NETSTATS NetStats;
+				net_stats(&NetStats);
+				m_NumNetStatsTicks++;
+				m_MaxTickSendCalls = std::max(m_MaxTickSendCalls, NetStats.send_calls - m_NetStatsLastTick.send_calls);
+				m_NetStatsLastTick = NetStats;
+			}
+
 			NonActive = true;
 			for(const auto &Client : m_aClients)
 			{
@@ -3420,14 +3818,14 @@ int CServer::Run()
 				!m_aDemoRecorder[RECORDER_MANUAL].IsRecording() &&
 				!m_aDemoRecorder[RECORDER_AUTO].IsRecording())
 			{
-				PacketWaiting = net_socket_read_wait(m_NetServer.Socket(), 1s);
+				PacketWaiting = m_NetServer.WaitForPackets(1s);
 			}
 			else
 			{
 				set_new_tick();
 				LastTime = time_get();
 				const auto MicrosecondsToWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(TickStartTime(m_CurrentGameTick + 1) - LastTime)) + 1us;
-				PacketWaiting = MicrosecondsToWait > 0us ? net_socket_read_wait(m_NetServer.Socket(), MicrosecondsToWait) : true;
+				PacketWaiting = MicrosecondsToWait > 0us ? m_NetServer.WaitForPackets(MicrosecondsToWait) : true;
 			}
 			if(IsInterrupted())
 			{
@@ -3455,6 +3853,7 @@ int CServer::Run()
 	m_pRegister->OnShutdown();
 	m_Econ.Shutdown();
 	m_Fifo.Shutdown();
+	CancelPrepareMap();
 	Engine()->ShutdownJobs();
 
 	GameServer()->OnShutdown(nullptr);
@@ -3830,7 +4229,7 @@ void CServer::DemoRecorder_HandleAutoStart()
 		{
 			// clean up auto recorded demos
 			CFileCollection AutoDemos;
-			AutoDemos.Init(Storage(), "demos/auto/server", "", ".demo", Config()->m_SvAutoDemoMax);
+			AutoDemos.Init(Storage(), "demos/auto/server", "", ".demo", Config()->m_SvAutoDemoMax, CDemoIndex::Remove);
 		}
 	}
 }
@@ -4010,6 +4409,48 @@ void CServer::ConForceHighBandwidthOnSpectate(IConsole::IResult *pResult, void *
 	}
 }
 
+void CServer::ConSnapshotStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const auto Ms = [](std::chrono::nanoseconds Time) { return Time.count() / 1000000.0; };
+	const double Average = pThis->m_NumSnapshotTicks > 0 ? Ms(pThis->m_TotalSnapshotTime) / pThis->m_NumSnapshotTicks : 0.0;
+	log_info("server", "snapshots: %d ticks, last %.3fms, avg %.3fms, max %.3fms, %d threads",
+		pThis->m_NumSnapshotTicks, Ms(pThis->m_LastSnapshotTime), Average, Ms(pThis->m_MaxSnapshotTime), pThis->m_SnapshotWorkers.NumThreads());
+	pThis->m_NumSnapshotTicks = 0;
+	pThis->m_MaxSnapshotTime = std::chrono::nanoseconds(0);
+	pThis->m_TotalSnapshotTime = std::chrono::nanoseconds(0);
+}
+
+void CServer::ConNetSendStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const double Ticks = std::max(pThis->m_NumNetStatsTicks, 1);
+	const NETSTATS &Start = pThis->m_NetStatsStart;
+	const NETSTATS &End = pThis->m_NetStatsLastTick;
+	log_info("server", "network: %d ticks, %.1f packets/tick, %.1f send calls/tick (max %d), %.1f recv calls/tick, %d send errors, batching %s, network threads %s",
+		pThis->m_NumNetStatsTicks, (End.sent_packets - Start.sent_packets) / Ticks, (End.send_calls - Start.send_calls) / Ticks, (int)pThis->m_MaxTickSendCalls,
+		(End.recv_calls - Start.recv_calls) / Ticks, (int)(End.send_errors - Start.send_errors), pThis->Config()->m_SvSendBatch ? "on" : "off",
+		pThis->m_NetServer.HasIoThreads() ? "on" : "off");
+	pThis->m_NumNetStatsTicks = 0;
+	pThis->m_MaxTickSendCalls = 0;
+	pThis->m_NetStatsStart = End;
+}
+
+void CServer::ConMapChangeStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const auto Ms = [](std::chrono::nanoseconds Time) { return Time.count() / 1000000.0; };
+	const double AverageStall = pThis->m_NumMapChanges > 0 ? Ms(pThis->m_TotalMapChangeStall) / pThis->m_NumMapChanges : 0.0;
+	const double AveragePrepare = pThis->m_NumPreparedMapChanges > 0 ? Ms(pThis->m_TotalMapPrepareTime) / pThis->m_NumPreparedMapChanges : 0.0;
+	log_info("server", "map changes: %d, %d prepared, stall avg %.2fms, max %.2fms, prepare avg %.2fms",
+		pThis->m_NumMapChanges, pThis->m_NumPreparedMapChanges, AverageStall, Ms(pThis->m_MaxMapChangeStall), AveragePrepare);
+	pThis->m_NumMapChanges = 0;
+	pThis->m_NumPreparedMapChanges = 0;
+	pThis->m_MaxMapChangeStall = std::chrono::nanoseconds(0);
+	pThis->m_TotalMapChangeStall = std::chrono::nanoseconds(0);
+	pThis->m_TotalMapPrepareTime = std::chrono::nanoseconds(0);
+}
+
 void CServer::ConAddSqlServer(IConsole::IResult *pResult, void *pUserData)
 {
 	CServer *pSelf = (CServer *)pUserData;
@@ -4368,6 +4809,9 @@ void CServer::RegisterCommands()
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
 	Console()->Register("hide_auth_status", "?i[hide]", CFGFLAG_SERVER, ConHideAuthStatus, this, "Opt out of spectator count and hide auth status to non-authed players (1 = hidden, 0 = shown)");
 	Console()->Register("force_high_bandwidth_on_spectate", "?i[enable]", CFGFLAG_SERVER, ConForceHighBandwidthOnSpectate, this, "Force high bandwidth mode when spectating (1 = on, 0 = off)");
+	Console()->Register("snapshot_stats", "", CFGFLAG_SERVER, ConSnapshotStats, this, "Show the time spent creating snapshots per tick since the last call");
+	Console()->Register("net_send_stats", "", CFGFLAG_SERVER, ConNetSendStats, this, "Show the packets and system calls of the network per tick since the last call");
+	Console()->Register("map_change_stats", "", CFGFLAG_SERVER, ConMapChangeStats, this, "Show how long map changes stalled the server and how long their maps were prepared since the last call");
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
@@ -4435,12 +4879,74 @@ void CServer::SnapFreeId(int Id)
 void *CServer::SnapNewItem(int Type, int Id, int Size)
 {
 	dbg_assert(Id >= -1 && Id <= 0xffff, "Invalid snap item Id: %d", Id);
-	return Id < 0 ? nullptr : m_SnapshotBuilder.NewItem(Type, Id, Size);
+	void *pItem = Id < 0 ? nullptr : m_SnapshotBuilder.NewItem(Type, Id, Size);
+	if(m_SnapCacheRecording)
+	{
+		// don't cache items that didn't fit, the next snapshot might have room
+		if(pItem)
+			m_vSnapCacheItems.push_back({Type, Id, Size, pItem, -1});
+		else
+			m_SnapCacheFailed = true;
+	}
+	return pItem;
+}
+
+bool CServer::SnapCacheAdd(const void *pKey, int Variant)
+{
+	if(!Config()->m_SvSnapCache)
+		return false;
+	auto It = m_SnapCache.find({pKey, Variant});
+	if(It == m_SnapCache.end())
+		return false;
+	for(int i = It->second.m_FirstItem; i < It->second.m_FirstItem + It->second.m_NumItems; i++)
+	{
+		const CSnapCacheItem &Item = m_vSnapCacheItems[i];
+		void *pItem = m_SnapshotBuilder.NewItem(Item.m_Type, Item.m_Id, Item.m_Size);
+		if(!pItem)
+			break;
+		mem_copy(pItem, &m_vSnapCacheData[Item.m_DataOffset], Item.m_Size);
+	}
+	return true;
+}
+
+void CServer::SnapCacheBegin()
+{
+	dbg_assert(!m_SnapCacheRecording, "Snap cache items are already being recorded");
+	if(!Config()->m_SvSnapCache)
+		return;
+	m_SnapCacheRecording = true;
+	m_SnapCacheFailed = false;
+	m_SnapCacheRecordFirstItem = m_vSnapCacheItems.size();
+}
+
+void CServer::SnapCacheEnd(const void *pKey, int Variant)
+{
+	if(!m_SnapCacheRecording)
+		return;
+	m_SnapCacheRecording = false;
+	if(m_SnapCacheFailed)
+	{
+		m_vSnapCacheItems.resize(m_SnapCacheRecordFirstItem);
+		return;
+	}
+
+	// the items are complete now, copy them out of the snapshot builder
+	for(size_t i = m_SnapCacheRecordFirstItem; i < m_vSnapCacheItems.size(); i++)
+	{
+		CSnapCacheItem &Item = m_vSnapCacheItems[i];
+		Item.m_DataOffset = m_vSnapCacheData.size();
+		const char *pData = static_cast<const char *>(Item.m_pRecordedData);
+		m_vSnapCacheData.insert(m_vSnapCacheData.end(), pData, pData + Item.m_Size);
+		Item.m_pRecordedData = nullptr;
+	}
+	m_SnapCache[{pKey, Variant}] = {m_SnapCacheRecordFirstItem, (int)m_vSnapCacheItems.size() - m_SnapCacheRecordFirstItem};
 }
 
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	for(CSnapshotDelta &ClientSnapshotDelta : m_aClientSnapshotDelta)
+		ClientSnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
 CServer *CreateServer() { return new CServer(); }
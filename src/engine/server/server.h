@@ -16,14 +16,18 @@
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
 #include <engine/shared/http.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
 #include <engine/shared/uuid_manager.h>
+#include <engine/shared/worker_group.h>
 
+#include <chrono>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #if defined(CONF_UPNP)
@@ -37,6 +41,7 @@ class CMsgPacker;
 class CPacker;
 class IEngine;
 class IEngineMap;
+class IMap;
 class ILogger;
 
 class CServerBan : public CNetBan
@@ -214,6 +219,76 @@ public:
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
+
+	// Deltas for clients are created in parallel, they can't share m_SnapshotDelta
+	// because its static sizes are changed per client. Indexed by CClient::m_Sixup
+	CSnapshotDelta m_aClientSnapshotDelta[2];
+	CWorkerGroup m_SnapshotWorkers;
+
+	// Snapshot of one client being delta compressed
+	class CSnapshotJob
+	{
+	public:
+		int m_ClientId;
+		int m_DeltaTick;
+		const CSnapshot *m_pSnapshot;
+		const CSnapshot *m_pDeltashot;
+
+		int m_Crc;
+		bool m_Empty;
+		int m_CompSize;
+		char m_aCompData[CSnapshot::MAX_SIZE];
+	};
+	std::vector<CSnapshotJob> m_vSnapshotJobs;
+	static void CompressSnapshot(void *pUser, int Index);
+
+	// Snap items cached for the current tick, see IServer::SnapCacheAdd
+	class CSnapCacheItem
+	{
+	public:
+		int m_Type;
+		int m_Id;
+		int m_Size;
+		// Into the snapshot builder while recording, into m_vSnapCacheData afterwards
+		const void *m_pRecordedData;
+		int m_DataOffset;
+	};
+	class CSnapCacheKey
+	{
+	public:
+		const void *m_pKey;
+		int m_Variant;
+		bool operator==(const CSnapCacheKey &Other) const = default;
+	};
+	class CSnapCacheKeyHash
+	{
+	public:
+		size_t operator()(const CSnapCacheKey &Key) const { return std::hash<const void *>()(Key.m_pKey) ^ (size_t)Key.m_Variant * 0x9e3779b97f4a7c15ULL; }
+	};
+	class CSnapCacheEntry
+	{
+	public:
+		int m_FirstItem;
+		int m_NumItems;
+	};
+	std::unordered_map<CSnapCacheKey, CSnapCacheEntry, CSnapCacheKeyHash> m_SnapCache;
+	std::vector<CSnapCacheItem> m_vSnapCacheItems;
+	std::vector<char> m_vSnapCacheData;
+	bool m_SnapCacheRecording = false;
+	bool m_SnapCacheFailed = false;
+	int m_SnapCacheRecordFirstItem = 0;
+
+	// Time spent in DoSnapshot since the last snapshot_stats
+	int m_NumSnapshotTicks = 0;
+	std::chrono::nanoseconds m_LastSnapshotTime{0};
+	std::chrono::nanoseconds m_MaxSnapshotTime{0};
+	std::chrono::nanoseconds m_TotalSnapshotTime{0};
+
+	// Packets and send calls per tick since the last net_send_stats
+	int m_NumNetStatsTicks = 0;
+	uint64_t m_MaxTickSendCalls = 0;
+	NETSTATS m_NetStatsStart = {};
+	NETSTATS m_NetStatsLastTick = {};
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -265,6 +340,49 @@ public:
 	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
 	char m_aMapDownloadUrl[256];
 
+	// Loads a map, its hashes and the data to send to clients in the background
+	class CPrepareMapJob : public IJob
+	{
+		class IStorage *m_pStorage;
+
+		void Run() override;
+
+	public:
+		CPrepareMapJob(class IStorage *pStorage, const char *pMapName, bool Sixup);
+		~CPrepareMapJob() override;
+
+		// The data indices of the tilemaps and map settings, the data the game reads
+		static std::vector<int> GameDataIndices(IMap *pMap);
+
+		char m_aMapName[IO_MAX_PATH_LENGTH];
+		char m_aPath[IO_MAX_PATH_LENGTH];
+		char m_aFullPath[IO_MAX_PATH_LENGTH];
+		bool m_Sixup;
+
+		bool m_Success = false;
+		time_t m_Modified = 0;
+		std::unique_ptr<IEngineMap> m_pMap;
+		unsigned char *m_apData[NUM_MAP_TYPES] = {nullptr, nullptr};
+		unsigned m_aSize[NUM_MAP_TYPES] = {0, 0};
+		SHA256_DIGEST m_Sha256Sixup;
+		unsigned m_CrcSixup = 0;
+		std::chrono::nanoseconds m_PrepareTime{0};
+	};
+	std::shared_ptr<CPrepareMapJob> m_pPrepareMapJob;
+	/**
+	 * Returns the job if it prepared the map at `pPath`, waiting for it if it is still running.
+	 * Returns `nullptr` if it prepared another map, was not started yet, failed or the map
+	 * file changed since it was read. Jobs that are not waited for are aborted.
+	 */
+	static std::shared_ptr<CPrepareMapJob> TakePreparedMap(std::shared_ptr<CPrepareMapJob> pJob, const char *pMapName, const char *pPath, bool Sixup);
+
+	// Map changes since the last map_change_stats
+	int m_NumMapChanges = 0;
+	int m_NumPreparedMapChanges = 0;
+	std::chrono::nanoseconds m_MaxMapChangeStall{0};
+	std::chrono::nanoseconds m_TotalMapChangeStall{0};
+	std::chrono::nanoseconds m_TotalMapPrepareTime{0};
+
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 	CAuthManager m_AuthManager;
 
@@ -386,14 +504,20 @@ public:
 			CCacheChunk(CCacheChunk &&) = default;
 
 			std::vector<uint8_t> m_vData;
+			// the clients before this one are in this chunk or the ones before it
+			int m_EndClient = MAX_CLIENTS;
+			// number of clients in the chunks before this one
+			int m_ClientsBefore = 0;
 		};
 
 		std::vector<CCacheChunk> m_vCache;
+		// the header the chunks were built with
+		std::vector<uint8_t> m_vPrefix;
 
 		CCache();
 		~CCache();
 
-		void AddChunk(const void *pData, int Size);
+		void AddChunk(const void *pData, int Size, int EndClient = MAX_CLIENTS, int ClientsBefore = 0);
 		void Clear();
 	};
 	CCache m_aServerInfoCache[3 * 2];
@@ -401,11 +525,26 @@ public:
 	bool m_ServerInfoNeedsUpdate = false;
 	bool m_ServerInfoNeedsResend = false;
 
+	// the encoded server info entry of each client
+	class CServerInfoClient
+	{
+	public:
+		bool m_Included = false;
+		bool m_Player = false;
+		std::vector<uint8_t> m_vEntry;
+		std::vector<uint8_t> m_vEntrySixup;
+	};
+	CServerInfoClient m_aServerInfoClients[MAX_CLIENTS];
+
 	void FillAntibot(CAntibotRoundData *pData) override;
 
 	void ExpireServerInfo() override;
 	void ExpireServerInfoAndQueueResend();
-	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
+	// re-encodes the entries of the clients, returns the first client whose entry changed
+	int UpdateServerInfoClients();
+	void CacheServerInfo(CCache *pCache, int Type, bool SendClients, int FirstChanged);
+	// rebuilds the chunks of the clients from FirstChanged on, the ones before only get the new header
+	static void CacheServerInfoChunks(CCache *pCache, const CServerInfoClient *pClients, int Type, bool SendClients, const void *pHeader, int HeaderSize, int FirstChanged);
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients, int MaxConsideredClients);
 	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
 	void GetServerInfoSixup(CPacker *pPacker, bool SendClients);
@@ -419,6 +558,8 @@ public:
 	void ChangeMap(const char *pMap) override;
 	const char *GetMapName() const override;
 	void ReloadMap() override;
+	void PrepareMap(const char *pMap) override;
+	void CancelPrepareMap() override;
 	int LoadMap(const char *pMapName);
 
 	void SaveDemo(int ClientId, float Time) override;
@@ -439,6 +580,9 @@ public:
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
 	static void ConHideAuthStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConForceHighBandwidthOnSpectate(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapshotStats(IConsole::IResult *pResult, void *pUser);
+	static void ConNetSendStats(IConsole::IResult *pResult, void *pUser);
+	static void ConMapChangeStats(IConsole::IResult *pResult, void *pUser);
 
 	static void ConAuthAdd(IConsole::IResult *pResult, void *pUser);
 	static void ConAuthAddHashed(IConsole::IResult *pResult, void *pUser);
@@ -483,6 +627,9 @@ public:
 	void SnapFreeId(int Id) override;
 	void *SnapNewItem(int Type, int Id, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
+	bool SnapCacheAdd(const void *pKey, int Variant) override;
+	void SnapCacheBegin() override;
+	void SnapCacheEnd(const void *pKey, int Variant) override;
 
 	// DDRace
 
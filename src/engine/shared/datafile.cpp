@@ -4,6 +4,7 @@
 #include "datafile.h"
 
 #include "uuid_manager.h"
+#include "worker_group.h"
 
 #include <base/hash_ctxt.h>
 #include <base/log.h>
@@ -14,14 +15,22 @@
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <limits>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
 static constexpr int MAX_ITEM_ID = 0xFFFF;
 static constexpr int OFFSET_UUID_TYPE = 0x8000;
 
+static constexpr int MAX_COMPRESSION_THREADS = 8;
+static constexpr int64_t MIN_PARALLEL_COMPRESSION_SIZE = 256 * 1024;
+
 static inline void SwapEndianInPlace(void *pObj, size_t Size)
 {
 #if defined(CONF_ARCH_ENDIAN_BIG)
@@ -129,6 +138,8 @@ class CDatafile
 {
 public:
 	IOHANDLE m_File;
+	char *m_pMapping; // whole file when it is mapped, nullptr otherwise
+	class CDatafilePrefetch *m_pPrefetch;
 	unsigned m_FileSize;
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
@@ -179,6 +190,20 @@ public:
 		return Size;
 	}
 
+	bool IsMapped(const void *pData) const
+	{
+		return m_pMapping != nullptr && pData >= m_pMapping && pData < m_pMapping + m_FileSize;
+	}
+
+	void FreeData(int Index) const
+	{
+		if(!IsMapped(m_ppDataPtrs[Index]))
+		{
+			free(m_ppDataPtrs[Index]);
+		}
+		m_ppDataPtrs[Index] = nullptr;
+	}
+
 	void *GetData(int Index, bool Swap) const
 	{
 		// Invalid data indices may appear in map items
@@ -213,41 +238,55 @@ public:
 				return nullptr;
 			}
 
-			// read the compressed data
-			void *pCompressedData = malloc(DataSize);
-			if(pCompressedData == nullptr)
+			// read the compressed data, a mapped file is decompressed in place
+			void *pCompressedData;
+			if(m_pMapping != nullptr)
 			{
-				log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
-			}
-			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
-			{
-				ActualDataSize = io_read(m_File, pCompressedData, DataSize);
+				pCompressedData = m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index];
 			}
-			if(DataSize != ActualDataSize)
+			else
 			{
-				log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
-				free(pCompressedData);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
+				pCompressedData = malloc(DataSize);
+				if(pCompressedData == nullptr)
+				{
+					log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				unsigned ActualDataSize = 0;
+				if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+				{
+					ActualDataSize = io_read(m_File, pCompressedData, DataSize);
+				}
+				if(DataSize != ActualDataSize)
+				{
+					log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
+					free(pCompressedData);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
 			}
+			const auto &FreeCompressedData = [&]() {
+				if(m_pMapping == nullptr)
+				{
+					free(pCompressedData);
+				}
+			};
 
 			// decompress the data
 			m_ppDataPtrs[Index] = static_cast<char *>(malloc(OriginalUncompressedSize));
 			if(m_ppDataPtrs[Index] == nullptr)
 			{
-				free(pCompressedData);
+				FreeCompressedData();
 				log_error("datafile", "out of memory. could not allocate memory for uncompressed data. index=%d size=%d", Index, OriginalUncompressedSize);
 				m_pDataSizes[Index] = -1;
 				return nullptr;
 			}
 			unsigned long UncompressedSize = OriginalUncompressedSize;
 			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, static_cast<Bytef *>(pCompressedData), DataSize);
-			free(pCompressedData);
+			FreeCompressedData();
 			if(Result != Z_OK || UncompressedSize != OriginalUncompressedSize)
 			{
 				log_error("datafile", "failed to uncompress data. index=%d result=%d wanted=%d got=%ld", Index, Result, OriginalUncompressedSize, UncompressedSize);
@@ -261,6 +300,15 @@ public:
 		else
 		{
 			log_trace("datafile", "loading data. index=%d size=%d", Index, DataSize);
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+			// uncompressed data of a mapped file is used in place, it never needs swapping here
+			if(m_pMapping != nullptr)
+			{
+				m_ppDataPtrs[Index] = m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index];
+				m_pDataSizes[Index] = DataSize;
+				return m_ppDataPtrs[Index];
+			}
+#endif
 			m_ppDataPtrs[Index] = malloc(DataSize);
 			if(m_ppDataPtrs[Index] == nullptr)
 			{
@@ -430,6 +478,83 @@ public:
 	}
 };
 
+// Decompresses the data of a mapped file on a background thread, while the
+// owner of the reader uses the data that is already loaded or loads it itself.
+class CDatafilePrefetch
+{
+public:
+	std::mutex m_Mutex;
+	std::condition_variable m_LoadedCond;
+	std::vector<bool> m_vLoading; // data currently being loaded by either thread
+	std::vector<bool> m_vRequested; // data the owner used, which is not touched by the prefetch thread anymore
+	std::atomic<bool> m_Stop = false;
+	std::thread m_Thread;
+
+	CDatafilePrefetch(CDatafile *pDataFile) :
+		m_vLoading(pDataFile->m_Header.m_NumRawData, false),
+		m_vRequested(pDataFile->m_Header.m_NumRawData, false)
+	{
+		m_Thread = std::thread([this, pDataFile]() { Run(pDataFile); });
+	}
+
+	~CDatafilePrefetch()
+	{
+		m_Stop.store(true);
+		m_Thread.join();
+	}
+
+	// Waits until the data is not being loaded, the returned lock must be held while accessing it.
+	std::unique_lock<std::mutex> Acquire(int Index, bool Request)
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_LoadedCond.wait(Lock, [&]() { return !m_vLoading[Index]; });
+		if(Request)
+		{
+			m_vRequested[Index] = true;
+		}
+		return Lock;
+	}
+
+	void *GetData(CDatafile *pDataFile, int Index, bool Swap)
+	{
+		std::unique_lock<std::mutex> Lock = Acquire(Index, true);
+		if(pDataFile->m_ppDataPtrs[Index] != nullptr || pDataFile->m_pDataSizes[Index] < 0)
+		{
+			return pDataFile->m_ppDataPtrs[Index];
+		}
+
+		// load it without holding the lock, so the prefetch thread can continue with other data
+		m_vLoading[Index] = true;
+		Lock.unlock();
+		void *pData = pDataFile->GetData(Index, Swap);
+		Lock.lock();
+		m_vLoading[Index] = false;
+		m_LoadedCond.notify_all();
+		return pData;
+	}
+
+	void Run(CDatafile *pDataFile)
+	{
+		for(int Index = 0; Index < pDataFile->m_Header.m_NumRawData && !m_Stop.load(std::memory_order_relaxed); Index++)
+		{
+			{
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				if(m_vLoading[Index] || m_vRequested[Index] || pDataFile->m_ppDataPtrs[Index] != nullptr || pDataFile->m_pDataSizes[Index] < 0)
+				{
+					continue;
+				}
+				m_vLoading[Index] = true;
+			}
+			pDataFile->GetData(Index, false);
+			{
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				m_vLoading[Index] = false;
+			}
+			m_LoadedCond.notify_all();
+		}
+	}
+};
+
 CDataFileReader::~CDataFileReader()
 {
 	Close();
@@ -442,7 +567,7 @@ CDataFileReader &CDataFileReader::operator=(CDataFileReader &&Other)
 	return *this;
 }
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, int Flags)
 {
 	dbg_assert(m_pDataFile == nullptr, "File already open");
 
@@ -455,37 +580,81 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
-	// determine size and hashes of the file and store them
+	// map the file if requested, falling back to reading it
 	int64_t FileSize = 0;
+	char *pMapping = nullptr;
+	if(Flags & OPEN_MAPPED)
+	{
+		FileSize = io_length(File);
+		if(FileSize > 0 && FileSize <= std::numeric_limits<int>::max())
+		{
+			pMapping = static_cast<char *>(io_map(File, FileSize));
+		}
+		if(pMapping == nullptr)
+		{
+			log_warn("datafile", "could not map file, reading it instead. size=%" PRId64, FileSize);
+			FileSize = 0;
+		}
+	}
+	const auto &CloseFile = [&]() {
+		if(pMapping != nullptr)
+		{
+			io_unmap(pMapping, FileSize);
+		}
+		io_close(File);
+	};
+
+	// determine size and hashes of the file and store them
 	unsigned Crc = 0;
 	SHA256_DIGEST Sha256;
 	{
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[64 * 1024];
-		while(true)
+		if(pMapping != nullptr)
 		{
-			const unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
-			if(Bytes == 0)
-				break;
-			FileSize += Bytes;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			Crc = crc32(Crc, reinterpret_cast<Bytef *>(pMapping), FileSize);
+			sha256_update(&Sha256Ctxt, pMapping, FileSize);
 		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
-		if(io_seek(File, 0, IOSEEK_START) != 0)
+		else
 		{
-			io_close(File);
-			log_error("datafile", "could not seek to start after calculating hashes");
-			return false;
+			unsigned char aBuffer[64 * 1024];
+			while(true)
+			{
+				const unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
+				if(Bytes == 0)
+					break;
+				FileSize += Bytes;
+				Crc = crc32(Crc, aBuffer, Bytes);
+				sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			}
+			if(io_seek(File, 0, IOSEEK_START) != 0)
+			{
+				CloseFile();
+				log_error("datafile", "could not seek to start after calculating hashes");
+				return false;
+			}
 		}
+		Sha256 = sha256_finish(&Sha256Ctxt);
 	}
 
 	// read header
 	CDatafileHeader Header;
-	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+	bool HeaderRead;
+	if(pMapping != nullptr)
 	{
-		io_close(File);
+		HeaderRead = FileSize >= (int64_t)sizeof(Header);
+		if(HeaderRead)
+		{
+			mem_copy(&Header, pMapping, sizeof(Header));
+		}
+	}
+	else
+	{
+		HeaderRead = io_read(File, &Header, sizeof(Header)) == sizeof(Header);
+	}
+	if(!HeaderRead)
+	{
+		CloseFile();
 		log_error("datafile", "could not read file header. file truncated or not a datafile.");
 		return false;
 	}
@@ -494,7 +663,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if((Header.m_aId[0] != 'A' || Header.m_aId[1] != 'T' || Header.m_aId[2] != 'A' || Header.m_aId[3] != 'D') &&
 		(Header.m_aId[0] != 'D' || Header.m_aId[1] != 'A' || Header.m_aId[2] != 'T' || Header.m_aId[3] != 'A'))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "wrong header magic. magic=%x%x%x%x", Header.m_aId[0], Header.m_aId[1], Header.m_aId[2], Header.m_aId[3]);
 		return false;
 	}
@@ -504,7 +673,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	// check header version
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "unsupported header version. version=%d", Header.m_Version);
 		return false;
 	}
@@ -518,7 +687,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Header.m_ItemSize % sizeof(int) != 0 ||
 		Header.m_DataSize < 0)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header information. num_types=%d num_items=%d num_data=%d item_size=%d data_size=%d",
 			Header.m_NumItemTypes, Header.m_NumItems, Header.m_NumRawData, Header.m_ItemSize, Header.m_DataSize);
 		return false;
@@ -544,7 +713,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if((int64_t)sizeof(Header) + Size + (int64_t)Header.m_DataSize != FileSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header data size or truncated file. data_size=%d file_size=%" PRId64, Header.m_DataSize, FileSize);
 		return false;
 	}
@@ -559,7 +728,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header size or truncated file. size=%" PRId64 " actual=%" PRId64, HeaderFileSize, FileSize);
 			return false;
 		}
@@ -576,20 +745,20 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header swaplen or truncated file. swaplen=%" PRId64 " actual=%" PRId64, HeaderSwaplen, FileSizeSwaplen);
 			return false;
 		}
 	}
 
 	constexpr int64_t MaxAllocSize = (int64_t)2 * 1024 * 1024 * 1024;
-	int64_t AllocSize = Size;
+	int64_t AllocSize = pMapping != nullptr ? 0 : Size; // the tables of a mapped file are used in place
 	AllocSize += sizeof(CDatafile); // add space for info structure
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(void *); // add space for data pointers
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(int); // add space for data sizes
 	if(AllocSize > MaxAllocSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "file too large. alloc_size=%" PRId64 " max=%" PRId64, AllocSize, MaxAllocSize);
 		return false;
 	}
@@ -597,7 +766,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	CDatafile *pTmpDataFile = static_cast<CDatafile *>(malloc(AllocSize));
 	if(pTmpDataFile == nullptr)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "out of memory. could not allocate memory for datafile. alloc_size=%" PRId64, AllocSize);
 		return false;
 	}
@@ -605,8 +774,10 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
 	pTmpDataFile->m_ppDataPtrs = (void **)(pTmpDataFile + 1);
 	pTmpDataFile->m_pDataSizes = (int *)(pTmpDataFile->m_ppDataPtrs + Header.m_NumRawData);
-	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
+	pTmpDataFile->m_pData = pMapping != nullptr ? pMapping + sizeof(CDatafileHeader) : (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
 	pTmpDataFile->m_File = File;
+	pTmpDataFile->m_pMapping = pMapping;
+	pTmpDataFile->m_pPrefetch = nullptr;
 	pTmpDataFile->m_FileSize = FileSize;
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
@@ -616,13 +787,16 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	mem_zero(pTmpDataFile->m_pDataSizes, Header.m_NumRawData * sizeof(int));
 
 	// read types, offsets, sizes and item data
-	const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
-	if((int64_t)ReadSize != Size)
+	if(pMapping == nullptr)
 	{
-		io_close(pTmpDataFile->m_File);
-		free(pTmpDataFile);
-		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%d", Size, ReadSize);
-		return false;
+		const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
+		if((int64_t)ReadSize != Size)
+		{
+			CloseFile();
+			free(pTmpDataFile);
+			log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%d", Size, ReadSize);
+			return false;
+		}
 	}
 
 	// The swap len also includes the size of the header (without the size offset), but the header was already swapped above.
@@ -647,12 +821,21 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if(!pTmpDataFile->Validate())
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
 		return false;
 	}
 
 	m_pDataFile = pTmpDataFile;
+
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+	// The prefetch thread does not use the file handle, which may be used by others,
+	// and loads the data unswapped, so it's only used for mapped files on little endian.
+	if((Flags & OPEN_PREFETCH) && pMapping != nullptr && Header.m_NumRawData > 0)
+	{
+		m_pDataFile->m_pPrefetch = new CDatafilePrefetch(m_pDataFile);
+	}
+#endif
 	log_trace("datafile", "loading done. datafile='%s'", pFilename);
 
 	return true;
@@ -665,11 +848,17 @@ void CDataFileReader::Close()
 		return;
 	}
 
+	delete m_pDataFile->m_pPrefetch;
+
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 	{
-		free(m_pDataFile->m_ppDataPtrs[i]);
+		m_pDataFile->FreeData(i);
 	}
 
+	if(m_pDataFile->m_pMapping != nullptr)
+	{
+		io_unmap(m_pDataFile->m_pMapping, m_pDataFile->m_FileSize);
+	}
 	io_close(m_pDataFile->m_File);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
@@ -687,10 +876,20 @@ IOHANDLE CDataFileReader::File() const
 	return m_pDataFile->m_File;
 }
 
+bool CDataFileReader::IsPrefetching(int Index) const
+{
+	return m_pDataFile->m_pPrefetch != nullptr && Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData;
+}
+
 int CDataFileReader::GetDataSize(int Index) const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 
+	if(IsPrefetching(Index))
+	{
+		const std::unique_lock<std::mutex> Lock = m_pDataFile->m_pPrefetch->Acquire(Index, false);
+		return m_pDataFile->GetDataSize(Index);
+	}
 	return m_pDataFile->GetDataSize(Index);
 }
 
@@ -698,6 +897,10 @@ void *CDataFileReader::GetData(int Index)
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 
+	if(IsPrefetching(Index))
+	{
+		return m_pDataFile->m_pPrefetch->GetData(m_pDataFile, Index, false);
+	}
 	return m_pDataFile->GetData(Index, false);
 }
 
@@ -705,6 +908,10 @@ void *CDataFileReader::GetDataSwapped(int Index)
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 
+	if(IsPrefetching(Index))
+	{
+		return m_pDataFile->m_pPrefetch->GetData(m_pDataFile, Index, true);
+	}
 	return m_pDataFile->GetData(Index, true);
 }
 
@@ -736,7 +943,12 @@ void CDataFileReader::ReplaceData(int Index, char *pData, size_t Size)
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 	dbg_assert(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData, "Index invalid: %d", Index);
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
+	std::unique_lock<std::mutex> Lock;
+	if(IsPrefetching(Index))
+	{
+		Lock = m_pDataFile->m_pPrefetch->Acquire(Index, true);
+	}
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_ppDataPtrs[Index] = pData;
 	m_pDataFile->m_pDataSizes[Index] = Size;
 }
@@ -748,8 +960,12 @@ void CDataFileReader::UnloadData(int Index)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+	std::unique_lock<std::mutex> Lock;
+	if(IsPrefetching(Index))
+	{
+		Lock = m_pDataFile->m_pPrefetch->Acquire(Index, true);
+	}
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
@@ -1104,21 +1320,41 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
+void CDataFileWriter::CompressData(void *pUser, int Index)
+{
+	CDataInfo &DataInfo = static_cast<CDataInfo *>(pUser)[Index];
+	unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
+	DataInfo.m_pCompressedData = malloc(CompressedSize);
+	const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+	DataInfo.m_CompressedSize = CompressedSize;
+	free(DataInfo.m_pUncompressedData);
+	DataInfo.m_pUncompressedData = nullptr;
+	dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+}
+
 void CDataFileWriter::Finish()
 {
 	dbg_assert((bool)m_File, "File not open");
 
 	// Compress data. This takes the majority of the time when saving a datafile,
-	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+	// so it's delayed until the end so it can be off-loaded to another thread
+	// and split over multiple. Every data is compressed into its own slot, so
+	// the output does not depend on the order in which they finish.
+	int64_t UncompressedSize = 0;
+	for(const CDataInfo &DataInfo : m_vDatas)
 	{
-		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
-		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
-		DataInfo.m_CompressedSize = CompressedSize;
-		free(DataInfo.m_pUncompressedData);
-		DataInfo.m_pUncompressedData = nullptr;
-		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+		UncompressedSize += DataInfo.m_UncompressedSize;
+	}
+	int NumThreads = m_CompressionThreads;
+	if(NumThreads < 0)
+	{
+		// starting threads is not worth it for small files
+		NumThreads = UncompressedSize < MIN_PARALLEL_COMPRESSION_SIZE ? 0 : std::clamp((int)std::thread::hardware_concurrency() - 1, 0, MAX_COMPRESSION_THREADS);
+	}
+	{
+		CWorkerGroup Workers;
+		Workers.Init(std::clamp(NumThreads, 0, maximum((int)m_vDatas.size() - 1, 0)));
+		Workers.Run(m_vDatas.size(), CompressData, m_vDatas.data());
 	}
 
 	// Calculate total size of items
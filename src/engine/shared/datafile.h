@@ -26,12 +26,29 @@ class CDataFileReader
 
 	int GetExternalItemType(int InternalType, CUuid *pUuid);
 	int GetInternalItemType(int ExternalType);
+	bool IsPrefetching(int Index) const;
 
 public:
+	enum
+	{
+		/**
+		 * Maps the file into memory instead of reading it. The header, item and offset tables
+		 * are used in place, compressed data is decompressed directly from the mapping and
+		 * uncompressed data is used without copying it. Falls back to reading the file if it
+		 * cannot be mapped.
+		 */
+		OPEN_MAPPED = 1 << 0,
+		/**
+		 * Decompresses all data on a background thread after opening, so it's ready when it is used.
+		 * Only has an effect together with @link OPEN_MAPPED @endlink.
+		 */
+		OPEN_PREFETCH = 1 << 1,
+	};
+
 	~CDataFileReader();
 	CDataFileReader &operator=(CDataFileReader &&Other);
 
-	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, int Flags = 0);
 	void Close();
 	bool IsOpen() const;
 	IOHANDLE File() const;
@@ -104,6 +121,7 @@ private:
 	};
 
 	IOHANDLE m_File;
+	int m_CompressionThreads = -1;
 	std::map<uint16_t, CItemTypeInfo, std::less<>> m_ItemTypes; // item types must be sorted in ascending order
 	std::vector<CItemInfo> m_vItems;
 	std::vector<CDataInfo> m_vDatas;
@@ -111,6 +129,7 @@ private:
 
 	int GetTypeFromIndex(int Index) const;
 	int GetExtendedItemTypeIndex(int Type, const CUuid *pUuid);
+	static void CompressData(void *pUser, int Index);
 
 public:
 	CDataFileWriter();
@@ -118,6 +137,7 @@ public:
 	{
 		m_File = Other.m_File;
 		Other.m_File = nullptr;
+		m_CompressionThreads = Other.m_CompressionThreads;
 		m_ItemTypes = std::move(Other.m_ItemTypes);
 		m_vItems = std::move(Other.m_vItems);
 		m_vDatas = std::move(Other.m_vDatas);
@@ -130,6 +150,17 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
+
+	/**
+	 * Sets the number of additional threads used to compress the data in @link Finish @endlink.
+	 *
+	 * @param NumThreads Number of additional threads, `0` compresses on the calling thread only,
+	 * `-1` picks a number based on the hardware threads (default).
+	 *
+	 * @remark The written file does not depend on the number of threads.
+	 */
+	void SetCompressionThreads(int NumThreads) { m_CompressionThreads = NumThreads; }
+
 	void Finish();
 };
 
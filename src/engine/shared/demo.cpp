@@ -40,6 +40,161 @@ bool CDemoHeader::Valid() const
 	       mem_has_null(m_aTimestamp, sizeof(m_aTimestamp)) && str_utf8_check(m_aTimestamp);
 }
 
+static const unsigned char gs_aIndexMarker[8] = {'T', 'W', 'D', 'E', 'M', 'O', 'I', 'X'};
+static const unsigned char gs_IndexVersion = 1;
+
+static void IndexWriteInt(std::vector<unsigned char> &vData, int64_t Value, int Size)
+{
+	for(int i = Size - 1; i >= 0; i--)
+		vData.push_back((Value >> (i * 8)) & 0xff);
+}
+
+static bool IndexReadInt(const unsigned char *&pData, const unsigned char *pEnd, int64_t *pValue, int Size)
+{
+	if(pEnd - pData < Size)
+		return false;
+	uint64_t Value = 0;
+	for(int i = 0; i < Size; i++)
+		Value = (Value << 8) | *pData++;
+	// sign extend
+	*pValue = Size < 8 && (Value >> (Size * 8 - 1)) ? (int64_t)(Value | (~(uint64_t)0 << (Size * 8))) : (int64_t)Value;
+	return true;
+}
+
+static bool IndexReadRaw(const unsigned char *&pData, const unsigned char *pEnd, void *pOut, int Size)
+{
+	if(pEnd - pData < Size)
+		return false;
+	mem_copy(pOut, pData, Size);
+	pData += Size;
+	return true;
+}
+
+void CDemoIndex::Filename(const char *pDemoFilename, char *pBuffer, size_t BufferSize)
+{
+	str_format(pBuffer, BufferSize, "%s.idx", pDemoFilename);
+}
+
+bool CDemoIndex::Load(IStorage *pStorage, const char *pDemoFilename, int StorageType, int64_t DemoSize, time_t DemoModified)
+{
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Filename(pDemoFilename, aFilename, sizeof(aFilename));
+	void *pFileData;
+	unsigned FileSize;
+	if(!pStorage->ReadFile(aFilename, StorageType, &pFileData, &FileSize))
+		return false;
+
+	const unsigned char *pData = (const unsigned char *)pFileData;
+	const unsigned char *pEnd = pData + FileSize;
+	const auto &Parse = [&]() {
+		unsigned char aMarker[sizeof(gs_aIndexMarker)];
+		unsigned char Version;
+		int64_t Size, Modified, HasSha256, FirstTick, LastTick, NumKeyFrames;
+		if(!IndexReadRaw(pData, pEnd, aMarker, sizeof(aMarker)) || mem_comp(aMarker, gs_aIndexMarker, sizeof(aMarker)) != 0 ||
+			!IndexReadRaw(pData, pEnd, &Version, sizeof(Version)) || Version != gs_IndexVersion ||
+			!IndexReadInt(pData, pEnd, &Size, 8) || Size != DemoSize ||
+			!IndexReadInt(pData, pEnd, &Modified, 8) || Modified != (int64_t)DemoModified ||
+			!IndexReadRaw(pData, pEnd, &m_Header, sizeof(m_Header)) || !m_Header.Valid() ||
+			!IndexReadRaw(pData, pEnd, &m_TimelineMarkers, sizeof(m_TimelineMarkers)) ||
+			!IndexReadInt(pData, pEnd, &HasSha256, 1))
+		{
+			return false;
+		}
+		m_MapSha256 = std::nullopt;
+		if(HasSha256)
+		{
+			SHA256_DIGEST Sha256;
+			if(!IndexReadRaw(pData, pEnd, &Sha256, sizeof(Sha256)))
+				return false;
+			m_MapSha256 = Sha256;
+		}
+		if(!IndexReadInt(pData, pEnd, &FirstTick, 4) ||
+			!IndexReadInt(pData, pEnd, &LastTick, 4) ||
+			!IndexReadInt(pData, pEnd, &NumKeyFrames, 4) ||
+			NumKeyFrames <= 0 || NumKeyFrames > (pEnd - pData) / 12)
+		{
+			return false;
+		}
+		m_FirstTick = FirstTick;
+		m_LastTick = LastTick;
+		m_vKeyFrames.clear();
+		m_vKeyFrames.reserve(NumKeyFrames);
+		for(int64_t i = 0; i < NumKeyFrames; i++)
+		{
+			int64_t Filepos, Tick;
+			if(!IndexReadInt(pData, pEnd, &Filepos, 8) || !IndexReadInt(pData, pEnd, &Tick, 4) ||
+				Filepos < 0 || Filepos >= DemoSize)
+			{
+				return false;
+			}
+			m_vKeyFrames.emplace_back(Filepos, Tick);
+		}
+		return pData == pEnd;
+	};
+	const bool Result = Parse();
+	free(pFileData);
+	return Result;
+}
+
+bool CDemoIndex::Save(IStorage *pStorage, const char *pDemoFilename, int64_t DemoSize) const
+{
+	time_t Created, Modified;
+	if(m_vKeyFrames.empty() || !pStorage->RetrieveTimes(pDemoFilename, IStorage::TYPE_SAVE, &Created, &Modified))
+		return false;
+
+	std::vector<unsigned char> vData(std::begin(gs_aIndexMarker), std::end(gs_aIndexMarker));
+	vData.push_back(gs_IndexVersion);
+	IndexWriteInt(vData, DemoSize, 8);
+	IndexWriteInt(vData, Modified, 8);
+	vData.insert(vData.end(), (const unsigned char *)&m_Header, (const unsigned char *)(&m_Header + 1));
+	vData.insert(vData.end(), (const unsigned char *)&m_TimelineMarkers, (const unsigned char *)(&m_TimelineMarkers + 1));
+	IndexWriteInt(vData, m_MapSha256.has_value(), 1);
+	if(m_MapSha256.has_value())
+		vData.insert(vData.end(), std::begin(m_MapSha256->data), std::end(m_MapSha256->data));
+	IndexWriteInt(vData, m_FirstTick, 4);
+	IndexWriteInt(vData, m_LastTick, 4);
+	IndexWriteInt(vData, m_vKeyFrames.size(), 4);
+	for(const CKeyFrame &KeyFrame : m_vKeyFrames)
+	{
+		IndexWriteInt(vData, KeyFrame.m_Filepos, 8);
+		IndexWriteInt(vData, KeyFrame.m_Tick, 4);
+	}
+
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Filename(pDemoFilename, aFilename, sizeof(aFilename));
+	IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+	const bool Success = io_write(File, vData.data(), vData.size()) == vData.size();
+	return io_close(File) == 0 && Success;
+}
+
+void CDemoIndex::MapInfo(CMapInfo *pMapInfo) const
+{
+	str_copy(pMapInfo->m_aName, m_Header.m_aMapName);
+	pMapInfo->m_Sha256 = m_MapSha256;
+	pMapInfo->m_Crc = bytes_be_to_uint(m_Header.m_aMapCrc);
+	pMapInfo->m_Size = bytes_be_to_uint(m_Header.m_aMapSize);
+}
+
+void CDemoIndex::Rename(IStorage *pStorage, const char *pOldDemoFilename, const char *pNewDemoFilename, int StorageType)
+{
+	char aOldFilename[IO_MAX_PATH_LENGTH];
+	char aNewFilename[IO_MAX_PATH_LENGTH];
+	Filename(pOldDemoFilename, aOldFilename, sizeof(aOldFilename));
+	Filename(pNewDemoFilename, aNewFilename, sizeof(aNewFilename));
+	if(pStorage->FileExists(aOldFilename, StorageType))
+		pStorage->RenameFile(aOldFilename, aNewFilename, StorageType);
+}
+
+void CDemoIndex::Remove(IStorage *pStorage, const char *pDemoFilename, int StorageType)
+{
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Filename(pDemoFilename, aFilename, sizeof(aFilename));
+	if(pStorage->FileExists(aFilename, StorageType))
+		pStorage->RemoveFile(aFilename, StorageType);
+}
+
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
 {
 	m_File = nullptr;
@@ -165,6 +320,8 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	// Header.m_Length - add this on stop
 	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
 	io_write(DemoFile, &Header, sizeof(Header));
+	m_Header = Header;
+	m_MapSha256 = Sha256;
 
 	CTimelineMarkers TimelineMarkers;
 	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
@@ -202,6 +359,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_vKeyFrames.clear();
 
 	if(m_pConsole)
 	{
@@ -327,6 +485,9 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
 	{
 		// write full tickmarker
+		const int64_t Filepos = io_tell(m_File);
+		if(Filepos >= 0)
+			m_vKeyFrames.emplace_back(Filepos, Tick);
 		WriteTickMarker(Tick, true);
 
 		// write snapshot
@@ -392,6 +553,7 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 		}
 	}
 
+	const int64_t Size = io_length(m_File);
 	io_close(m_File);
 	m_File = nullptr;
 
@@ -422,6 +584,23 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 		}
 	}
 
+	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE && Size > 0)
+	{
+		CDemoIndex Index;
+		Index.m_Header = m_Header;
+		uint_to_bytes_be(Index.m_Header.m_aLength, Length());
+		mem_zero(&Index.m_TimelineMarkers, sizeof(Index.m_TimelineMarkers));
+		uint_to_bytes_be(Index.m_TimelineMarkers.m_aNumTimelineMarkers, m_NumTimelineMarkers);
+		for(int i = 0; i < m_NumTimelineMarkers; i++)
+			uint_to_bytes_be(Index.m_TimelineMarkers.m_aTimelineMarkers[i], m_aTimelineMarkers[i]);
+		Index.m_MapSha256 = m_MapSha256;
+		Index.m_FirstTick = m_FirstTick;
+		Index.m_LastTick = m_LastTickMarker;
+		Index.m_vKeyFrames = std::move(m_vKeyFrames);
+		Index.Save(m_pStorage, pTargetFilename[0] != '\0' ? pTargetFilename : m_aCurrentFilename, Size);
+	}
+	m_vKeyFrames.clear();
+
 	if(m_pConsole)
 	{
 		char aBuf[64 + IO_MAX_PATH_LENGTH];
@@ -497,6 +676,7 @@ void CDemoPlayer::Construct(class CSnapshotDelta *pSnapshotDelta, bool UseVideo)
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
+	m_SnapshotCacheMemoryUsage = 0;
 	m_pListener = nullptr;
 	m_UseVideo = UseVideo;
 
@@ -783,6 +963,7 @@ void CDemoPlayer::DoTick()
 			if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
 			{
 				m_Info.m_NextTick = ChunkTick;
+				CacheState();
 				break;
 			}
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
@@ -794,6 +975,58 @@ void CDemoPlayer::DoTick()
 	}
 }
 
+void CDemoPlayer::CacheState()
+{
+	const size_t MaxMemoryUsage = (size_t)g_Config.m_ClDemoSnapshotCache * 1024 * 1024;
+	const int Tick = m_Info.m_Info.m_CurrentTick;
+	if(m_LastSnapshotDataSize <= 0 || m_Info.m_PreviousTick == -1)
+		return;
+	// one state every few ticks, demos may skip ticks
+	if(Tick / SNAPSHOT_CACHE_INTERVAL == m_Info.m_PreviousTick / SNAPSHOT_CACHE_INTERVAL)
+		return;
+	const size_t Size = sizeof(CCachedState) + sizeof(int) + m_LastSnapshotDataSize;
+	if(Size > MaxMemoryUsage || m_SnapshotCache.count(Tick))
+		return;
+	const int64_t Filepos = io_tell(m_File);
+	if(Filepos < 0)
+		return;
+
+	while(m_SnapshotCacheMemoryUsage + Size > MaxMemoryUsage)
+	{
+		const auto Oldest = m_SnapshotCache.find(m_SnapshotCacheLru.back());
+		m_SnapshotCacheMemoryUsage -= sizeof(CCachedState) + sizeof(int) + Oldest->second.m_vLastSnapshotData.size();
+		m_SnapshotCache.erase(Oldest);
+		m_SnapshotCacheLru.pop_back();
+	}
+
+	m_SnapshotCacheLru.push_front(Tick);
+	CCachedState &State = m_SnapshotCache[Tick];
+	State.m_Filepos = Filepos;
+	State.m_PreviousTick = m_Info.m_PreviousTick;
+	State.m_CurrentTick = Tick;
+	State.m_NextTick = m_Info.m_NextTick;
+	State.m_vLastSnapshotData.assign(m_aLastSnapshotData, m_aLastSnapshotData + m_LastSnapshotDataSize);
+	State.m_LruPosition = m_SnapshotCacheLru.begin();
+	m_SnapshotCacheMemoryUsage += Size;
+}
+
+const CDemoPlayer::CCachedState *CDemoPlayer::FindCachedState(int MaxTick)
+{
+	auto It = m_SnapshotCache.upper_bound(MaxTick);
+	if(It == m_SnapshotCache.begin())
+		return nullptr;
+	--It;
+	m_SnapshotCacheLru.splice(m_SnapshotCacheLru.begin(), m_SnapshotCacheLru, It->second.m_LruPosition);
+	return &It->second;
+}
+
+void CDemoPlayer::ClearSnapshotCache()
+{
+	m_SnapshotCache.clear();
+	m_SnapshotCacheLru.clear();
+	m_SnapshotCacheMemoryUsage = 0;
+}
+
 void CDemoPlayer::Pause()
 {
 	m_Info.m_Info.m_Paused = true;
@@ -847,7 +1080,8 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 
 	// save byte offset of map for later use
 	m_MapOffset = io_tell(m_File);
-	if(m_MapOffset < 0 || io_skip(m_File, m_MapInfo.m_Size) != 0)
+	const int64_t DemoSize = m_MapOffset < 0 ? -1 : io_length(m_File);
+	if(DemoSize < 0 || io_seek(m_File, m_MapOffset + m_MapInfo.m_Size, IOSEEK_START) != 0)
 	{
 		Stop("Error skipping map data");
 		return -1;
@@ -864,11 +1098,36 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 		}
 	}
 
-	// Scan the file for interesting points
-	if(ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
+	// Use the index next to the demo if it is up to date, otherwise
+	// scan the file for interesting points and write a new index
+	CDemoIndex Index;
+	time_t Created, Modified;
+	if(StorageType >= IStorage::TYPE_SAVE &&
+		pStorage->RetrieveTimes(pFilename, StorageType, &Created, &Modified) &&
+		Index.Load(pStorage, pFilename, StorageType, DemoSize, Modified))
 	{
-		Stop("Error scanning demo file");
-		return -1;
+		m_vKeyFrames = std::move(Index.m_vKeyFrames);
+		m_Info.m_Info.m_FirstTick = Index.m_FirstTick;
+		m_Info.m_Info.m_LastTick = Index.m_LastTick;
+	}
+	else
+	{
+		const EScanFileResult ScanResult = ScanFile();
+		if(ScanResult == EScanFileResult::ERROR_UNRECOVERABLE)
+		{
+			Stop("Error scanning demo file");
+			return -1;
+		}
+		if(ScanResult == EScanFileResult::SUCCESS && StorageType == IStorage::TYPE_SAVE)
+		{
+			Index.m_Header = m_Info.m_Header;
+			Index.m_TimelineMarkers = m_Info.m_TimelineMarkers;
+			Index.m_MapSha256 = m_MapInfo.m_Sha256;
+			Index.m_FirstTick = m_Info.m_Info.m_FirstTick;
+			Index.m_LastTick = m_Info.m_Info.m_LastTick;
+			Index.m_vKeyFrames = m_vKeyFrames;
+			Index.Save(pStorage, pFilename, DemoSize);
+		}
 	}
 	m_Info.m_LiveStateUpdating = true;
 
@@ -1069,18 +1328,40 @@ bool CDemoPlayer::SetPos(int WantedTick)
 	while(KeyFrame > 0 && m_vKeyFrames[KeyFrame].m_Tick > KeyFrameWantedTick)
 		KeyFrame--;
 
+	// a cached state after the keyframe saves decoding the ticks in between
+	const CCachedState *pCachedState = FindCachedState(KeyFrameWantedTick);
+	if(pCachedState && pCachedState->m_CurrentTick <= m_vKeyFrames[KeyFrame].m_Tick)
+		pCachedState = nullptr;
+	const int StartTick = pCachedState ? pCachedState->m_CurrentTick : m_vKeyFrames[KeyFrame].m_Tick;
+
 	if(WantedTick <= m_Info.m_Info.m_CurrentTick || // if we are seeking backwards (must be <= for high bandwidth demos) OR
-		m_Info.m_Info.m_CurrentTick < m_vKeyFrames[KeyFrame].m_Tick || // we are before the wanted KeyFrame OR
+		m_Info.m_Info.m_CurrentTick < StartTick || // we are before the wanted KeyFrame or cached state OR
 		(KeyFrame != m_vKeyFrames.size() - 1 && m_Info.m_Info.m_CurrentTick >= m_vKeyFrames[KeyFrame + 1].m_Tick)) // we are after the wanted KeyFrame
 	{
-		if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+		if(pCachedState)
 		{
-			Stop("Error seeking keyframe position");
-			return false;
+			if(io_seek(m_File, pCachedState->m_Filepos, IOSEEK_START) != 0)
+			{
+				Stop("Error seeking cached state position");
+				return false;
+			}
+			m_Info.m_NextTick = pCachedState->m_NextTick;
+			m_Info.m_Info.m_CurrentTick = pCachedState->m_CurrentTick;
+			m_Info.m_PreviousTick = pCachedState->m_PreviousTick;
+			m_LastSnapshotDataSize = pCachedState->m_vLastSnapshotData.size();
+			mem_copy(m_aLastSnapshotData, pCachedState->m_vLastSnapshotData.data(), m_LastSnapshotDataSize);
+		}
+		else
+		{
+			if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+			{
+				Stop("Error seeking keyframe position");
+				return false;
+			}
+			m_Info.m_NextTick = -1;
+			m_Info.m_Info.m_CurrentTick = -1;
+			m_Info.m_PreviousTick = -1;
 		}
-		m_Info.m_NextTick = -1;
-		m_Info.m_Info.m_CurrentTick = -1;
-		m_Info.m_PreviousTick = -1;
 	}
 
 	// playback everything until we hit our tick
@@ -1270,6 +1551,7 @@ void CDemoPlayer::Stop(const char *pErrorMessage)
 	io_close(m_File);
 	m_File = nullptr;
 	m_vKeyFrames.clear();
+	ClearSnapshotCache();
 	str_copy(m_aFilename, "");
 	str_copy(m_aErrorMessage, pErrorMessage);
 }
@@ -10,11 +10,72 @@
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
 
+#include <ctime>
 #include <functional>
+#include <list>
+#include <map>
+#include <optional>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
 
+/**
+ * Summary of a finished demo, stored in a small file next to it so the
+ * demo does not have to be read again to be listed or scanned for seeking.
+ *
+ * The index remembers the size and modification time of the demo and is
+ * only used while both still match.
+ */
+class CDemoIndex
+{
+public:
+	class CKeyFrame
+	{
+	public:
+		int64_t m_Filepos;
+		int m_Tick;
+
+		CKeyFrame(int64_t Filepos, int Tick) :
+			m_Filepos(Filepos), m_Tick(Tick)
+		{
+		}
+	};
+
+	CDemoHeader m_Header;
+	CTimelineMarkers m_TimelineMarkers;
+	std::optional<SHA256_DIGEST> m_MapSha256;
+	int m_FirstTick;
+	int m_LastTick;
+	std::vector<CKeyFrame> m_vKeyFrames;
+
+	/**
+	 * Loads the index of a demo.
+	 *
+	 * @param pDemoFilename Filename of the demo, not of the index.
+	 * @param DemoSize Current size of the demo file.
+	 * @param DemoModified Current modification time of the demo file.
+	 *
+	 * @return `true` if the index exists and matches the demo file, `false` otherwise.
+	 */
+	bool Load(class IStorage *pStorage, const char *pDemoFilename, int StorageType, int64_t DemoSize, time_t DemoModified);
+
+	/**
+	 * Saves the index of a demo that is not written to anymore.
+	 *
+	 * @param pDemoFilename Filename of the demo in the save directory, not of the index.
+	 * @param DemoSize Size of the demo file.
+	 *
+	 * @return `true` on success, `false` otherwise.
+	 */
+	bool Save(class IStorage *pStorage, const char *pDemoFilename, int64_t DemoSize) const;
+
+	void MapInfo(CMapInfo *pMapInfo) const;
+
+	static void Filename(const char *pDemoFilename, char *pBuffer, size_t BufferSize);
+	static void Rename(class IStorage *pStorage, const char *pOldDemoFilename, const char *pNewDemoFilename, int StorageType);
+	static void Remove(class IStorage *pStorage, const char *pDemoFilename, int StorageType);
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
@@ -25,6 +86,9 @@ class CDemoRecorder : public IDemoRecorder
 	int m_LastTickMarker;
 	int m_LastKeyFrame;
 	int m_FirstTick;
+	std::vector<CDemoIndex::CKeyFrame> m_vKeyFrames;
+	CDemoHeader m_Header;
+	std::optional<SHA256_DIGEST> m_MapSha256;
 
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
 	class CSnapshotDelta *m_pSnapshotDelta;
@@ -101,17 +165,7 @@ private:
 	TUpdateIntraTimesFunc m_UpdateIntraTimesFunc;
 
 	// Playback
-	class CKeyFrame
-	{
-	public:
-		int64_t m_Filepos;
-		int m_Tick;
-
-		CKeyFrame(int64_t Filepos, int Tick) :
-			m_Filepos(Filepos), m_Tick(Tick)
-		{
-		}
-	};
+	using CKeyFrame = CDemoIndex::CKeyFrame;
 
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
@@ -136,6 +190,31 @@ private:
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	// Decoded playback states, so seeking can continue from the closest
+	// one instead of decoding everything since the previous keyframe.
+	enum
+	{
+		SNAPSHOT_CACHE_INTERVAL = SERVER_TICK_SPEED / 5,
+	};
+	class CCachedState
+	{
+	public:
+		int64_t m_Filepos;
+		int m_PreviousTick;
+		int m_CurrentTick;
+		int m_NextTick;
+		std::vector<unsigned char> m_vLastSnapshotData;
+		std::list<int>::iterator m_LruPosition;
+	};
+	std::map<int, CCachedState> m_SnapshotCache;
+	// ticks of the cached states, most recently used first
+	std::list<int> m_SnapshotCacheLru;
+	size_t m_SnapshotCacheMemoryUsage;
+
+	void CacheState();
+	const CCachedState *FindCachedState(int MaxTick);
+	void ClearSnapshotCache();
+
 	bool m_UseVideo;
 #if defined(CONF_VIDEORECORDER)
 	bool m_WasRecording = false;
@@ -196,6 +275,7 @@ public:
 	const CPlaybackInfo *Info() const { return &m_Info; }
 	bool IsPlaying() const override { return m_File != nullptr; }
 	const CMapInfo *GetMapInfo() const { return &m_MapInfo; }
+	size_t SnapshotCacheMemoryUsage() const { return m_SnapshotCacheMemoryUsage; }
 };
 
 class CDemoEditor : public IDemoEditor
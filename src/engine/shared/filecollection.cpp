@@ -9,7 +9,7 @@
 
 #include <algorithm>
 
-void CFileCollection::Init(IStorage *pStorage, const char *pPath, const char *pFileDesc, const char *pFileExt, int MaxEntries)
+void CFileCollection::Init(IStorage *pStorage, const char *pPath, const char *pFileDesc, const char *pFileExt, int MaxEntries, FRemoveFunc pfnRemoveCompanion)
 {
 	m_vFileEntries.clear();
 	str_copy(m_aFileDesc, pFileDesc);
@@ -41,6 +41,8 @@ void CFileCollection::Init(IStorage *pStorage, const char *pPath, const char *pF
 		}
 
 		m_pStorage->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+		if(pfnRemoveCompanion)
+			pfnRemoveCompanion(m_pStorage, aBuf, IStorage::TYPE_SAVE);
 		FilesDeleted++;
 	}
 }
@@ -41,7 +41,14 @@ class CFileCollection
 	bool ParseFilename(const char *pFilename, time_t *pTimestamp);
 
 public:
-	void Init(IStorage *pStorage, const char *pPath, const char *pFileDesc, const char *pFileExt, int MaxEntries);
+	typedef void (*FRemoveFunc)(IStorage *pStorage, const char *pFilename, int StorageType);
+
+	/**
+	 * Removes the oldest files in `pPath` until at most `MaxEntries` are left.
+	 *
+	 * @param pfnRemoveCompanion Called with the path of every removed file, to remove files that belong to it.
+	 */
+	void Init(IStorage *pStorage, const char *pPath, const char *pFileDesc, const char *pFileExt, int MaxEntries, FRemoveFunc pfnRemoveCompanion = nullptr);
 
 	static int FilelistCallback(const char *pFilename, int IsDir, int StorageType, void *pUser);
 };
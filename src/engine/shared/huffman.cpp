@@ -5,6 +5,7 @@
 #include <base/system.h>
 
 #include <algorithm>
+#include <cstdint>
 
 const unsigned CHuffman::ms_aFreqTable[HUFFMAN_MAX_SYMBOLS] = {
 	1 << 30, 4545, 2657, 431, 1950, 919, 444, 482, 2244, 617, 838, 542, 715, 1814, 304, 240, 754, 212, 647, 186,
@@ -97,6 +98,7 @@ void CHuffman::Init(const unsigned *pFrequencies)
 	// make sure to cleanout every thing
 	mem_zero(m_aNodes, sizeof(m_aNodes));
 	mem_zero(m_apDecodeLut, sizeof(m_apDecodeLut));
+	mem_zero(m_aDecodeTable, sizeof(m_aDecodeTable));
 	m_pStartNode = nullptr;
 	m_NumNodes = 0;
 
@@ -127,32 +129,46 @@ void CHuffman::Init(const unsigned *pFrequencies)
 		if(k == HUFFMAN_LUTBITS)
 			m_apDecodeLut[i] = pNode;
 	}
+
+	m_MaxNumBits = 0;
+	for(int i = 0; i < HUFFMAN_MAX_SYMBOLS; i++)
+		m_MaxNumBits = std::max(m_MaxNumBits, m_aNodes[i].m_NumBits);
+
+	// build multi symbol decode table
+	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
+	for(int i = 0; i < HUFFMAN_LUTSIZE; i++)
+	{
+		CDecodeEntry *pEntry = &m_aDecodeTable[i];
+		const CNode *pNode = m_pStartNode;
+		for(int k = 0; k < HUFFMAN_LUTBITS; k++)
+		{
+			pNode = &m_aNodes[pNode->m_aLeaves[(i >> k) & 1]];
+			if(!pNode->m_NumBits)
+				continue;
+
+			// the decoder has to stop at eof
+			if(pNode == pEof || pEntry->m_NumSymbols == HUFFMAN_DECODE_SYMBOLS)
+				break;
+
+			pEntry->m_aSymbols[pEntry->m_NumSymbols++] = pNode->m_Symbol;
+			pEntry->m_NumBits = k + 1;
+			pNode = m_pStartNode;
+		}
+
+		if(!pEntry->m_NumSymbols)
+		{
+			pEntry->m_Node = pNode - m_aNodes;
+			pEntry->m_NumBits = pNode->m_NumBits ? pNode->m_NumBits : (unsigned)HUFFMAN_LUTBITS;
+		}
+	}
 }
 
 //***************************************************************
 int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
 {
-	// this macro loads a symbol for a byte into bits and bitcount
-#define HUFFMAN_MACRO_LOADSYMBOL(Sym) \
-	do \
-	{ \
-		Bits |= m_aNodes[Sym].m_Bits << Bitcount; \
-		Bitcount += m_aNodes[Sym].m_NumBits; \
-	} while(0)
-
-	// this macro writes the symbol stored in bits and bitcount to the dst pointer
-#define HUFFMAN_MACRO_WRITE() \
-	do \
-	{ \
-		while(Bitcount >= 8) \
-		{ \
-			*pDst++ = (unsigned char)(Bits & 0xff); \
-			if(pDst == pDstEnd) \
-				return -1; \
-			Bits >>= 8; \
-			Bitcount -= 8; \
-		} \
-	} while(0)
+	// there is always at least one byte of output
+	if(OutputSize <= 0)
+		return -1;
 
 	// setup buffer pointers
 	const unsigned char *pSrc = (const unsigned char *)pInput;
@@ -160,46 +176,48 @@ int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int Out
 	unsigned char *pDst = (unsigned char *)pOutput;
 	unsigned char *pDstEnd = pDst + OutputSize;
 
-	// symbol variables
-	unsigned Bits = 0;
+	// symbol variables, whole words are written as soon as there are 32 bits
+	uint64_t Bits = 0;
 	unsigned Bitcount = 0;
 
-	// make sure that we have data that we want to compress
-	if(InputSize)
+	while(pSrc != pSrcEnd)
 	{
-		// {A} load the first symbol
-		int Symbol = *pSrc++;
+		const CNode *pNode = &m_aNodes[*pSrc++];
+		Bits |= (uint64_t)pNode->m_Bits << Bitcount;
+		Bitcount += pNode->m_NumBits;
 
-		while(pSrc != pSrcEnd)
+		if(Bitcount >= 32)
 		{
-			// {B} load the symbol
-			HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-
-			// {C} fetch next symbol, this is done here because it will reduce dependency in the code
-			Symbol = *pSrc++;
-
-			// {B} write the symbol loaded at
-			HUFFMAN_MACRO_WRITE();
+			// the output must not be filled up before the last byte
+			if(pDstEnd - pDst <= 4)
+				return -1;
+			pDst[0] = Bits;
+			pDst[1] = Bits >> 8;
+			pDst[2] = Bits >> 16;
+			pDst[3] = Bits >> 24;
+			pDst += 4;
+			Bits >>= 32;
+			Bitcount -= 32;
 		}
-
-		// write the last symbol loaded from {C} or {A} in the case of only 1 byte input buffer
-		HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-		HUFFMAN_MACRO_WRITE();
 	}
 
 	// write EOF symbol
-	HUFFMAN_MACRO_LOADSYMBOL(HUFFMAN_EOF_SYMBOL);
-	HUFFMAN_MACRO_WRITE();
+	Bits |= (uint64_t)m_aNodes[HUFFMAN_EOF_SYMBOL].m_Bits << Bitcount;
+	Bitcount += m_aNodes[HUFFMAN_EOF_SYMBOL].m_NumBits;
+	while(Bitcount >= 8)
+	{
+		*pDst++ = (unsigned char)(Bits & 0xff);
+		if(pDst == pDstEnd)
+			return -1;
+		Bits >>= 8;
+		Bitcount -= 8;
+	}
 
 	// write out the last bits
 	*pDst++ = Bits;
 
 	// return the size of the output
 	return (int)(pDst - (const unsigned char *)pOutput);
-
-	// remove macros
-#undef HUFFMAN_MACRO_LOADSYMBOL
-#undef HUFFMAN_MACRO_WRITE
 }
 
 //***************************************************************
@@ -216,6 +234,60 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 
 	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
 
+	// decode several symbols per lookup while there is enough input and
+	// output left that neither can run out in between
+	if(m_MaxNumBits <= HUFFMAN_FAST_BITS)
+	{
+		// bits needed for any code, a lookup needs HUFFMAN_LUTBITS bits even for shorter codes
+		const unsigned NeededBits = std::max(m_MaxNumBits, (unsigned)HUFFMAN_LUTBITS);
+		uint64_t FastBits = 0;
+		unsigned FastBitcount = 0;
+		while(pSrcEnd - pSrc >= 8 && pDstEnd - pDst >= HUFFMAN_DECODE_SYMBOLS)
+		{
+			// refill to at least 56 bits, the bits above the count are
+			// already the following bits of the input
+			const uint64_t Word = (uint64_t)pSrc[0] | (uint64_t)pSrc[1] << 8 | (uint64_t)pSrc[2] << 16 | (uint64_t)pSrc[3] << 24 |
+					      (uint64_t)pSrc[4] << 32 | (uint64_t)pSrc[5] << 40 | (uint64_t)pSrc[6] << 48 | (uint64_t)pSrc[7] << 56;
+			FastBits |= Word << FastBitcount;
+			pSrc += (63 - FastBitcount) >> 3;
+			FastBitcount |= 56;
+
+			do
+			{
+				const CDecodeEntry *pEntry = &m_aDecodeTable[FastBits & HUFFMAN_LUTMASK];
+				FastBits >>= pEntry->m_NumBits;
+				FastBitcount -= pEntry->m_NumBits;
+				if(pEntry->m_NumSymbols)
+				{
+					// always write all symbols of an entry, the output has room for them
+					for(int i = 0; i < HUFFMAN_DECODE_SYMBOLS; i++)
+						pDst[i] = pEntry->m_aSymbols[i];
+					pDst += pEntry->m_NumSymbols;
+					continue;
+				}
+
+				// walk the tree for codes longer than the table
+				const CNode *pNode = &m_aNodes[pEntry->m_Node];
+				while(!pNode->m_NumBits)
+				{
+					pNode = &m_aNodes[pNode->m_aLeaves[FastBits & 1]];
+					FastBits >>= 1;
+					FastBitcount--;
+				}
+
+				if(pNode == pEof)
+					return (int)(pDst - (const unsigned char *)pOutput);
+				*pDst++ = pNode->m_Symbol;
+			} while(FastBitcount >= NeededBits && pDstEnd - pDst >= HUFFMAN_DECODE_SYMBOLS);
+		}
+
+		// give the whole bytes back, the remaining bits go to the exact decoder
+		pSrc -= FastBitcount / 8;
+		Bitcount = FastBitcount % 8;
+		Bits = FastBits & ((1u << Bitcount) - 1);
+	}
+
+	// decode the rest symbol by symbol, this handles running out of input or output
 	while(true)
 	{
 		// {A} try to load a node now, this will reduce dependency at location {D}
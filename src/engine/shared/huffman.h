@@ -14,7 +14,12 @@ class CHuffman
 
 		HUFFMAN_LUTBITS = 10,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+
+		// symbols decoded by a single lookup of the fast decoder
+		HUFFMAN_DECODE_SYMBOLS = 8,
+		// bits in the fast decoder's buffer after a refill, longer codes use the exact decoder only
+		HUFFMAN_FAST_BITS = 56,
 	};
 
 	struct CNode
@@ -30,12 +35,25 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	// up to HUFFMAN_DECODE_SYMBOLS symbols that fit into HUFFMAN_LUTBITS bits
+	struct CDecodeEntry
+	{
+		unsigned char m_aSymbols[HUFFMAN_DECODE_SYMBOLS];
+		unsigned char m_NumSymbols;
+		unsigned char m_NumBits;
+
+		// node after m_NumBits bits if m_NumSymbols is 0, the eof symbol or a tree node of a longer code
+		unsigned short m_Node;
+	};
+
 	static const unsigned ms_aFreqTable[HUFFMAN_MAX_SYMBOLS];
 
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
 	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CDecodeEntry m_aDecodeTable[HUFFMAN_LUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
+	unsigned m_MaxNumBits;
 
 	void Setbits_r(CNode *pNode, int Bits, unsigned Depth);
 	void ConstructTree(const unsigned *pFrequencies);
@@ -75,11 +75,22 @@ bool CMap::Load(const char *pMapName, int StorageType)
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 	if(!pStorage)
 		return false;
+	return Load(pStorage, pMapName, StorageType);
+}
 
+bool CMap::Load(IStorage *pStorage, const char *pMapName, int StorageType)
+{
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
 	// by loading the new datafile separately first.
 	CDataFileReader NewDataFile;
-	if(!NewDataFile.Open(pStorage, pMapName, StorageType))
+	int Flags = 0;
+	if(m_MappedData)
+	{
+		Flags |= CDataFileReader::OPEN_MAPPED;
+		if(m_PrefetchData)
+			Flags |= CDataFileReader::OPEN_PREFETCH;
+	}
+	if(!NewDataFile.Open(pStorage, pMapName, StorageType, Flags))
 		return false;
 
 	// Check version
@@ -130,6 +141,12 @@ bool CMap::Load(const char *pMapName, int StorageType)
 	return true;
 }
 
+void CMap::Replace(IEngineMap *pOther)
+{
+	m_DataFile.Close();
+	m_DataFile = std::move(static_cast<CMap *>(pOther)->m_DataFile);
+}
+
 void CMap::Unload()
 {
 	m_DataFile.Close();
@@ -12,6 +12,8 @@
 class CMap : public IEngineMap
 {
 	CDataFileReader m_DataFile;
+	bool m_MappedData = false;
+	bool m_PrefetchData = false;
 
 public:
 	CMap();
@@ -33,6 +35,10 @@ public:
 	int NumItems() const override;
 
 	[[nodiscard]] bool Load(const char *pMapName, int StorageType) override;
+	[[nodiscard]] bool Load(class IStorage *pStorage, const char *pMapName, int StorageType) override;
+	void Replace(IEngineMap *pOther) override;
+	void SetMappedData(bool Mapped) override { m_MappedData = Mapped; }
+	void SetPrefetchData(bool Prefetch) override { m_PrefetchData = Prefetch; }
 	void Unload() override;
 	bool IsLoaded() const override;
 	IOHANDLE File() const override;
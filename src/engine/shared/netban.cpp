@@ -6,6 +6,8 @@
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 
+#include <algorithm>
+
 CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
 {
 	if(pAddr->type == NETTYPE_IPV4)
@@ -29,20 +31,6 @@ CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
 	m_Hash &= 0xFF;
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
-{
-	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
-	{
-		Sum += pAddr->ip[i - 1];
-		aHash[i].m_Hash = Sum & 0xFF;
-		aHash[i].m_HashIndex = i % Length;
-	}
-	return Length;
-}
-
 template<class T, int HashCount>
 void CNetBan::CBanPool<T, HashCount>::InsertUsed(CBan<T> *pBan)
 {
@@ -110,6 +98,7 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 
 	// update ban count
 	++m_CountUsed;
+	++m_Revision;
 
 	return pBan;
 }
@@ -146,6 +135,7 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 
 	// update ban count
 	--m_CountUsed;
+	++m_Revision;
 
 	return 0;
 }
@@ -180,6 +170,7 @@ void CNetBan::CBanPool<T, HashCount>::Reset()
 	mem_zero(m_aBans, sizeof(m_aBans));
 	m_pFirstUsed = 0;
 	m_CountUsed = 0;
+	++m_Revision;
 
 	for(int i = 1; i < MAX_BANS - 1; ++i)
 	{
@@ -207,6 +198,48 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
 	return nullptr;
 }
 
+void CNetBan::CRangeIndex::Build(const CBanRangePool *pPool)
+{
+	m_vpRanges.clear();
+	for(const CBanRange *pBan = pPool->First(); pBan; pBan = pBan->m_pNext)
+		m_vpRanges.push_back(pBan);
+	std::stable_sort(m_vpRanges.begin(), m_vpRanges.end(), [](const CBanRange *pBan1, const CBanRange *pBan2) {
+		return NetComp(&pBan1->m_Data.m_LB, &pBan2->m_Data.m_LB) < 0;
+	});
+
+	m_vMaxUpperBounds.resize(m_vpRanges.size());
+	for(size_t i = 0; i < m_vpRanges.size(); ++i)
+	{
+		const NETADDR *pUpperBound = &m_vpRanges[i]->m_Data.m_UB;
+		if(i > 0 && NetComp(&m_vMaxUpperBounds[i - 1], pUpperBound) > 0)
+			pUpperBound = &m_vMaxUpperBounds[i - 1];
+		m_vMaxUpperBounds[i] = *pUpperBound;
+	}
+
+	m_Built = true;
+	m_Revision = pPool->Revision();
+}
+
+const CNetBan::CBanRange *CNetBan::CRangeIndex::Find(const CBanRangePool *pPool, const NETADDR *pAddr)
+{
+	if(!m_Built || m_Revision != pPool->Revision())
+		Build(pPool);
+
+	// go back from the last range starting at or before the address until
+	// no earlier range reaches up to it anymore
+	auto It = std::upper_bound(m_vpRanges.begin(), m_vpRanges.end(), pAddr, [](const NETADDR *pAddress, const CBanRange *pBan) {
+		return NetComp(pAddress, &pBan->m_Data.m_LB) < 0;
+	});
+	for(int i = (int)(It - m_vpRanges.begin()) - 1; i >= 0; --i)
+	{
+		if(NetComp(&m_vMaxUpperBounds[i], pAddr) < 0)
+			break;
+		if(NetComp(&m_vpRanges[i]->m_Data.m_UB, pAddr) >= 0)
+			return m_vpRanges[i];
+	}
+	return nullptr;
+}
+
 template<class T>
 int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool VerbatimReason)
 {
@@ -385,11 +418,9 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 		pAddr = &Addr;
 		Addr.type = NETTYPE_IPV6;
 	}
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
-
 	// check ban addresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CNetHash NetHash(pAddr);
+	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &NetHash);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -397,16 +428,11 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	}
 
 	// check ban ranges
-	for(int i = Length - 1; i >= 0; --i)
+	const CBanRange *pBanRange = m_RangeIndex.Find(&m_BanRangePool, pAddr);
+	if(pBanRange)
 	{
-		for(CBanRange *pBanRange = m_BanRangePool.First(&aHash[i]); pBanRange; pBanRange = pBanRange->m_pHashNext)
-		{
-			if(NetMatch(&pBanRange->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
-			}
-		}
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
 	}
 
 	return false;
@@ -5,6 +5,8 @@
 
 #include <engine/console.h>
 
+#include <vector>
+
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
 	return mem_comp(pAddr1, pAddr2, pAddr1->type == NETTYPE_IPV4 ? 8 : 20);
@@ -69,8 +71,6 @@ protected:
 		CNetHash() = default;
 		CNetHash(const NETADDR *pAddr);
 		CNetHash(const CNetRange *pRange);
-
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
 	};
 
 	struct CBanInfo
@@ -114,9 +114,10 @@ protected:
 
 		int Num() const { return m_CountUsed; }
 		bool IsFull() const { return m_CountUsed == MAX_BANS; }
+		// changes whenever bans are added or removed
+		unsigned Revision() const { return m_Revision; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
 		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
 		{
 			for(CBan<CDataType> *pBan = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
@@ -140,6 +141,7 @@ protected:
 		CBan<CDataType> *m_pFirstFree;
 		CBan<CDataType> *m_pFirstUsed;
 		int m_CountUsed;
+		unsigned m_Revision = 0;
 
 		void InsertUsed(CBan<CDataType> *pBan);
 	};
@@ -149,6 +151,23 @@ protected:
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
 
+	// Ranges sorted by their lower bound together with the highest upper
+	// bound up to each of them, so the ranges containing an address are
+	// found with a binary search. Rebuilt lazily when the pool changed.
+	class CRangeIndex
+	{
+	public:
+		const CBanRange *Find(const CBanRangePool *pPool, const NETADDR *pAddr);
+
+	private:
+		void Build(const CBanRangePool *pPool);
+
+		std::vector<const CBanRange *> m_vpRanges;
+		std::vector<NETADDR> m_vMaxUpperBounds;
+		bool m_Built = false;
+		unsigned m_Revision = 0;
+	};
+
 	template<class T>
 	void MakeBanInfo(const CBan<T> *pBan, char *pBuf, unsigned BuffSize, int Type) const;
 	template<class T>
@@ -160,6 +179,7 @@ protected:
 	class IStorage *m_pStorage;
 	CBanAddrPool m_BanAddrPool;
 	CBanRangePool m_BanRangePool;
+	mutable CRangeIndex m_RangeIndex;
 	NETADDR m_LocalhostIpV4, m_LocalhostIpV6;
 
 public:
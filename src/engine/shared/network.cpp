@@ -151,7 +151,7 @@ void CNetBase::SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *
 		std::fill(aBuffer, aBuffer + DATA_OFFSET, 0xFF);
 	}
 	mem_copy(aBuffer + DATA_OFFSET, pData, DataSize);
-	net_udp_send(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
+	SendDatagram(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
 }
 
 void CNetBase::SendPacketConnlessWithToken7(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize, SECURITY_TOKEN Token, SECURITY_TOKEN ResponseToken)
@@ -165,7 +165,7 @@ void CNetBase::SendPacketConnlessWithToken7(NETSOCKET Socket, NETADDR *pAddr, co
 	WriteSecurityToken(aBuffer + 1, Token);
 	WriteSecurityToken(aBuffer + 1 + sizeof(SECURITY_TOKEN), ResponseToken);
 	mem_copy(aBuffer + DATA_OFFSET, pData, DataSize);
-	net_udp_send(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
+	SendDatagram(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
 }
 
 void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket, SECURITY_TOKEN SecurityToken, bool Sixup)
@@ -233,7 +233,7 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 		aBuffer[0] = ((pPacket->m_Flags << 2) & 0xfc) | ((pPacket->m_Ack >> 8) & 0x3);
 		aBuffer[1] = pPacket->m_Ack & 0xff;
 		aBuffer[2] = pPacket->m_NumChunks;
-		net_udp_send(Socket, pAddr, aBuffer, FinalSize);
+		SendDatagram(Socket, pAddr, aBuffer, FinalSize);
 
 		// log raw socket data
 		if(ms_DataLogSent)
@@ -446,6 +446,7 @@ bool CNetBase::IsSeqInBackroom(int Seq, int Ack)
 IOHANDLE CNetBase::ms_DataLogSent = nullptr;
 IOHANDLE CNetBase::ms_DataLogRecv = nullptr;
 CHuffman CNetBase::ms_Huffman;
+CNetServerIo *CNetBase::ms_pServerIo = nullptr;
 
 void CNetBase::OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv)
 {
@@ -498,6 +499,20 @@ void CNetBase::Init()
 	ms_Huffman.Init();
 }
 
+void CNetBase::SetServerIo(CNetServerIo *pServerIo)
+{
+	dbg_assert(pServerIo == nullptr || ms_pServerIo == nullptr, "only one server socket can have network threads");
+	ms_pServerIo = pServerIo;
+}
+
+void CNetBase::SendDatagram(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int Size)
+{
+	if(ms_pServerIo && ms_pServerIo->Socket() == Socket)
+		ms_pServerIo->Send(pAddr, pData, Size);
+	else
+		net_udp_send(Socket, pAddr, pData, Size);
+}
+
 void CNetTokenCache::Init(NETSOCKET Socket)
 {
 	m_Socket = Socket;
@@ -4,12 +4,21 @@
 #define ENGINE_SHARED_NETWORK_H
 
 #include "ringbuffer.h"
+#include "spsc_queue.h"
 #include "stun.h"
 
 #include <base/types.h>
 
 #include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <unordered_map>
 
 class CHuffman;
 class CNetBan;
@@ -399,12 +408,103 @@ private:
 };
 
 // server side
+/**
+ * Network threads of a server socket. One thread receives packets and
+ * unpacks them, another one sends the packets queued by the game thread.
+ * Both hand packets to and from the game thread through lock-free queues.
+ */
+class CNetServerIo
+{
+public:
+	// A received packet and the result of unpacking it as a non-sixup packet
+	struct CRecvPacket
+	{
+		NETADDR m_Addr;
+		int m_Size;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+
+		int m_Result;
+		bool m_Sixup;
+		SECURITY_TOKEN m_Token;
+		SECURITY_TOKEN m_ResponseToken;
+		CNetPacketConstruct m_Packet;
+	};
+
+	enum
+	{
+		RECV_QUEUE_SIZE = 1024,
+		SEND_QUEUE_SIZE = 1024,
+	};
+
+	CNetServerIo(NETSOCKET Socket);
+	~CNetServerIo();
+
+	NETSOCKET Socket() const { return m_Socket; }
+
+	/**
+	 * Game thread only.
+	 *
+	 * @return The next received packet, valid until the next call, `nullptr` if there is none.
+	 */
+	const CRecvPacket *Recv();
+
+	/**
+	 * Game thread only. Waits until packets were received.
+	 *
+	 * @return Whether there are packets to receive.
+	 */
+	bool WaitForPackets(std::chrono::nanoseconds Timeout);
+
+	/**
+	 * Game thread only. Queues a packet for the send thread.
+	 */
+	void Send(const NETADDR *pAddr, const void *pData, int Size);
+
+	/**
+	 * Game thread only. While batching, queued packets are only sent once
+	 * the batch ends.
+	 */
+	void BeginBatch() { m_Batching = true; }
+	void EndBatch();
+
+private:
+	struct CSendPacket
+	{
+		NETADDR m_Addr;
+		int m_Size;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+	};
+
+	void RecvThread();
+	void SendThread();
+	void WakeSendThread();
+
+	NETSOCKET m_Socket;
+	std::atomic<bool> m_Shutdown = false;
+
+	CSpscQueue<CRecvPacket> m_RecvQueue{RECV_QUEUE_SIZE};
+	CRecvPacket m_Current;
+	std::mutex m_RecvMutex;
+	std::condition_variable m_RecvCond;
+
+	CSpscQueue<CSendPacket> m_SendQueue{SEND_QUEUE_SIZE};
+	bool m_Batching = false;
+	bool m_SendPending = false;
+	std::mutex m_SendMutex;
+	std::condition_variable m_SendCond;
+
+	std::thread m_RecvThread;
+	std::thread m_SendThread;
+};
+
 class CNetServer
 {
 	struct CSlot
 	{
 	public:
 		CNetConnection m_Connection;
+		// the address the slot is registered with in m_SlotByAddr and m_SlotsByIp
+		std::optional<NETADDR> m_MappedAddr;
 	};
 
 	struct CSpamConn
@@ -435,9 +535,17 @@ class CNetServer
 
 	CSpamConn m_aSpamConns[NET_CONNLIMIT_IPS];
 
+	// The slot that was last given each address and the slots that were
+	// given an address of each IP (port 0). Entries are removed when a slot is
+	// dropped or gets a new address, lookups still check the state of the slot.
+	std::unordered_map<NETADDR, int> m_SlotByAddr;
+	std::unordered_map<NETADDR, std::bitset<NET_MAX_CLIENTS>> m_SlotsByIp;
+
 	CPacketChunkUnpacker m_PacketChunkUnpacker;
 	CNetPacketConstruct m_RecvBuffer;
 
+	std::unique_ptr<CNetServerIo> m_pIo;
+
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
@@ -447,6 +555,8 @@ class CNetServer
 	void SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra, int ExtraSize, SECURITY_TOKEN SecurityToken);
 
 	int TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, bool VanillaAuth = false, bool Sixup = false, SECURITY_TOKEN Token = 0);
+	void SetSlotAddr(int Slot, const NETADDR &Addr);
+	void ClearSlotAddr(int Slot);
 	int NumClientsWithAddr(NETADDR Addr);
 	bool Connlimit(NETADDR Addr);
 	void SendMsgs(NETADDR &Addr, const CPacker **ppMsgs, int Num);
@@ -459,11 +569,21 @@ public:
 	bool Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int MaxClientsPerIp);
 	void Close();
 
+	// receive and send on network threads, see CNetServerIo
+	void StartIoThreads();
+	bool HasIoThreads() const { return m_pIo != nullptr; }
+
 	//
 	int Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken);
 	int Send(CNetChunk *pChunk);
 	void Update();
 
+	// waits until packets can be received
+	bool WaitForPackets(std::chrono::nanoseconds Timeout);
+	// sends the packets of a tick in as few system calls as possible
+	void BeginSendBatch();
+	void EndSendBatch();
+
 	//
 	void Drop(int ClientId, const char *pReason);
 
@@ -476,6 +596,8 @@ public:
 	CNetBan *NetBan() const { return m_pNetBan; }
 	int NetType() const { return net_socket_type(m_Socket); }
 	int MaxClients() const { return m_MaxClients; }
+	int NumSlotAddrs() const { return m_SlotByAddr.size(); }
+	int NumSlotIps() const { return m_SlotsByIp.size(); }
 
 	void SendTokenSixup(NETADDR &Addr, SECURITY_TOKEN Token);
 
@@ -616,6 +738,11 @@ class CNetBase
 	static IOHANDLE ms_DataLogRecv;
 	static CHuffman ms_Huffman;
 
+	// the send thread of a server socket, see CNetServerIo
+	static CNetServerIo *ms_pServerIo;
+
+	static void SendDatagram(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int Size);
+
 public:
 	static void OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv);
 	static void CloseLog();
@@ -636,6 +763,8 @@ public:
 
 	// The backroom is ack-NET_MAX_SEQUENCE/2. Used for knowing if we acked a packet or not
 	static bool IsSeqInBackroom(int Seq, int Ack);
+
+	static void SetServerIo(CNetServerIo *pServerIo);
 };
 
 #endif
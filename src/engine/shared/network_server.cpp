@@ -90,8 +90,48 @@ void CNetServer::Close()
 	{
 		return;
 	}
+	if(m_pIo)
+	{
+		m_pIo.reset();
+		CNetBase::SetServerIo(nullptr);
+	}
 	net_udp_close(m_Socket);
 	m_Socket = nullptr;
+
+	for(auto &Slot : m_aSlots)
+		Slot.m_MappedAddr.reset();
+	m_SlotByAddr.clear();
+	m_SlotsByIp.clear();
+}
+
+void CNetServer::StartIoThreads()
+{
+	dbg_assert(m_Socket != nullptr && !m_pIo, "network threads need an open socket without network threads");
+	m_pIo = std::make_unique<CNetServerIo>(m_Socket);
+	CNetBase::SetServerIo(m_pIo.get());
+}
+
+bool CNetServer::WaitForPackets(std::chrono::nanoseconds Timeout)
+{
+	if(m_pIo)
+		return m_pIo->WaitForPackets(Timeout);
+	return net_socket_read_wait(m_Socket, Timeout);
+}
+
+void CNetServer::BeginSendBatch()
+{
+	if(m_pIo)
+		m_pIo->BeginBatch();
+	else
+		net_udp_batch_begin(m_Socket);
+}
+
+void CNetServer::EndSendBatch()
+{
+	if(m_pIo)
+		m_pIo->EndBatch();
+	else
+		net_udp_batch_end(m_Socket);
 }
 
 void CNetServer::Drop(int ClientId, const char *pReason)
@@ -101,6 +141,7 @@ void CNetServer::Drop(int ClientId, const char *pReason)
 	if(m_pfnDelClient)
 		m_pfnDelClient(ClientId, pReason, m_pUser);
 
+	ClearSlotAddr(ClientId);
 	m_aSlots[ClientId].m_Connection.Disconnect(pReason);
 }
 
@@ -150,11 +191,52 @@ void CNetServer::SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra,
 	CNetBase::SendControlMsg(m_Socket, &Addr, 0, ControlMsg, pExtra, ExtraSize, SecurityToken);
 }
 
+void CNetServer::SetSlotAddr(int Slot, const NETADDR &Addr)
+{
+	ClearSlotAddr(Slot);
+
+	m_SlotByAddr[Addr] = Slot;
+	NETADDR Ip = Addr;
+	Ip.port = 0;
+	m_SlotsByIp[Ip].set(Slot);
+	m_aSlots[Slot].m_MappedAddr = Addr;
+}
+
+void CNetServer::ClearSlotAddr(int Slot)
+{
+	if(!m_aSlots[Slot].m_MappedAddr)
+		return;
+
+	// another slot may have been given the address since
+	const NETADDR OldAddr = *m_aSlots[Slot].m_MappedAddr;
+	auto SlotIt = m_SlotByAddr.find(OldAddr);
+	if(SlotIt != m_SlotByAddr.end() && SlotIt->second == Slot)
+		m_SlotByAddr.erase(SlotIt);
+	NETADDR OldIp = OldAddr;
+	OldIp.port = 0;
+	auto IpIt = m_SlotsByIp.find(OldIp);
+	if(IpIt != m_SlotsByIp.end())
+	{
+		IpIt->second.reset(Slot);
+		if(IpIt->second.none())
+			m_SlotsByIp.erase(IpIt);
+	}
+	m_aSlots[Slot].m_MappedAddr.reset();
+}
+
 int CNetServer::NumClientsWithAddr(NETADDR Addr)
 {
+	Addr.port = 0;
+	auto IpIt = m_SlotsByIp.find(Addr);
+	if(IpIt == m_SlotsByIp.end())
+		return 0;
+
 	int FoundAddr = 0;
 	for(int i = 0; i < MaxClients(); ++i)
 	{
+		if(!IpIt->second.test(i))
+			continue;
+
 		if(m_aSlots[i].m_Connection.State() == CNetConnection::EState::OFFLINE ||
 			(m_aSlots[i].m_Connection.State() == CNetConnection::EState::ERROR &&
 				(!m_aSlots[i].m_Connection.m_TimeoutProtected ||
@@ -245,6 +327,7 @@ int CNetServer::TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, boo
 	}
 
 	// init connection slot
+	SetSlotAddr(Slot, Addr);
 	m_aSlots[Slot].m_Connection.DirectInit(Addr, SecurityToken, Token, Sixup);
 
 	if(VanillaAuth)
@@ -549,14 +632,17 @@ int CNetServer::OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg,
 
 int CNetServer::GetClientSlot(const NETADDR &Addr)
 {
-	for(int i = 0; i < MaxClients(); i++)
+	// only the slot that got the address last can still be connected with it
+	auto SlotIt = m_SlotByAddr.find(Addr);
+	if(SlotIt == m_SlotByAddr.end())
+		return -1;
+
+	const int Slot = SlotIt->second;
+	if(m_aSlots[Slot].m_Connection.State() != CNetConnection::EState::OFFLINE &&
+		m_aSlots[Slot].m_Connection.State() != CNetConnection::EState::ERROR &&
+		net_addr_comp(m_aSlots[Slot].m_Connection.PeerAddress(), &Addr) == 0)
 	{
-		if(m_aSlots[i].m_Connection.State() != CNetConnection::EState::OFFLINE &&
-			m_aSlots[i].m_Connection.State() != CNetConnection::EState::ERROR &&
-			net_addr_comp(m_aSlots[i].m_Connection.PeerAddress(), &Addr) == 0)
-		{
-			return i;
-		}
+		return Slot;
 	}
 	return -1;
 }
@@ -594,7 +680,21 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		// TODO: empty the recvinfo
 		NETADDR Addr;
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		int Bytes;
+		const CNetServerIo::CRecvPacket *pIoPacket = nullptr;
+		if(m_pIo)
+		{
+			pIoPacket = m_pIo->Recv();
+			if(!pIoPacket)
+				break;
+			Addr = pIoPacket->m_Addr;
+			pData = const_cast<unsigned char *>(pIoPacket->m_aData);
+			Bytes = pIoPacket->m_Size;
+		}
+		else
+		{
+			Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		}
 
 		// no more packets for now
 		if(Bytes <= 0)
@@ -620,7 +720,23 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		SECURITY_TOKEN Token;
 		int Slot = (*Flags & NET_PACKETFLAG_CONNLESS) == 0 ? GetClientSlot(Addr) : -1;
 		bool Sixup = Slot != -1 && m_aSlots[Slot].m_Connection.m_Sixup;
-		if(CNetBase::UnpackPacket(pData, Bytes, &m_RecvBuffer, Sixup, &Token, pResponseToken) == 0)
+		int Result;
+		if(pIoPacket && !Sixup)
+		{
+			// already unpacked by the receive thread
+			Result = pIoPacket->m_Result;
+			Sixup = pIoPacket->m_Sixup;
+			Token = pIoPacket->m_Token;
+			if(pIoPacket->m_ResponseToken != NET_SECURITY_TOKEN_UNKNOWN)
+				*pResponseToken = pIoPacket->m_ResponseToken;
+			if(Result == 0)
+				mem_copy(&m_RecvBuffer, &pIoPacket->m_Packet, sizeof(m_RecvBuffer));
+		}
+		else
+		{
+			Result = CNetBase::UnpackPacket(pData, Bytes, &m_RecvBuffer, Sixup, &Token, pResponseToken);
+		}
+		if(Result == 0)
 		{
 			if(m_RecvBuffer.m_Flags & NET_PACKETFLAG_CONNLESS)
 			{
@@ -740,7 +856,9 @@ bool CNetServer::HasErrored(int ClientId)
 
 void CNetServer::ResumeOldConnection(int ClientId, int OrigId)
 {
+	SetSlotAddr(ClientId, *ClientAddr(OrigId));
 	m_aSlots[ClientId].m_Connection.ResumeConnection(ClientAddr(OrigId), m_aSlots[OrigId].m_Connection.SeqSequence(), m_aSlots[OrigId].m_Connection.AckSequence(), m_aSlots[OrigId].m_Connection.SecurityToken(), m_aSlots[OrigId].m_Connection.ResendBuffer(), m_aSlots[OrigId].m_Connection.m_Sixup);
+	ClearSlotAddr(OrigId);
 	m_aSlots[OrigId].m_Connection.Reset();
 }
 
@@ -0,0 +1,155 @@
+#include "network.h"
+
+#include <base/system.h>
+
+using namespace std::chrono_literals;
+
+CNetServerIo::CNetServerIo(NETSOCKET Socket) :
+	m_Socket(Socket)
+{
+	m_RecvThread = std::thread([this]() { RecvThread(); });
+	m_SendThread = std::thread([this]() { SendThread(); });
+}
+
+CNetServerIo::~CNetServerIo()
+{
+	m_Shutdown.store(true);
+	{
+		std::unique_lock<std::mutex> Lock(m_SendMutex);
+		m_SendPending = true;
+	}
+	m_SendCond.notify_one();
+	m_RecvThread.join();
+	m_SendThread.join();
+}
+
+const CNetServerIo::CRecvPacket *CNetServerIo::Recv()
+{
+	const CRecvPacket *pPacket = m_RecvQueue.Front();
+	if(!pPacket)
+		return nullptr;
+	// copy it out so the receive thread can reuse the slot right away
+	m_Current = *pPacket;
+	m_RecvQueue.Pop();
+	return &m_Current;
+}
+
+bool CNetServerIo::WaitForPackets(std::chrono::nanoseconds Timeout)
+{
+	if(!m_RecvQueue.Empty())
+		return true;
+	std::unique_lock<std::mutex> Lock(m_RecvMutex);
+	return m_RecvCond.wait_for(Lock, Timeout, [this]() { return !m_RecvQueue.Empty(); });
+}
+
+void CNetServerIo::Send(const NETADDR *pAddr, const void *pData, int Size)
+{
+	dbg_assert(Size <= NET_MAX_PACKETSIZE, "packet too big to queue: %d", Size);
+	CSendPacket *pPacket;
+	while(!(pPacket = m_SendQueue.Back()))
+	{
+		// the send thread is behind, make sure it runs and wait for it
+		WakeSendThread();
+		std::this_thread::yield();
+	}
+	pPacket->m_Addr = *pAddr;
+	pPacket->m_Size = Size;
+	mem_copy(pPacket->m_aData, pData, Size);
+	m_SendQueue.Push();
+
+	if(!m_Batching)
+		WakeSendThread();
+}
+
+void CNetServerIo::EndBatch()
+{
+	m_Batching = false;
+	WakeSendThread();
+}
+
+void CNetServerIo::WakeSendThread()
+{
+	{
+		std::unique_lock<std::mutex> Lock(m_SendMutex);
+		m_SendPending = true;
+	}
+	m_SendCond.notify_one();
+}
+
+void CNetServerIo::RecvThread()
+{
+	bool Backlog = false;
+	while(!m_Shutdown.load(std::memory_order_relaxed))
+	{
+		if(Backlog)
+		{
+			// the queue is full, leave the packets in the socket until the game thread catches up
+			std::this_thread::sleep_for(1ms);
+		}
+		else if(!net_socket_read_wait(m_Socket, 100ms))
+		{
+			continue;
+		}
+
+		Backlog = false;
+		int NumReceived = 0;
+		while(true)
+		{
+			CRecvPacket *pPacket = m_RecvQueue.Back();
+			if(!pPacket)
+			{
+				Backlog = true;
+				break;
+			}
+
+			unsigned char *pData;
+			const int Bytes = net_udp_recv(m_Socket, &pPacket->m_Addr, &pData);
+			if(Bytes <= 0)
+				break;
+			if(Bytes > NET_MAX_PACKETSIZE)
+				continue;
+
+			// unpack like CNetServer::Recv does for packets of non-sixup
+			// connections, which are almost all of them
+			pPacket->m_Size = Bytes;
+			mem_copy(pPacket->m_aData, pData, Bytes);
+			pPacket->m_Sixup = false;
+			pPacket->m_Token = NET_SECURITY_TOKEN_UNKNOWN;
+			pPacket->m_ResponseToken = NET_SECURITY_TOKEN_UNKNOWN;
+			pPacket->m_Result = CNetBase::UnpackPacket(pData, Bytes, &pPacket->m_Packet, pPacket->m_Sixup, &pPacket->m_Token, &pPacket->m_ResponseToken);
+			m_RecvQueue.Push();
+			NumReceived++;
+		}
+
+		if(NumReceived)
+		{
+			{
+				std::unique_lock<std::mutex> Lock(m_RecvMutex);
+			}
+			m_RecvCond.notify_one();
+		}
+	}
+}
+
+void CNetServerIo::SendThread()
+{
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(m_SendMutex);
+			m_SendCond.wait(Lock, [this]() { return m_SendPending; });
+			m_SendPending = false;
+		}
+
+		net_udp_batch_begin(m_Socket);
+		while(const CSendPacket *pPacket = m_SendQueue.Front())
+		{
+			net_udp_send(m_Socket, &pPacket->m_Addr, pPacket->m_aData, pPacket->m_Size);
+			m_SendQueue.Pop();
+		}
+		net_udp_batch_end(m_Socket);
+
+		if(m_Shutdown.load(std::memory_order_relaxed))
+			break;
+	}
+}
@@ -12,4 +12,5 @@ void CSnapshotBuilder::Init7(const CSnapshot *pSnapshot)
 	m_NumItems = pSnapshot->m_NumItems;
 	mem_copy(m_aOffsets, pSnapshot->Offsets(), sizeof(int) * m_NumItems);
 	mem_copy(m_aData, pSnapshot->DataStart(), m_DataSize);
+	m_KeyIndex.Build(pSnapshot);
 }
@@ -14,6 +14,20 @@
 #include <cstdlib>
 #include <limits>
 
+// Diffing items only needs wrapping integer add, sub and compares, the SIMD
+// paths produce exactly the same output as the scalar code. SSE2 is always
+// available on x86-64, AVX2 is used when the build targets it.
+#if defined(__AVX2__)
+#define SNAPSHOT_DELTA_AVX2
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64)
+#define SNAPSHOT_DELTA_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SNAPSHOT_DELTA_NEON
+#include <arm_neon.h>
+#endif
+
 // CSnapshot
 
 const CSnapshotItem *CSnapshot::GetItem(int Index) const
@@ -72,34 +86,38 @@ void CSnapshot::InvalidateItem(int Index)
 	((CSnapshotItem *)(DataStart() + Offsets()[Index]))->Invalidate();
 }
 
-const void *CSnapshot::FindItem(int Type, int Id) const
+int CSnapshot::GetInternalItemType(int Type) const
 {
-	int InternalType = Type;
-	if(Type >= OFFSET_UUID)
+	if(Type < OFFSET_UUID)
 	{
-		CUuid TypeUuid = g_UuidManager.GetUuid(Type);
-		int aTypeUuidItem[sizeof(CUuid) / sizeof(int32_t)];
-		for(size_t i = 0; i < sizeof(CUuid) / sizeof(int32_t); i++)
-			aTypeUuidItem[i] = bytes_be_to_uint(&TypeUuid.m_aData[i * sizeof(int32_t)]);
+		return Type;
+	}
+
+	CUuid TypeUuid = g_UuidManager.GetUuid(Type);
+	int aTypeUuidItem[sizeof(CUuid) / sizeof(int32_t)];
+	for(size_t i = 0; i < sizeof(CUuid) / sizeof(int32_t); i++)
+		aTypeUuidItem[i] = bytes_be_to_uint(&TypeUuid.m_aData[i * sizeof(int32_t)]);
 
-		bool Found = false;
-		for(int i = 0; i < m_NumItems; i++)
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		const CSnapshotItem *pItem = GetItem(i);
+		if(pItem->Type() == 0 && pItem->Id() >= OFFSET_UUID_TYPE) // NETOBJTYPE_EX
 		{
-			const CSnapshotItem *pItem = GetItem(i);
-			if(pItem->Type() == 0 && pItem->Id() >= OFFSET_UUID_TYPE) // NETOBJTYPE_EX
+			if(mem_comp(pItem->Data(), aTypeUuidItem, sizeof(CUuid)) == 0)
 			{
-				if(mem_comp(pItem->Data(), aTypeUuidItem, sizeof(CUuid)) == 0)
-				{
-					InternalType = pItem->Id();
-					Found = true;
-					break;
-				}
+				return pItem->Id();
 			}
 		}
-		if(!Found)
-		{
-			return nullptr;
-		}
+	}
+	return -1;
+}
+
+const void *CSnapshot::FindItem(int Type, int Id) const
+{
+	const int InternalType = GetInternalItemType(Type);
+	if(InternalType < 0)
+	{
+		return nullptr;
 	}
 	int Index = GetItemIndex((InternalType << 16) | Id);
 	return Index < 0 ? nullptr : GetItem(Index)->Data();
@@ -160,72 +178,189 @@ bool CSnapshot::IsValid(size_t ActualSize) const
 	return true;
 }
 
-// CSnapshotDelta
+// CSnapshotKeyIndex
 
-enum
+void CSnapshotKeyIndex::Clear()
 {
-	HASHLIST_SIZE = 256,
-	HASHLIST_BUCKET_SIZE = 64,
-};
+	mem_zero(m_aSlotItems, sizeof(m_aSlotItems));
+}
 
-struct CItemList
+void CSnapshotKeyIndex::Add(int Key, int Index)
 {
-	int m_Num;
-	int m_aKeys[HASHLIST_BUCKET_SIZE];
-	int m_aIndex[HASHLIST_BUCKET_SIZE];
-};
+	for(unsigned Slot = CSnapshotKeyIndex::Slot(Key);; Slot = (Slot + 1) % NUM_SLOTS)
+	{
+		if(m_aSlotItems[Slot] == 0)
+		{
+			m_aSlotKeys[Slot] = Key;
+			m_aSlotItems[Slot] = Index + 1;
+			return;
+		}
+		if(m_aSlotKeys[Slot] == Key)
+			return;
+	}
+}
 
-static inline size_t CalcHashId(int Key)
+int CSnapshotKeyIndex::Find(int Key) const
 {
-	// djb2 (http://www.cse.yorku.ca/~oz/hash.html)
-	unsigned Hash = 5381;
-	for(unsigned Shift = 0; Shift < sizeof(int); Shift++)
-		Hash = ((Hash << 5) + Hash) + ((Key >> (Shift * 8)) & 0xFF);
-	return Hash % HASHLIST_SIZE;
+	for(unsigned Slot = CSnapshotKeyIndex::Slot(Key);; Slot = (Slot + 1) % NUM_SLOTS)
+	{
+		if(m_aSlotItems[Slot] == 0)
+			return -1;
+		if(m_aSlotKeys[Slot] == Key)
+			return m_aSlotItems[Slot] - 1;
+	}
 }
 
-static void GenerateHash(CItemList *pHashlist, const CSnapshot *pSnapshot)
+void CSnapshotKeyIndex::Build(const CSnapshot *pSnapshot)
 {
-	for(int i = 0; i < HASHLIST_SIZE; i++)
-		pHashlist[i].m_Num = 0;
-
+	Clear();
 	for(int i = 0; i < pSnapshot->NumItems(); i++)
-	{
-		int Key = pSnapshot->GetItem(i)->Key();
-		size_t HashId = CalcHashId(Key);
-		if(pHashlist[HashId].m_Num < HASHLIST_BUCKET_SIZE)
-		{
-			pHashlist[HashId].m_aIndex[pHashlist[HashId].m_Num] = i;
-			pHashlist[HashId].m_aKeys[pHashlist[HashId].m_Num] = Key;
-			pHashlist[HashId].m_Num++;
-		}
-	}
+		Add(pSnapshot->GetItem(i)->Key(), i);
 }
 
-static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
+const void *CSnapshotKeyIndex::FindItem(const CSnapshot *pSnapshot, int Type, int Id) const
 {
-	size_t HashId = CalcHashId(Key);
-	for(int i = 0; i < pHashlist[HashId].m_Num; i++)
+	const int InternalType = pSnapshot->GetInternalItemType(Type);
+	if(InternalType < 0)
 	{
-		if(pHashlist[HashId].m_aKeys[i] == Key)
-			return pHashlist[HashId].m_aIndex[i];
+		return nullptr;
 	}
+	int Index = Find((InternalType << 16) | Id);
+	return Index < 0 ? nullptr : pSnapshot->GetItem(Index)->Data();
+}
 
-	return -1;
+// CSnapshotDelta
+
+namespace {
+
+// Number of bits an int of a delta costs, see CVariableInt::Pack
+int DiffDataBits(int Diff)
+{
+	if(Diff == 0)
+		return 1;
+	unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+	unsigned char *pEnd = CVariableInt::Pack(aBuf, Diff, sizeof(aBuf));
+	return (pEnd - (unsigned char *)aBuf) * 8;
+}
+
+#if defined(SNAPSHOT_DELTA_AVX2)
+class CIntLanes
+{
+public:
+	enum
+	{
+		NUM = 8,
+	};
+	typedef __m256i I;
+
+	static I Load(const int *pData) { return _mm256_loadu_si256((const __m256i *)pData); }
+	static void Store(int *pData, I Value) { _mm256_storeu_si256((__m256i *)pData, Value); }
+	static I Zero() { return _mm256_setzero_si256(); }
+	static I Set(int Value) { return _mm256_set1_epi32(Value); }
+	static I Add(I a, I b) { return _mm256_add_epi32(a, b); }
+	static I Sub(I a, I b) { return _mm256_sub_epi32(a, b); }
+	static I Or(I a, I b) { return _mm256_or_si256(a, b); }
+	static I And(I a, I b) { return _mm256_and_si256(a, b); }
+	static I Xor(I a, I b) { return _mm256_xor_si256(a, b); }
+	static I Sign(I a) { return _mm256_srai_epi32(a, 31); }
+	static I Shl3(I a) { return _mm256_slli_epi32(a, 3); }
+	static I Greater(I a, I b) { return _mm256_cmpgt_epi32(a, b); }
+	static I Equal(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+};
+#elif defined(SNAPSHOT_DELTA_SSE2)
+class CIntLanes
+{
+public:
+	enum
+	{
+		NUM = 4,
+	};
+	typedef __m128i I;
+
+	static I Load(const int *pData) { return _mm_loadu_si128((const __m128i *)pData); }
+	static void Store(int *pData, I Value) { _mm_storeu_si128((__m128i *)pData, Value); }
+	static I Zero() { return _mm_setzero_si128(); }
+	static I Set(int Value) { return _mm_set1_epi32(Value); }
+	static I Add(I a, I b) { return _mm_add_epi32(a, b); }
+	static I Sub(I a, I b) { return _mm_sub_epi32(a, b); }
+	static I Or(I a, I b) { return _mm_or_si128(a, b); }
+	static I And(I a, I b) { return _mm_and_si128(a, b); }
+	static I Xor(I a, I b) { return _mm_xor_si128(a, b); }
+	static I Sign(I a) { return _mm_srai_epi32(a, 31); }
+	static I Shl3(I a) { return _mm_slli_epi32(a, 3); }
+	static I Greater(I a, I b) { return _mm_cmpgt_epi32(a, b); }
+	static I Equal(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+};
+#elif defined(SNAPSHOT_DELTA_NEON)
+class CIntLanes
+{
+public:
+	enum
+	{
+		NUM = 4,
+	};
+	typedef int32x4_t I;
+
+	static I Load(const int *pData) { return vld1q_s32(pData); }
+	static void Store(int *pData, I Value) { vst1q_s32(pData, Value); }
+	static I Zero() { return vdupq_n_s32(0); }
+	static I Set(int Value) { return vdupq_n_s32(Value); }
+	static I Add(I a, I b) { return vaddq_s32(a, b); }
+	static I Sub(I a, I b) { return vsubq_s32(a, b); }
+	static I Or(I a, I b) { return vorrq_s32(a, b); }
+	static I And(I a, I b) { return vandq_s32(a, b); }
+	static I Xor(I a, I b) { return veorq_s32(a, b); }
+	static I Sign(I a) { return vshrq_n_s32(a, 31); }
+	static I Shl3(I a) { return vshlq_n_s32(a, 3); }
+	static I Greater(I a, I b) { return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }
+	static I Equal(I a, I b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+};
+#endif
+
+#if defined(SNAPSHOT_DELTA_AVX2) || defined(SNAPSHOT_DELTA_SSE2) || defined(SNAPSHOT_DELTA_NEON)
+#define SNAPSHOT_DELTA_SIMD
+
+// Same as DiffDataBits for every lane, compares produce -1 for true
+CIntLanes::I DiffDataBitsLanes(CIntLanes::I Diff)
+{
+	using L = CIntLanes;
+	// packed ints store the sign and 6 bits in the first byte and 7 bits in every further byte
+	const L::I Magnitude = L::Xor(Diff, L::Sign(Diff));
+	L::I Bytes = L::Set(1);
+	Bytes = L::Sub(Bytes, L::Greater(Magnitude, L::Set((1 << 6) - 1)));
+	Bytes = L::Sub(Bytes, L::Greater(Magnitude, L::Set((1 << 13) - 1)));
+	Bytes = L::Sub(Bytes, L::Greater(Magnitude, L::Set((1 << 20) - 1)));
+	Bytes = L::Sub(Bytes, L::Greater(Magnitude, L::Set((1 << 27) - 1)));
+	// unchanged ints cost a single bit instead of a byte
+	return L::Sub(L::Shl3(Bytes), L::And(L::Equal(Diff, L::Zero()), L::Set(7)));
 }
+#endif
+
+} // namespace
 
 int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
-	while(Size)
+	int i = 0;
+#if defined(SNAPSHOT_DELTA_SIMD)
+	using L = CIntLanes;
+	L::I NeededLanes = L::Zero();
+	for(; i + L::NUM <= Size; i += L::NUM)
+	{
+		const L::I Diff = L::Sub(L::Load(pCurrent + i), L::Load(pPast + i));
+		L::Store(pOut + i, Diff);
+		NeededLanes = L::Or(NeededLanes, Diff);
+	}
+	int aNeeded[L::NUM];
+	L::Store(aNeeded, NeededLanes);
+	for(int Lane = 0; Lane < L::NUM; Lane++)
+		Needed |= aNeeded[Lane];
+#endif
+	for(; i < Size; i++)
 	{
 		// subtraction with wrapping by casting to unsigned
-		*pOut = (unsigned)*pCurrent - (unsigned)*pPast;
-		Needed |= *pOut;
-		pOut++;
-		pPast++;
-		pCurrent++;
-		Size--;
+		pOut[i] = (unsigned)pCurrent[i] - (unsigned)pPast[i];
+		Needed |= pOut[i];
 	}
 
 	return Needed;
@@ -233,24 +368,27 @@ int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, i
 
 void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
 {
-	while(Size)
+	int i = 0;
+#if defined(SNAPSHOT_DELTA_SIMD)
+	using L = CIntLanes;
+	// at most 40 bits per int, items are far too small to overflow the lanes
+	L::I BitsLanes = L::Zero();
+	for(; i + L::NUM <= Size; i += L::NUM)
+	{
+		const L::I Diff = L::Load(pDiff + i);
+		L::Store(pOut + i, L::Add(L::Load(pPast + i), Diff));
+		BitsLanes = L::Add(BitsLanes, DiffDataBitsLanes(Diff));
+	}
+	int aBits[L::NUM];
+	L::Store(aBits, BitsLanes);
+	for(int Lane = 0; Lane < L::NUM; Lane++)
+		*pDataRate += aBits[Lane];
+#endif
+	for(; i < Size; i++)
 	{
 		// addition with wrapping by casting to unsigned
-		*pOut = (unsigned)*pPast + (unsigned)*pDiff;
-
-		if(*pDiff == 0)
-			*pDataRate += 1;
-		else
-		{
-			unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
-			unsigned char *pEnd = CVariableInt::Pack(aBuf, *pDiff, sizeof(aBuf));
-			*pDataRate += (uint64_t)(pEnd - (unsigned char *)aBuf) * 8;
-		}
-
-		pOut++;
-		pPast++;
-		pDiff++;
-		Size--;
+		pOut[i] = (unsigned)pPast[i] + (unsigned)pDiff[i];
+		*pDataRate += DiffDataBits(pDiff[i]);
 	}
 }
 
@@ -301,14 +439,14 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	pDelta->m_NumUpdateItems = 0;
 	pDelta->m_NumTempItems = 0;
 
-	CItemList aHashlist[HASHLIST_SIZE];
-	GenerateHash(aHashlist, pTo);
+	CSnapshotKeyIndex KeyIndex;
+	KeyIndex.Build(pTo);
 
 	// pack deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
-		if(GetItemIndexHashed(pFromItem->Key(), aHashlist) == -1)
+		if(KeyIndex.Find(pFromItem->Key()) == -1)
 		{
 			// deleted
 			pDelta->m_NumDeletedItems++;
@@ -317,7 +455,7 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 		}
 	}
 
-	GenerateHash(aHashlist, pFrom);
+	KeyIndex.Build(pFrom);
 
 	// fetch previous indices
 	// we do this as a separate pass because it helps the cache
@@ -325,8 +463,8 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	const int NumItems = pTo->NumItems();
 	for(int i = 0; i < NumItems; i++)
 	{
-		const CSnapshotItem *pCurItem = pTo->GetItem(i); // O(1) .. O(n)
-		aPastIndices[i] = GetItemIndexHashed(pCurItem->Key(), aHashlist); // O(n) .. O(n^n)
+		const CSnapshotItem *pCurItem = pTo->GetItem(i);
+		aPastIndices[i] = KeyIndex.Find(pCurItem->Key());
 	}
 
 	for(int i = 0; i < NumItems; i++)
@@ -516,6 +654,9 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 	CSnapshotBuilder Builder;
 	Builder.Init();
 
+	CSnapshotKeyIndex FromIndex;
+	FromIndex.Build(pFrom);
+
 	// unpack deleted stuff
 	int *pDeleted = pData;
 	if(pDelta->m_NumDeletedItems < 0)
@@ -590,11 +731,11 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 		if(!pNewData)
 			return -302;
 
-		const int FromIndex = pFrom->GetItemIndex(Key);
-		if(FromIndex != -1)
+		const int FromItemIndex = FromIndex.Find(Key);
+		if(FromItemIndex != -1)
 		{
 			// we got an update so we need to apply the diff
-			UndiffItem(pFrom->GetItem(FromIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
+			UndiffItem(pFrom->GetItem(FromItemIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
 		}
 		else // no previous, just copy the pData
 		{
@@ -625,6 +766,7 @@ void CSnapshotStorage::PurgeAll()
 		CHolder *pNext = m_pFirst->m_pNext;
 		free(m_pFirst->m_pSnap);
 		free(m_pFirst->m_pAltSnap);
+		delete m_pFirst->m_pAltSnapIndex;
 		free(m_pFirst);
 		m_pFirst = pNext;
 	}
@@ -642,6 +784,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 			return; // no more to remove
 		free(pHolder->m_pSnap);
 		free(pHolder->m_pAltSnap);
+		delete pHolder->m_pAltSnapIndex;
 		free(pHolder);
 
 		// did we come to the end of the list?
@@ -682,6 +825,8 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 		pHolder->m_pAltSnap = nullptr;
 		pHolder->m_AltSnapSize = 0;
 	}
+	pHolder->m_pAltSnapIndex = nullptr;
+	pHolder->m_AltSnapIndexValid = false;
 
 	// link
 	pHolder->m_pNext = nullptr;
@@ -693,6 +838,18 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	m_pLast = pHolder;
 }
 
+const CSnapshotKeyIndex &CSnapshotStorage::CHolder::AltSnapIndex()
+{
+	if(!m_pAltSnapIndex)
+		m_pAltSnapIndex = new CSnapshotKeyIndex();
+	if(!m_AltSnapIndexValid)
+	{
+		m_pAltSnapIndex->Build(m_pAltSnap);
+		m_AltSnapIndexValid = true;
+	}
+	return *m_pAltSnapIndex;
+}
+
 int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const
 {
 	CHolder *pHolder = m_pFirst;
@@ -727,6 +884,7 @@ void CSnapshotBuilder::Init(bool Sixup)
 	m_DataSize = 0;
 	m_NumItems = 0;
 	m_Sixup = Sixup;
+	m_KeyIndex.Clear();
 
 	for(int i = 0; i < m_NumExtendedItemTypes; i++)
 	{
@@ -741,15 +899,8 @@ CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 
 int *CSnapshotBuilder::GetItemData(int Key)
 {
-	for(int i = 0; i < m_NumItems; i++)
-	{
-		CSnapshotItem *pItem = GetItem(i);
-		if(pItem->Key() == Key)
-		{
-			return pItem->Data();
-		}
-	}
-	return nullptr;
+	const int Index = m_KeyIndex.Find(Key);
+	return Index < 0 ? nullptr : GetItem(Index)->Data();
 }
 
 int CSnapshotBuilder::Finish(void *pSnapData)
@@ -856,6 +1007,7 @@ void *CSnapshotBuilder::NewItem(int Type, int Id, int Size)
 		return nullptr;
 
 	pObj->m_TypeAndId = (Type << 16) | Id;
+	m_KeyIndex.Add(pObj->Key(), m_NumItems);
 	m_aOffsets[m_NumItems] = m_DataSize;
 	m_DataSize += ItemSize;
 	m_NumItems++;
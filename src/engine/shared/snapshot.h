@@ -60,6 +60,7 @@ public:
 	void InvalidateItem(int Index);
 	int GetItemType(int Index) const;
 	int GetExternalItemType(int InternalType) const;
+	int GetInternalItemType(int Type) const;
 	const void *FindItem(int Type, int Id) const;
 
 	unsigned Crc() const;
@@ -74,6 +75,34 @@ public:
 
 // CSnapshotDelta
 
+// Open addressing index from item keys to item indices, so items don't have to be searched linearly
+class CSnapshotKeyIndex
+{
+	enum
+	{
+		// power of two, at least twice CSnapshot::MAX_ITEMS to keep probe sequences short
+		NUM_SLOT_BITS = 11,
+		NUM_SLOTS = 1 << NUM_SLOT_BITS,
+	};
+	static_assert(NUM_SLOTS >= 2 * CSnapshot::MAX_ITEMS);
+
+	int m_aSlotKeys[NUM_SLOTS];
+	// item index + 1, 0 for empty slots
+	short m_aSlotItems[NUM_SLOTS];
+
+	static unsigned Slot(int Key) { return ((unsigned)Key * 2654435761u) >> (32 - NUM_SLOT_BITS); }
+
+public:
+	void Clear();
+	// if an item with the key was added already, it is kept
+	void Add(int Key, int Index);
+	int Find(int Key) const;
+
+	void Build(const CSnapshot *pSnapshot);
+	// same as CSnapshot::FindItem, the index must be built for the snapshot
+	const void *FindItem(const CSnapshot *pSnapshot, int Type, int Id) const;
+};
+
 class CSnapshotDelta
 {
 public:
@@ -97,10 +126,9 @@ private:
 	uint64_t m_aSnapshotDataUpdates[CSnapshot::MAX_TYPE + 1];
 	CData m_Empty;
 
-	static void UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate);
-
 public:
 	static int DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size);
+	static void UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate);
 	CSnapshotDelta();
 	CSnapshotDelta(const CSnapshotDelta &Old);
 	uint64_t GetDataRate(int Index) const { return m_aSnapshotDataRate[Index]; }
@@ -132,6 +160,11 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		// created when first needed, invalidate it when changing the alt snapshot
+		CSnapshotKeyIndex *m_pAltSnapIndex;
+		bool m_AltSnapIndexValid;
+		const CSnapshotKeyIndex &AltSnapIndex();
 	};
 
 	CHolder *m_pFirst;
@@ -162,6 +195,8 @@ class CSnapshotBuilder
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
 	int m_NumExtendedItemTypes;
 
+	CSnapshotKeyIndex m_KeyIndex;
+
 	bool AddExtendedItemType(int Index);
 	int GetExtendedItemTypeIndex(int TypeId);
 	int GetTypeFromIndex(int Index) const;
@@ -0,0 +1,100 @@
+#ifndef ENGINE_SHARED_SPSC_QUEUE_H
+#define ENGINE_SHARED_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * Bounded lock-free queue between exactly one producer thread and one
+ * consumer thread.
+ *
+ * The elements are allocated once and reused, so big elements can be
+ * filled and read in place: the producer writes the element returned by
+ * @link Back @endlink and publishes it with @link Push @endlink, the
+ * consumer reads the element returned by @link Front @endlink and hands
+ * it back with @link Pop @endlink.
+ */
+template<typename T>
+class CSpscQueue
+{
+public:
+	explicit CSpscQueue(size_t Capacity) :
+		m_Size(Capacity + 1), m_pElements(std::make_unique<T[]>(Capacity + 1))
+	{
+	}
+	CSpscQueue(const CSpscQueue &Other) = delete;
+	CSpscQueue &operator=(const CSpscQueue &Other) = delete;
+
+	/**
+	 * Producer only.
+	 *
+	 * @return The element to fill before calling @link Push @endlink, `nullptr` if the queue is full.
+	 */
+	T *Back()
+	{
+		const size_t Tail = m_Tail.load(std::memory_order_relaxed);
+		const size_t Next = Tail + 1 == m_Size ? 0 : Tail + 1;
+		if(Next == m_HeadCache)
+		{
+			m_HeadCache = m_Head.load(std::memory_order_acquire);
+			if(Next == m_HeadCache)
+				return nullptr;
+		}
+		return &m_pElements[Tail];
+	}
+
+	/**
+	 * Producer only. Publishes the element returned by the last call to @link Back @endlink.
+	 */
+	void Push()
+	{
+		const size_t Tail = m_Tail.load(std::memory_order_relaxed);
+		m_Tail.store(Tail + 1 == m_Size ? 0 : Tail + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Consumer only.
+	 *
+	 * @return The oldest element, `nullptr` if the queue is empty.
+	 */
+	T *Front()
+	{
+		const size_t Head = m_Head.load(std::memory_order_relaxed);
+		if(Head == m_TailCache)
+		{
+			m_TailCache = m_Tail.load(std::memory_order_acquire);
+			if(Head == m_TailCache)
+				return nullptr;
+		}
+		return &m_pElements[Head];
+	}
+
+	/**
+	 * Consumer only. Removes the element returned by the last call to @link Front @endlink.
+	 */
+	void Pop()
+	{
+		const size_t Head = m_Head.load(std::memory_order_relaxed);
+		m_Head.store(Head + 1 == m_Size ? 0 : Head + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @return Whether the queue was empty at some point during the call.
+	 */
+	bool Empty() const { return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire); }
+
+private:
+	// consumer side, the cached tail avoids touching the producer's cache line
+	alignas(64) std::atomic<size_t> m_Head{0};
+	size_t m_TailCache = 0;
+
+	// producer side
+	alignas(64) std::atomic<size_t> m_Tail{0};
+	size_t m_HeadCache = 0;
+
+	alignas(64) const size_t m_Size;
+	std::unique_ptr<T[]> m_pElements;
+};
+
+#endif
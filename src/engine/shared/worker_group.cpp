@@ -0,0 +1,92 @@
+#include "worker_group.h"
+
+CWorkerGroup::~CWorkerGroup()
+{
+	Shutdown();
+}
+
+void CWorkerGroup::Init(int NumThreads)
+{
+	Shutdown();
+	m_Shutdown = false;
+	m_vThreads.reserve(NumThreads);
+	// threads may only get to the lock after the first run has started
+	const uint64_t Generation = m_Generation;
+	for(int i = 0; i < NumThreads; i++)
+		m_vThreads.emplace_back([this, Generation]() { WorkerThread(Generation); });
+}
+
+void CWorkerGroup::Shutdown()
+{
+	if(m_vThreads.empty())
+		return;
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_Shutdown = true;
+	}
+	m_WorkCond.notify_all();
+	for(auto &Thread : m_vThreads)
+		Thread.join();
+	m_vThreads.clear();
+}
+
+void CWorkerGroup::Run(int NumItems, FWorkFunc pfnFunc, void *pUser)
+{
+	if(NumItems <= 0)
+		return;
+	if(m_vThreads.empty() || NumItems == 1)
+	{
+		for(int i = 0; i < NumItems; i++)
+			pfnFunc(pUser, i);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_NumItems = NumItems;
+		m_pfnFunc = pfnFunc;
+		m_pUser = pUser;
+		m_NextItem.store(0);
+		m_NumFinished = 0;
+		m_Generation++;
+	}
+	m_WorkCond.notify_all();
+
+	Work(NumItems, pfnFunc, pUser);
+
+	// all items are taken, but wait for every worker to finish this
+	// generation, otherwise a worker waking up late could take items of the
+	// next run with this run's function
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_DoneCond.wait(Lock, [this]() { return m_NumFinished == (int)m_vThreads.size(); });
+}
+
+void CWorkerGroup::WorkerThread(uint64_t SeenGeneration)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	while(true)
+	{
+		m_WorkCond.wait(Lock, [&]() { return m_Shutdown || m_Generation != SeenGeneration; });
+		if(m_Shutdown)
+			break;
+		SeenGeneration = m_Generation;
+		const int NumItems = m_NumItems;
+		FWorkFunc pfnFunc = m_pfnFunc;
+		void *pUser = m_pUser;
+
+		Lock.unlock();
+		Work(NumItems, pfnFunc, pUser);
+		Lock.lock();
+
+		m_NumFinished++;
+		if(m_NumFinished == (int)m_vThreads.size())
+			m_DoneCond.notify_all();
+	}
+}
+
+void CWorkerGroup::Work(int NumItems, FWorkFunc pfnFunc, void *pUser)
+{
+	int Index;
+	while((Index = m_NextItem.fetch_add(1)) < NumItems)
+		pfnFunc(pUser, Index);
+}
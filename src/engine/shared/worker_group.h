@@ -0,0 +1,74 @@
+#ifndef ENGINE_SHARED_WORKER_GROUP_H
+#define ENGINE_SHARED_WORKER_GROUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A small set of dedicated worker threads for splitting short, latency
+ * sensitive work (e.g. one game tick) into independent items.
+ *
+ * Unlike @link CJobPool @endlink, running work does not allocate and the
+ * calling thread takes part in processing the items, so it is suitable
+ * for being called every tick.
+ */
+class CWorkerGroup
+{
+public:
+	typedef void (*FWorkFunc)(void *pUser, int Index);
+
+	CWorkerGroup() = default;
+	~CWorkerGroup();
+	CWorkerGroup(const CWorkerGroup &Other) = delete;
+	CWorkerGroup &operator=(const CWorkerGroup &Other) = delete;
+
+	/**
+	 * Starts the given number of worker threads, stopping the previous ones.
+	 *
+	 * @param NumThreads Number of additional threads, `0` runs all work on the calling thread.
+	 */
+	void Init(int NumThreads);
+
+	/**
+	 * Stops and joins all worker threads.
+	 */
+	void Shutdown();
+
+	/**
+	 * @return The number of additional worker threads.
+	 */
+	int NumThreads() const { return m_vThreads.size(); }
+
+	/**
+	 * Calls `pfnFunc(pUser, Index)` for every index in `[0, NumItems)`,
+	 * distributed over the worker threads and the calling thread. Returns
+	 * after all items have been processed.
+	 *
+	 * @remark Items must not depend on each other, the order in which they
+	 * are processed is not defined.
+	 */
+	void Run(int NumItems, FWorkFunc pfnFunc, void *pUser);
+
+private:
+	void WorkerThread(uint64_t SeenGeneration);
+	void Work(int NumItems, FWorkFunc pfnFunc, void *pUser);
+
+	std::vector<std::thread> m_vThreads;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkCond;
+	std::condition_variable m_DoneCond;
+	bool m_Shutdown = false;
+	uint64_t m_Generation = 0;
+	int m_NumFinished = 0;
+
+	int m_NumItems = 0;
+	FWorkFunc m_pfnFunc = nullptr;
+	void *m_pUser = nullptr;
+	std::atomic<int> m_NextItem = 0;
+};
+
+#endif
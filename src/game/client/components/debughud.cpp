@@ -75,9 +75,19 @@ void CDebugHud::RenderNetCorrections()
 	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->m_Snap.m_pLocalCharacter->m_Angle);
 	RenderRow("Angle:", aBuf);
 
+	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->PredictionTicksSimulated());
+	RenderRow("Predicted ticks:", aBuf);
+
 	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->NetobjNumCorrections());
 	RenderRow("Netobj corrections", aBuf);
 	RenderRow(" on:", GameClient()->NetobjCorrectedOn());
+
+	// TClient
+	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->m_Trails.NumVertices());
+	RenderRow("Trail vertices:", aBuf);
+
+	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->m_Trails.NumDrawCalls());
+	RenderRow("Trail draw calls:", aBuf);
 }
 
 void CDebugHud::RenderTuning()
@@ -27,6 +27,7 @@
 
 #include <chrono>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -464,7 +465,13 @@ protected:
 	int m_SkipDurationIndex = DEFAULT_SKIP_DURATION_INDEX;
 	static bool DemoFilterChat(const void *pData, int Size, void *pUser);
 	bool FetchHeader(CDemoItem &Item);
+	// demo infos are fetched by jobs and added to the list as they arrive
+	class CDemoInfoJob;
+	std::vector<std::shared_ptr<CDemoInfoJob>> m_vpDemoInfoJobs;
 	void FetchAllHeaders();
+	void UpdateDemoInfoJobs();
+	void AbortDemoInfoJobs();
+	void SortDemos();
 	void HandleDemoSeeking(float PositionToSeek, float TimeToSeek);
 	void RenderDemoPlayer(CUIRect MainView);
 	void RenderDemoPlayerSliceSavePopup(CUIRect MainView);
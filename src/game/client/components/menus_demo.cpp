@@ -10,8 +10,11 @@
 
 #include <engine/client.h>
 #include <engine/demo.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/keys.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/localization.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
@@ -24,6 +27,7 @@
 #include <game/client/ui_listbox.h>
 #include <game/localization.h>
 
+#include <atomic>
 #include <chrono>
 
 using namespace FontIcons;
@@ -938,6 +942,7 @@ int CMenus::DemolistFetchCallback(const CFsFileInfo *pInfo, int IsDir, int Stora
 		str_truncate(Item.m_aName, sizeof(Item.m_aName), pInfo->m_pName, str_length(pInfo->m_pName) - str_length(".demo"));
 		Item.m_Date = pInfo->m_TimeModified;
 	}
+	Item.m_Size = pInfo->m_Size;
 	Item.m_InfosLoaded = false;
 	Item.m_Valid = false;
 	Item.m_IsDir = IsDir != 0;
@@ -955,6 +960,7 @@ int CMenus::DemolistFetchCallback(const CFsFileInfo *pInfo, int IsDir, int Stora
 
 void CMenus::DemolistPopulate()
 {
+	AbortDemoInfoJobs();
 	m_vDemos.clear();
 
 	int NumStoragesWithDemos = 0;
@@ -1005,10 +1011,10 @@ void CMenus::DemolistPopulate()
 		m_DemoPopulateStartTime = time_get_nanoseconds();
 		Storage()->ListDirectoryInfo(m_DemolistStorageType, m_aCurrentDemoFolder, DemolistFetchCallback, this);
 
+		SortDemos();
+
 		if(g_Config.m_BrDemoFetchInfo)
 			FetchAllHeaders();
-
-		std::stable_sort(m_vDemos.begin(), m_vDemos.end());
 	}
 	RefreshFilteredDemos();
 }
@@ -1062,32 +1068,190 @@ void CMenus::DemolistOnUpdate(bool Reset)
 		m_DemolistSelectedReveal = true;
 }
 
+static bool FetchDemoInfo(IStorage *pStorage, const IDemoPlayer *pDemoPlayer, const char *pFilename, int StorageType, time_t Modified, int64_t *pSize, CDemoHeader *pInfo, CTimelineMarkers *pTimelineMarkers, CMapInfo *pMapInfo)
+{
+	// the index next to the demo has the same infos, if it is up to date
+	CDemoIndex Index;
+	if(*pSize >= 0 && Index.Load(pStorage, pFilename, StorageType, *pSize, Modified))
+	{
+		*pInfo = Index.m_Header;
+		*pTimelineMarkers = Index.m_TimelineMarkers;
+		Index.MapInfo(pMapInfo);
+		return true;
+	}
+
+	IOHANDLE File;
+	if(!pDemoPlayer->GetDemoInfo(pStorage, nullptr, pFilename, StorageType, pInfo, pTimelineMarkers, pMapInfo, &File))
+		return false;
+	if(File)
+	{
+		*pSize = io_length(File);
+		io_close(File);
+	}
+	return true;
+}
+
+class CMenus::CDemoInfoJob : public IJob
+{
+	IStorage *m_pStorage;
+	const IDemoPlayer *m_pDemoPlayer;
+
+	void Run() override
+	{
+		for(CEntry &Entry : m_vEntries)
+		{
+			if(State() == IJob::STATE_ABORTED)
+				return;
+			Entry.m_Valid = FetchDemoInfo(m_pStorage, m_pDemoPlayer, Entry.m_aFilename, Entry.m_StorageType, Entry.m_Date, &Entry.m_Size, &Entry.m_Info, &Entry.m_TimelineMarkers, &Entry.m_MapInfo);
+			m_NumDone.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+public:
+	enum
+	{
+		MAX_ENTRIES = 64,
+	};
+
+	class CEntry
+	{
+	public:
+		// position of the item in m_vDemos, only used on the main thread
+		size_t m_Position;
+		char m_aFilename[IO_MAX_PATH_LENGTH];
+		int m_StorageType;
+		time_t m_Date;
+		int64_t m_Size;
+
+		bool m_Valid;
+		CDemoHeader m_Info;
+		CTimelineMarkers m_TimelineMarkers;
+		CMapInfo m_MapInfo;
+	};
+	std::vector<CEntry> m_vEntries;
+	std::atomic<size_t> m_NumDone = 0;
+	size_t m_NumApplied = 0;
+
+	CDemoInfoJob(IStorage *pStorage, const IDemoPlayer *pDemoPlayer) :
+		m_pStorage(pStorage), m_pDemoPlayer(pDemoPlayer)
+	{
+		Abortable(true);
+	}
+};
+
 bool CMenus::FetchHeader(CDemoItem &Item)
 {
 	if(!Item.m_InfosLoaded)
 	{
 		char aBuffer[IO_MAX_PATH_LENGTH];
 		str_format(aBuffer, sizeof(aBuffer), "%s/%s", m_aCurrentDemoFolder, Item.m_aFilename);
-		IOHANDLE File;
-		Item.m_Valid = DemoPlayer()->GetDemoInfo(Storage(), nullptr, aBuffer, Item.m_StorageType, &Item.m_Info, &Item.m_TimelineMarkers, &Item.m_MapInfo, &File);
+		Item.m_Valid = FetchDemoInfo(Storage(), DemoPlayer(), aBuffer, Item.m_StorageType, Item.m_Date, &Item.m_Size, &Item.m_Info, &Item.m_TimelineMarkers, &Item.m_MapInfo);
 		Item.m_InfosLoaded = true;
+	}
+	return Item.m_Valid;
+}
+
+void CMenus::FetchAllHeaders()
+{
+	AbortDemoInfoJobs();
+
+	std::shared_ptr<CDemoInfoJob> pJob;
+	const auto &AddJob = [&]() {
+		Engine()->AddJob(pJob);
+		m_vpDemoInfoJobs.push_back(std::move(pJob));
+		pJob = nullptr;
+	};
+	for(size_t Position = 0; Position < m_vDemos.size(); Position++)
+	{
+		const CDemoItem &Item = m_vDemos[Position];
+		if(Item.m_IsDir || Item.m_InfosLoaded)
+			continue;
+
+		if(!pJob)
+			pJob = std::make_shared<CDemoInfoJob>(Storage(), DemoPlayer());
+		CDemoInfoJob::CEntry &Entry = pJob->m_vEntries.emplace_back();
+		Entry.m_Position = Position;
+		str_format(Entry.m_aFilename, sizeof(Entry.m_aFilename), "%s/%s", m_aCurrentDemoFolder, Item.m_aFilename);
+		Entry.m_StorageType = Item.m_StorageType;
+		Entry.m_Date = Item.m_Date;
+		Entry.m_Size = Item.m_Size;
+		if(pJob->m_vEntries.size() == CDemoInfoJob::MAX_ENTRIES)
+			AddJob();
+	}
+	if(pJob)
+		AddJob();
+}
+
+void CMenus::UpdateDemoInfoJobs()
+{
+	if(m_vpDemoInfoJobs.empty())
+		return;
+
+	bool AllDone = true;
+	for(const auto &pJob : m_vpDemoInfoJobs)
+	{
+		const size_t NumDone = pJob->m_NumDone.load(std::memory_order_acquire);
+		for(; pJob->m_NumApplied < NumDone; pJob->m_NumApplied++)
+		{
+			const CDemoInfoJob::CEntry &Entry = pJob->m_vEntries[pJob->m_NumApplied];
+			CDemoItem &Item = m_vDemos[Entry.m_Position];
+			if(Item.m_InfosLoaded)
+				continue;
+			Item.m_Valid = Entry.m_Valid;
+			Item.m_Size = Entry.m_Size;
+			Item.m_Info = Entry.m_Info;
+			Item.m_TimelineMarkers = Entry.m_TimelineMarkers;
+			Item.m_MapInfo = Entry.m_MapInfo;
+			Item.m_InfosLoaded = true;
+		}
+		if(pJob->m_NumApplied < pJob->m_vEntries.size())
+			AllDone = false;
+	}
 
-		if(Item.m_Valid && File)
+	if(AllDone)
+	{
+		m_vpDemoInfoJobs.clear();
+		if(g_Config.m_BrDemoSort == SORT_MARKERS || g_Config.m_BrDemoSort == SORT_LENGTH)
 		{
-			Item.m_Size = io_length(File);
-			io_close(File);
+			SortDemos();
+			DemolistOnUpdate(false);
 		}
 	}
-	return Item.m_Valid;
 }
 
-void CMenus::FetchAllHeaders()
+void CMenus::AbortDemoInfoJobs()
 {
-	for(auto &Item : m_vDemos)
+	for(const auto &pJob : m_vpDemoInfoJobs)
+		pJob->Abort();
+	m_vpDemoInfoJobs.clear();
+}
+
+void CMenus::SortDemos()
+{
+	// sort the positions, so the ones in pending info jobs can be updated
+	std::vector<size_t> vOrder(m_vDemos.size());
+	for(size_t i = 0; i < vOrder.size(); i++)
+		vOrder[i] = i;
+	std::stable_sort(vOrder.begin(), vOrder.end(), [&](size_t Left, size_t Right) {
+		return m_vDemos[Left] < m_vDemos[Right];
+	});
+
+	std::vector<CDemoItem> vSorted;
+	vSorted.reserve(m_vDemos.size());
+	std::vector<size_t> vNewPosition(m_vDemos.size());
+	for(size_t Position : vOrder)
+	{
+		vNewPosition[Position] = vSorted.size();
+		vSorted.push_back(m_vDemos[Position]);
+	}
+	// copy back instead of swapping, pointers into m_vDemos stay valid
+	std::copy(vSorted.begin(), vSorted.end(), m_vDemos.begin());
+
+	for(const auto &pJob : m_vpDemoInfoJobs)
 	{
-		FetchHeader(Item);
+		for(CDemoInfoJob::CEntry &Entry : pJob->m_vEntries)
+			Entry.m_Position = vNewPosition[Entry.m_Position];
 	}
-	std::stable_sort(m_vDemos.begin(), m_vDemos.end());
 }
 
 void CMenus::RenderDemoBrowser(CUIRect MainView)
@@ -1115,6 +1279,7 @@ void CMenus::RenderDemoBrowserList(CUIRect ListView, bool &WasListboxItemActivat
 		DemolistOnUpdate(true);
 		m_DemoBrowserListInitialized = true;
 	}
+	UpdateDemoInfoJobs();
 
 #if defined(CONF_VIDEORECORDER)
 	if(!m_DemoRenderInput.IsEmpty())
@@ -1221,7 +1386,7 @@ void CMenus::RenderDemoBrowserList(CUIRect ListView, bool &WasListboxItemActivat
 					g_Config.m_BrDemoSortOrder = 0;
 				g_Config.m_BrDemoSort = Col.m_Sort;
 				// Don't rescan in order to keep fetched headers, just resort
-				std::stable_sort(m_vDemos.begin(), m_vDemos.end());
+				SortDemos();
 				DemolistOnUpdate(false);
 			}
 		}
@@ -1670,6 +1835,7 @@ void CMenus::PopupConfirmDeleteDemo()
 	str_format(aBuf, sizeof(aBuf), "%s/%s", m_aCurrentDemoFolder, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_aFilename);
 	if(Storage()->RemoveFile(aBuf, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
 	{
+		CDemoIndex::Remove(Storage(), aBuf, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType);
 		DemolistPopulate();
 		DemolistOnUpdate(false);
 	}
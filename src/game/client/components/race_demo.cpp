@@ -5,6 +5,7 @@
 #include <base/system.h>
 
 #include <engine/shared/config.h>
+#include <engine/shared/demo.h>
 #include <engine/storage.h>
 
 #include <game/client/gameclient.h>
@@ -179,9 +180,13 @@ void CRaceDemo::StopRecord(int Time)
 			GetPath(aNewFilename, sizeof(aNewFilename), m_Time);
 
 			Storage()->RenameFile(m_aTmpFilename, aNewFilename, IStorage::TYPE_SAVE);
+			CDemoIndex::Rename(Storage(), m_aTmpFilename, aNewFilename, IStorage::TYPE_SAVE);
 		}
 		else // no new record
+		{
 			Storage()->RemoveFile(m_aTmpFilename, IStorage::TYPE_SAVE);
+			CDemoIndex::Remove(Storage(), m_aTmpFilename, IStorage::TYPE_SAVE);
+		}
 
 		m_aTmpFilename[0] = '\0';
 	}
@@ -258,6 +263,7 @@ bool CRaceDemo::CheckDemo(int Time)
 		char aFilename[IO_MAX_PATH_LENGTH];
 		str_format(aFilename, sizeof(aFilename), "%s/%s.demo", ms_pRaceDemoDir, Demo.m_aName);
 		Storage()->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+		CDemoIndex::Remove(Storage(), aFilename, IStorage::TYPE_SAVE);
 	}
 
 	return true;
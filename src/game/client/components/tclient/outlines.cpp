@@ -1,5 +1,6 @@
 #include "outlines.h"
 
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
 
@@ -8,6 +9,8 @@
 #include <game/client/render.h>
 #include <game/mapitems.h>
 
+#include <algorithm>
+
 // The order of this is the order of priority for outlines
 enum
 {
@@ -19,6 +22,19 @@ enum
 	OUTLINE_SOLID,
 };
 
+static_assert(OUTLINE_SOLID + 1 == COutlines::NUM_OUTLINE_TYPES);
+
+enum
+{
+	// QuadContainerAddQuads rejects containers bigger than this
+	MAX_QUADS_PER_CONTAINER = 30000,
+	// the fallback renderer draws at most 32k vertices per call
+	MAX_QUADS_PER_DRAW = 5000,
+	MAX_MESH_JOBS = 8,
+};
+
+static constexpr float TILE_SCALE = 32.0f;
+
 enum class OutlineLayer
 {
 	GAME,
@@ -100,13 +116,240 @@ public:
 // The order of this determines order of priority into the one map (tele + freeze = tele)
 static constexpr COutLineLayer OUTLINE_LAYERS[] = {{OutlineLayer::TELE}, {OutlineLayer::GAME}, {OutlineLayer::FRONT}};
 
-void COutlines::OnMapLoad()
+COutlines::CMeshJob::CMeshJob(std::shared_ptr<const std::vector<int>> pMapData, ivec2 MapDataSize, const COutlineStyles &Styles, int ChunkRowBegin, int ChunkRowEnd) :
+	m_Styles(Styles),
+	m_ChunkRowBegin(ChunkRowBegin),
+	m_ChunkRowEnd(ChunkRowEnd),
+	m_pMapData(std::move(pMapData)),
+	m_MapDataSize(MapDataSize)
+{
+}
+
+int COutlines::CMeshJob::GetTile(int x, int y) const
+{
+	x = std::clamp(x, 0, m_MapDataSize.x - 1);
+	y = std::clamp(y, 0, m_MapDataSize.y - 1);
+	return (*m_pMapData)[y * m_MapDataSize.x + x];
+}
+
+void COutlines::CMeshJob::Run()
+{
+	const int NumChunksX = (m_MapDataSize.x + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	for(int ChunkY = m_ChunkRowBegin; ChunkY < m_ChunkRowEnd; ++ChunkY)
+	{
+		for(int ChunkX = 0; ChunkX < NumChunksX; ++ChunkX)
+		{
+			if(State() == IJob::STATE_ABORTED)
+				return;
+			MeshChunk(ChunkX, ChunkY);
+		}
+	}
+}
+
+void COutlines::CMeshJob::MeshChunk(int ChunkX, int ChunkY)
+{
+	// Edges of neighbouring tiles with the same type are merged into one quad:
+	// top and bottom edges along a row, full height left and right edges along a column
+	class CRun
+	{
+	public:
+		int m_Type = OUTLINE_NONE;
+		int m_Quad = -1;
+	};
+	std::vector<IGraphics::CQuadItem> avQuads[NUM_OUTLINE_TYPES];
+	CRun aLeftRuns[CHUNK_SIZE];
+	CRun aRightRuns[CHUNK_SIZE];
+
+	// Extends the run if it continues with the same type, otherwise starts a new one
+	auto AddRun = [&](CRun &Run, int Type, const IGraphics::CQuadItem &Quad, bool Horizontal) {
+		if(Run.m_Type == Type && Run.m_Quad >= 0)
+		{
+			if(Horizontal)
+				avQuads[Type][Run.m_Quad].m_Width += Quad.m_Width;
+			else
+				avQuads[Type][Run.m_Quad].m_Height += Quad.m_Height;
+			return;
+		}
+		Run.m_Type = Type;
+		Run.m_Quad = avQuads[Type].size();
+		avQuads[Type].push_back(Quad);
+	};
+
+	const int StartX = ChunkX * CHUNK_SIZE;
+	const int StartY = ChunkY * CHUNK_SIZE;
+	const int EndX = std::min(StartX + CHUNK_SIZE, m_MapDataSize.x);
+	const int EndY = std::min(StartY + CHUNK_SIZE, m_MapDataSize.y);
+	const float Scale = TILE_SCALE;
+	for(int y = StartY; y < EndY; y++)
+	{
+		CRun TopRun;
+		CRun BottomRun;
+		for(int x = StartX; x < EndX; x++)
+		{
+			CRun &LeftRun = aLeftRuns[x - StartX];
+			CRun &RightRun = aRightRuns[x - StartX];
+			const int Type = GetTile(x, y);
+			const COutlineStyle &Style = m_Styles[Type];
+			if(Type == OUTLINE_NONE || !Style.m_Enable || Style.m_Width <= 0)
+			{
+				TopRun = BottomRun = LeftRun = RightRun = CRun();
+				continue;
+			}
+			const float Width = Style.m_Width;
+			std::vector<IGraphics::CQuadItem> &vQuads = avQuads[Type];
+			// Find neighbours
+			const bool aNeighbors[8] = {
+				GetTile(x - 1, y - 1) >= Type,
+				GetTile(x - 0, y - 1) >= Type,
+				GetTile(x + 1, y - 1) >= Type,
+				GetTile(x - 1, y + 0) >= Type,
+				GetTile(x + 1, y + 0) >= Type,
+				GetTile(x - 1, y + 1) >= Type,
+				GetTile(x + 0, y + 1) >= Type,
+				GetTile(x + 1, y + 1) >= Type,
+			};
+			// Lone corners first
+			if(!aNeighbors[0] && aNeighbors[1] && aNeighbors[3])
+				vQuads.emplace_back(x * Scale, y * Scale, Width, Width);
+			if(!aNeighbors[2] && aNeighbors[1] && aNeighbors[4])
+				vQuads.emplace_back(x * Scale + Scale - Width, y * Scale, Width, Width);
+			if(!aNeighbors[5] && aNeighbors[3] && aNeighbors[6])
+				vQuads.emplace_back(x * Scale, y * Scale + Scale - Width, Width, Width);
+			if(!aNeighbors[7] && aNeighbors[6] && aNeighbors[4])
+				vQuads.emplace_back(x * Scale + Scale - Width, y * Scale + Scale - Width, Width, Width);
+			// Top
+			if(!aNeighbors[1])
+				AddRun(TopRun, Type, IGraphics::CQuadItem(x * Scale, y * Scale, Scale, Width), true);
+			else
+				TopRun = CRun();
+			// Bottom
+			if(!aNeighbors[6])
+				AddRun(BottomRun, Type, IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Width, Scale, Width), true);
+			else
+				BottomRun = CRun();
+			// Left
+			if(!aNeighbors[3] && aNeighbors[1] && aNeighbors[6])
+				AddRun(LeftRun, Type, IGraphics::CQuadItem(x * Scale, y * Scale, Width, Scale), false);
+			else
+			{
+				LeftRun = CRun();
+				if(!aNeighbors[3])
+				{
+					if(aNeighbors[6])
+						vQuads.emplace_back(x * Scale, y * Scale + Width, Width, Scale - Width);
+					else if(aNeighbors[1])
+						vQuads.emplace_back(x * Scale, y * Scale, Width, Scale - Width);
+					else
+						vQuads.emplace_back(x * Scale, y * Scale + Width, Width, Scale - Width * 2.0f);
+				}
+			}
+			// Right
+			if(!aNeighbors[4] && aNeighbors[1] && aNeighbors[6])
+				AddRun(RightRun, Type, IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale, Width, Scale), false);
+			else
+			{
+				RightRun = CRun();
+				if(!aNeighbors[4])
+				{
+					if(aNeighbors[6])
+						vQuads.emplace_back(x * Scale + Scale - Width, y * Scale + Width, Width, Scale - Width);
+					else if(aNeighbors[1])
+						vQuads.emplace_back(x * Scale + Scale - Width, y * Scale, Width, Scale - Width);
+					else
+						vQuads.emplace_back(x * Scale + Scale - Width, y * Scale + Width, Width, Scale - Width * 2.0f);
+				}
+			}
+		}
+	}
+
+	std::array<int, NUM_OUTLINE_TYPES> aNumQuads;
+	for(int Type = 0; Type < NUM_OUTLINE_TYPES; ++Type)
+	{
+		aNumQuads[Type] = avQuads[Type].size();
+		m_vQuads.insert(m_vQuads.end(), avQuads[Type].begin(), avQuads[Type].end());
+	}
+	m_vChunkNumQuads.push_back(aNumQuads);
+}
+
+COutlines::COutlineStyles COutlines::CurrentStyles()
+{
+	COutlineStyles Styles;
+	Styles[OUTLINE_SOLID] = {(bool)g_Config.m_TcOutlineSolid, g_Config.m_TcOutlineWidthSolid, g_Config.m_TcOutlineColorSolid};
+	Styles[OUTLINE_FREEZE] = {(bool)g_Config.m_TcOutlineFreeze, g_Config.m_TcOutlineWidthFreeze, g_Config.m_TcOutlineColorFreeze};
+	Styles[OUTLINE_UNFREEZE] = {(bool)g_Config.m_TcOutlineUnfreeze, g_Config.m_TcOutlineWidthUnfreeze, g_Config.m_TcOutlineColorUnfreeze};
+	Styles[OUTLINE_KILL] = {(bool)g_Config.m_TcOutlineKill, g_Config.m_TcOutlineWidthKill, g_Config.m_TcOutlineColorKill};
+	Styles[OUTLINE_TELE] = {(bool)g_Config.m_TcOutlineTele, g_Config.m_TcOutlineWidthTele, g_Config.m_TcOutlineColorTele};
+	return Styles;
+}
+
+void COutlines::StartMeshJobs(const COutlineStyles &Styles)
 {
-	if(m_pMapData)
+	const int NumJobs = std::clamp(m_NumChunks.y, 1, (int)MAX_MESH_JOBS);
+	for(int i = 0; i < NumJobs; ++i)
 	{
-		delete[] m_pMapData;
-		m_pMapData = nullptr;
+		const int RowBegin = m_NumChunks.y * i / NumJobs;
+		const int RowEnd = m_NumChunks.y * (i + 1) / NumJobs;
+		m_vpMeshJobs.push_back(std::make_shared<CMeshJob>(m_pMapData, m_MapDataSize, Styles, RowBegin, RowEnd));
+		Engine()->AddJob(m_vpMeshJobs.back());
 	}
+}
+
+void COutlines::UploadMesh()
+{
+	ClearMesh();
+	m_vChunks.resize((size_t)m_NumChunks.x * m_NumChunks.y);
+	int Container = -1;
+	int ContainerNumQuads = 0;
+	size_t Chunk = 0;
+	for(const auto &pJob : m_vpMeshJobs)
+	{
+		int Quad = 0;
+		for(const auto &aNumQuads : pJob->m_vChunkNumQuads)
+		{
+			int ChunkNumQuads = 0;
+			for(int NumQuads : aNumQuads)
+				ChunkNumQuads += NumQuads;
+			if(Container == -1 || ContainerNumQuads + ChunkNumQuads > MAX_QUADS_PER_CONTAINER)
+			{
+				if(Container != -1)
+					Graphics()->QuadContainerUpload(Container);
+				Container = Graphics()->CreateQuadContainer(false);
+				m_vQuadContainers.push_back(Container);
+				ContainerNumQuads = 0;
+			}
+			m_vChunks[Chunk++] = {Container, ContainerNumQuads, ChunkNumQuads};
+			for(int Type = 0; Type < NUM_OUTLINE_TYPES; ++Type)
+			{
+				if(aNumQuads[Type] <= 0)
+					continue;
+				Graphics()->SetColor(color_cast<ColorRGBA>(ColorHSLA(pJob->m_Styles[Type].m_Color, true)));
+				Graphics()->QuadContainerAddQuads(Container, &pJob->m_vQuads[Quad], aNumQuads[Type]);
+				Quad += aNumQuads[Type];
+			}
+			ContainerNumQuads += ChunkNumQuads;
+		}
+	}
+	if(Container != -1)
+		Graphics()->QuadContainerUpload(Container);
+	Graphics()->SetColor(1.0f, 1.0f, 1.0f, 1.0f);
+	m_MeshStyles = m_vpMeshJobs.front()->m_Styles;
+	m_vpMeshJobs.clear();
+}
+
+void COutlines::ClearMesh()
+{
+	for(int &Container : m_vQuadContainers)
+		Graphics()->DeleteQuadContainer(Container);
+	m_vQuadContainers.clear();
+	m_vChunks.clear();
+}
+
+void COutlines::OnMapLoad()
+{
+	// Jobs of the previous map only hold their own copy of the map data and are left to finish
+	m_vpMeshJobs.clear();
+	ClearMesh();
+	m_pMapData = nullptr;
 
 	// Find valid layers and size
 	std::vector<const COutLineLayer *> vValidOutlineLayers;
@@ -123,19 +366,34 @@ void COutlines::OnMapLoad()
 	}
 	if(m_MapDataSize.x <= 0 || m_MapDataSize.y <= 0)
 		return;
-	m_pMapData = new int[m_MapDataSize.x * m_MapDataSize.y](OUTLINE_NONE);
+	auto pMapData = std::make_shared<std::vector<int>>((size_t)m_MapDataSize.x * m_MapDataSize.y, OUTLINE_NONE);
 
 	// Do it
 	for(const auto *pLayer : vValidOutlineLayers)
 	{
-		pLayer->SetData(GameClient(), m_pMapData, m_MapDataSize);
+		pLayer->SetData(GameClient(), pMapData->data(), m_MapDataSize);
 	}
+	m_pMapData = std::move(pMapData);
+
+	// Edges are found and merged in the background
+	m_NumChunks = (m_MapDataSize + ivec2(CHUNK_SIZE - 1, CHUNK_SIZE - 1)) / CHUNK_SIZE;
+	StartMeshJobs(CurrentStyles());
 }
 
 void COutlines::OnRender()
 {
 	if(!m_pMapData)
 		return;
+
+	// The old mesh is drawn until the new one is ready
+	if(!m_vpMeshJobs.empty() && std::all_of(m_vpMeshJobs.begin(), m_vpMeshJobs.end(), [](const auto &pJob) { return pJob->Done(); }))
+		UploadMesh();
+	const COutlineStyles Styles = CurrentStyles();
+	if(m_vpMeshJobs.empty() && !(Styles == m_MeshStyles))
+		StartMeshJobs(Styles);
+
+	if(m_vChunks.empty())
+		return;
 	if(GameClient()->m_MapLayersBackground.m_OnlineOnly && Client()->State() != IClient::STATE_ONLINE && Client()->State() != IClient::STATE_DEMOPLAYBACK)
 		return;
 	if(!g_Config.m_ClOverlayEntities && g_Config.m_TcOutlineEntities)
@@ -143,7 +401,7 @@ void COutlines::OnRender()
 	if(!g_Config.m_TcOutline)
 		return;
 
-	const float Scale = 32.0f;
+	const float Scale = TILE_SCALE;
 
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
 	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
@@ -161,104 +419,35 @@ void COutlines::OnRender()
 		StartY += EdgeY / 2;
 		EndY -= EdgeY / 2;
 	}
-
-	auto GetTile = [&](int x, int y) {
-		x = std::clamp(x, 0, m_MapDataSize.x - 1);
-		y = std::clamp(y, 0, m_MapDataSize.y - 1);
-		return m_pMapData[y * m_MapDataSize.x + x];
-	};
+	StartX = std::max(StartX, 0);
+	StartY = std::max(StartY, 0);
+	EndX = std::min(EndX, m_MapDataSize.x);
+	EndY = std::min(EndY, m_MapDataSize.y);
+	if(StartX >= EndX || StartY >= EndY)
+		return;
+	const int ChunkStartX = StartX / CHUNK_SIZE;
+	const int ChunkStartY = StartY / CHUNK_SIZE;
+	const int ChunkEndX = (EndX - 1) / CHUNK_SIZE;
+	const int ChunkEndY = (EndY - 1) / CHUNK_SIZE;
 
 	Graphics()->TextureClear();
-	Graphics()->QuadsBegin();
-
-	for(int y = StartY; y < EndY; y++)
+	for(int ChunkY = ChunkStartY; ChunkY <= ChunkEndY; ++ChunkY)
 	{
-		for(int x = StartX; x < EndX; x++)
+		// Neighbouring chunks of a row are consecutive in their container and drawn together
+		CChunk Draw;
+		for(int ChunkX = ChunkStartX; ChunkX <= ChunkEndX; ++ChunkX)
 		{
-			const int Type = GetTile(x, y);
-			if(Type == OUTLINE_NONE)
-				continue;
-			class COutlineConfig
+			const CChunk &Chunk = m_vChunks[ChunkY * m_NumChunks.x + ChunkX];
+			if(Draw.m_Container == Chunk.m_Container && Draw.m_Offset + Draw.m_NumQuads == Chunk.m_Offset && Draw.m_NumQuads + Chunk.m_NumQuads <= MAX_QUADS_PER_DRAW)
 			{
-			public:
-				const int &m_Enable;
-				const int &m_Width;
-				const unsigned int &m_Color;
-			};
-			const COutlineConfig Config = [&]() -> COutlineConfig {
-				if(Type == OUTLINE_SOLID)
-					return {g_Config.m_TcOutlineSolid, g_Config.m_TcOutlineWidthSolid, g_Config.m_TcOutlineColorSolid};
-				if(Type == OUTLINE_FREEZE)
-					return {g_Config.m_TcOutlineFreeze, g_Config.m_TcOutlineWidthFreeze, g_Config.m_TcOutlineColorFreeze};
-				if(Type == OUTLINE_UNFREEZE)
-					return {g_Config.m_TcOutlineUnfreeze, g_Config.m_TcOutlineWidthUnfreeze, g_Config.m_TcOutlineColorUnfreeze};
-				if(Type == OUTLINE_KILL)
-					return {g_Config.m_TcOutlineKill, g_Config.m_TcOutlineWidthKill, g_Config.m_TcOutlineColorKill};
-				if(Type == OUTLINE_TELE)
-					return {g_Config.m_TcOutlineTele, g_Config.m_TcOutlineWidthTele, g_Config.m_TcOutlineColorTele};
-				dbg_assert(false, "Invalid value for Type at %d, %d/%d, %d", x, y, m_MapDataSize.x, m_MapDataSize.y);
-			}();
-			if(!Config.m_Enable || Config.m_Width <= 0)
+				Draw.m_NumQuads += Chunk.m_NumQuads;
 				continue;
-			// Find neighbours
-			const bool aNeighbors[8] = {
-				GetTile(x - 1, y - 1) >= Type,
-				GetTile(x - 0, y - 1) >= Type,
-				GetTile(x + 1, y - 1) >= Type,
-				GetTile(x - 1, y + 0) >= Type,
-				GetTile(x + 1, y + 0) >= Type,
-				GetTile(x - 1, y + 1) >= Type,
-				GetTile(x + 0, y + 1) >= Type,
-				GetTile(x + 1, y + 1) >= Type,
-			};
-			// Figure out edges
-			IGraphics::CQuadItem aQuads[8];
-			int NumQuads = 0;
-			// Lone corners first
-			if(!aNeighbors[0] && aNeighbors[1] && aNeighbors[3])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[2] && aNeighbors[1] && aNeighbors[4])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[5] && aNeighbors[3] && aNeighbors[6])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Config.m_Width, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[7] && aNeighbors[6] && aNeighbors[4])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Scale - Config.m_Width, Config.m_Width, Config.m_Width);
-			// Top
-			if(!aNeighbors[1])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Scale, Config.m_Width);
-			// Bottom
-			if(!aNeighbors[6])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Config.m_Width, Scale, Config.m_Width);
-			// Left
-			if(!aNeighbors[3])
-			{
-				if(aNeighbors[1] && aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Scale);
-				else if(aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width);
-				else if(aNeighbors[1])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Scale - Config.m_Width);
-				else
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width * 2.0f);
-			}
-			// Right
-			if(!aNeighbors[4])
-			{
-				if(aNeighbors[1] && aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Scale);
-				else if(aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width);
-				else if(aNeighbors[1])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Scale - Config.m_Width);
-				else
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width * 2.0f);
 			}
-			if(NumQuads <= 0)
-				continue;
-			Graphics()->SetColor(color_cast<ColorRGBA>(ColorHSLA(Config.m_Color, true)));
-			Graphics()->QuadsDrawTL(aQuads, NumQuads);
+			if(Draw.m_NumQuads > 0)
+				Graphics()->RenderQuadContainer(Draw.m_Container, Draw.m_Offset, Draw.m_NumQuads);
+			Draw = Chunk;
 		}
+		if(Draw.m_NumQuads > 0)
+			Graphics()->RenderQuadContainer(Draw.m_Container, Draw.m_Offset, Draw.m_NumQuads);
 	}
-
-	Graphics()->QuadsEnd();
 }
@@ -1,22 +1,86 @@
 #ifndef GAME_CLIENT_COMPONENTS_TCLIENT_OUTLINES_H
 #define GAME_CLIENT_COMPONENTS_TCLIENT_OUTLINES_H
 
+#include <engine/graphics.h>
+#include <engine/shared/jobs.h>
+
 #include <game/client/component.h>
 
-class CTile;
-class CTeleTile;
+#include <array>
+#include <memory>
+#include <vector>
 
 class COutlines : public CComponent
 {
+public:
+	enum
+	{
+		NUM_OUTLINE_TYPES = 6,
+		// outlines are meshed and drawn in chunks of CHUNK_SIZE x CHUNK_SIZE tiles
+		CHUNK_SIZE = 16,
+	};
+
+	class COutlineStyle
+	{
+	public:
+		bool m_Enable = false;
+		int m_Width = 0;
+		unsigned m_Color = 0;
+		bool operator==(const COutlineStyle &Other) const = default;
+	};
+	typedef std::array<COutlineStyle, NUM_OUTLINE_TYPES> COutlineStyles;
+
 private:
+	class CMeshJob : public IJob
+	{
+	public:
+		CMeshJob(std::shared_ptr<const std::vector<int>> pMapData, ivec2 MapDataSize, const COutlineStyles &Styles, int ChunkRowBegin, int ChunkRowEnd);
+
+		const COutlineStyles m_Styles;
+		const int m_ChunkRowBegin;
+		const int m_ChunkRowEnd;
+		// quads of the chunks in [m_ChunkRowBegin, m_ChunkRowEnd), grouped by chunk and then by outline type
+		std::vector<IGraphics::CQuadItem> m_vQuads;
+		std::vector<std::array<int, NUM_OUTLINE_TYPES>> m_vChunkNumQuads;
+
+	protected:
+		void Run() override;
+
+	private:
+		int GetTile(int x, int y) const;
+		void MeshChunk(int ChunkX, int ChunkY);
+
+		std::shared_ptr<const std::vector<int>> m_pMapData;
+		ivec2 m_MapDataSize;
+	};
+
+	class CChunk
+	{
+	public:
+		int m_Container = -1;
+		int m_Offset = 0;
+		int m_NumQuads = 0;
+	};
+
 	ivec2 m_MapDataSize;
-	int *m_pMapData = nullptr;
+	std::shared_ptr<const std::vector<int>> m_pMapData;
+
+	// one job per band of chunk rows, the mesh is uploaded once all of them are done
+	std::vector<std::shared_ptr<CMeshJob>> m_vpMeshJobs;
+	COutlineStyles m_MeshStyles;
+	std::vector<int> m_vQuadContainers;
+	std::vector<CChunk> m_vChunks;
+	ivec2 m_NumChunks;
+
+	static COutlineStyles CurrentStyles();
+	void StartMeshJobs(const COutlineStyles &Styles);
+	void UploadMesh();
+	void ClearMesh();
 
 public:
 	int Sizeof() const override { return sizeof(*this); }
 	void OnMapLoad() override;
 	void OnRender() override;
-	~COutlines() override { delete[] m_pMapData; }
 };
 
 #endif
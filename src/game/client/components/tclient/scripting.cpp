@@ -4,6 +4,7 @@
 
 #include <base/log.h>
 #include <base/str.h>
+#include <base/time.h>
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
@@ -241,21 +242,207 @@ public:
 	{
 		m_ScriptingCtx.Run(Storage(), pFilename, pArgs);
 	}
+	bool HasHandlers(const char *pEvent) const
+	{
+		return m_ScriptingCtx.HasHandlers(pEvent);
+	}
+	void Fire(const char *pFilename, const char *pEvent, const std::vector<CScriptingCtx::Any> &vArgs)
+	{
+		m_ScriptingCtx.Fire(pFilename, pEvent, vArgs);
+	}
+	const std::map<std::string, CScriptStats> &Stats() const
+	{
+		return m_ScriptingCtx.Stats();
+	}
 };
 
+CScripting::CScripting() = default;
+CScripting::~CScripting() = default;
+
 void CScripting::ConExecScript(IConsole::IResult *pResult, void *pUserData)
 {
 	CScripting *pThis = static_cast<CScripting *>(pUserData);
 	pThis->ExecScript(pResult->GetString(0), pResult->GetString(1));
 }
 
+void CScripting::ConScriptStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CScripting *pThis = static_cast<CScripting *>(pUserData);
+	std::map<std::string, CScriptStats> Stats;
+	const auto AddStats = [&](const CScriptRunner &Runner) {
+		for(const auto &[Filename, RunnerStats] : Runner.Stats())
+		{
+			CScriptStats &Total = Stats[Filename];
+			Total.m_NumRuns += RunnerStats.m_NumRuns;
+			Total.m_NumCompiles += RunnerStats.m_NumCompiles;
+			Total.m_LastRunTime = RunnerStats.m_LastRunTime;
+			Total.m_MaxRunTime = std::max(Total.m_MaxRunTime, RunnerStats.m_MaxRunTime);
+			Total.m_TotalRunTime += RunnerStats.m_TotalRunTime;
+			Total.m_LastCompileTime = RunnerStats.m_LastCompileTime;
+			Total.m_NumEvents += RunnerStats.m_NumEvents;
+			Total.m_TotalEventTime += RunnerStats.m_TotalEventTime;
+		}
+	};
+	for(const auto &pRunner : pThis->m_vpRunners)
+		AddStats(*pRunner);
+	for(const auto &pScript : pThis->m_vpLoadedScripts)
+		AddStats(*pScript->m_pRunner);
+	if(Stats.empty())
+	{
+		log_info(SCRIPTING_IMPL, "No scripts executed yet");
+		return;
+	}
+	const auto Ms = [](std::chrono::nanoseconds Time) { return Time.count() / 1000000.0; };
+	for(const auto &[Filename, Script] : Stats)
+	{
+		const double Average = Script.m_NumRuns > 0 ? Ms(Script.m_TotalRunTime) / Script.m_NumRuns : 0.0;
+		log_info(SCRIPTING_IMPL, "%s: %d runs, last %.3fms, avg %.3fms, max %.3fms, %d compiles, last compile %.3fms",
+			Filename.c_str(), Script.m_NumRuns, Ms(Script.m_LastRunTime), Average, Ms(Script.m_MaxRunTime), Script.m_NumCompiles, Ms(Script.m_LastCompileTime));
+		if(Script.m_NumEvents > 0)
+			log_info(SCRIPTING_IMPL, "%s: %d events, avg %.3fms", Filename.c_str(), Script.m_NumEvents, Ms(Script.m_TotalEventTime) / Script.m_NumEvents);
+	}
+}
+
+void CScripting::ConLoadScript(IConsole::IResult *pResult, void *pUserData)
+{
+	CScripting *pThis = static_cast<CScripting *>(pUserData);
+	pThis->LoadScript(pResult->GetString(0), pResult->GetString(1));
+}
+
+void CScripting::ConUnloadScript(IConsole::IResult *pResult, void *pUserData)
+{
+	CScripting *pThis = static_cast<CScripting *>(pUserData);
+	pThis->UnloadScript(pResult->GetString(0));
+}
+
 void CScripting::ExecScript(const char *pFilename, const char *pArgs)
 {
-	CScriptRunner Runner(GameClient());
+	// A script executing another script gets its own runner, the outer one is still in use
+	if(m_RunDepth >= (int)m_vpRunners.size())
+		m_vpRunners.push_back(std::make_unique<CScriptRunner>(GameClient()));
+	CScriptRunner &Runner = *m_vpRunners[m_RunDepth];
+	m_RunDepth++;
 	Runner.Run(pFilename, pArgs);
+	m_RunDepth--;
+}
+
+void CScripting::LoadScript(const char *pFilename, const char *pArgs)
+{
+	UnloadScript(pFilename);
+	std::unique_ptr<CLoadedScript> pScript = std::make_unique<CLoadedScript>();
+	pScript->m_Filename = pFilename;
+	pScript->m_pRunner = std::make_unique<CScriptRunner>(GameClient());
+	CScriptRunner &Runner = *pScript->m_pRunner;
+	// Added before running, so the script can unload itself
+	m_vpLoadedScripts.push_back(std::move(pScript));
+	m_LoadedScriptsBusy++;
+	Runner.Run(pFilename, pArgs);
+	m_LoadedScriptsBusy--;
+	RemoveUnloadedScripts();
+}
+
+void CScripting::UnloadScript(const char *pFilename)
+{
+	for(auto &pScript : m_vpLoadedScripts)
+	{
+		if(pScript->m_Filename == pFilename)
+			pScript->m_Unload = true;
+	}
+	RemoveUnloadedScripts();
+}
+
+void CScripting::RemoveUnloadedScripts()
+{
+	// Scripts may unload themselves, keep them until they are done running
+	if(m_LoadedScriptsBusy > 0)
+		return;
+	std::erase_if(m_vpLoadedScripts, [](const std::unique_ptr<CLoadedScript> &pScript) { return pScript->m_Unload; });
+}
+
+void CScripting::QueueEvent(const char *pEvent, const std::vector<CScriptingCtx::Any> &vArgs)
+{
+	for(auto &pScript : m_vpLoadedScripts)
+	{
+		if(pScript->m_Unload || !pScript->m_pRunner->HasHandlers(pEvent))
+			continue;
+		if((int)pScript->m_Events.size() >= MAX_QUEUED_EVENTS)
+		{
+			log_error(SCRIPTING_IMPL, "Unloading '%s', it can't keep up with events, raise tc_script_budget if this is expected", pScript->m_Filename.c_str());
+			pScript->m_Unload = true;
+			continue;
+		}
+		pScript->m_Events.push_back({pEvent, vArgs});
+	}
+	RemoveUnloadedScripts();
+}
+
+void CScripting::DispatchEvents()
+{
+	const std::chrono::nanoseconds Budget = std::chrono::microseconds(g_Config.m_TcScriptBudget);
+	m_LoadedScriptsBusy++;
+	// By index, handlers may load more scripts
+	for(size_t i = 0; i < m_vpLoadedScripts.size(); i++)
+	{
+		CLoadedScript &Script = *m_vpLoadedScripts[i];
+		const std::chrono::nanoseconds Start = time_get_nanoseconds();
+		// Handlers can't be interrupted, so the budget is checked between them. Events left over wait for the next frame
+		while(!Script.m_Events.empty() && !Script.m_Unload && time_get_nanoseconds() - Start < Budget)
+		{
+			const CScriptEvent Event = std::move(Script.m_Events.front());
+			Script.m_Events.pop_front();
+			const std::chrono::nanoseconds EventStart = time_get_nanoseconds();
+			Script.m_pRunner->Fire(Script.m_Filename.c_str(), Event.m_pName, Event.m_vArgs);
+			const std::chrono::nanoseconds EventTime = time_get_nanoseconds() - EventStart;
+			if(EventTime > Budget * KILL_BUDGET_FACTOR)
+			{
+				log_error(SCRIPTING_IMPL, "Unloading '%s', handling '%s' took %.3fms", Script.m_Filename.c_str(), Event.m_pName, EventTime.count() / 1000000.0);
+				Script.m_Unload = true;
+			}
+		}
+	}
+	m_LoadedScriptsBusy--;
+	RemoveUnloadedScripts();
 }
 
 void CScripting::OnConsoleInit()
 {
 	Console()->Register(SCRIPTING_IMPL, "s[file] ?r[args]", CFGFLAG_CLIENT, ConExecScript, this, "Execute a " SCRIPTING_IMPL " script");
+	Console()->Register(SCRIPTING_IMPL "_load", "s[file] ?r[args]", CFGFLAG_CLIENT, ConLoadScript, this, "Execute a " SCRIPTING_IMPL " script and keep it loaded to handle events");
+	Console()->Register(SCRIPTING_IMPL "_unload", "s[file]", CFGFLAG_CLIENT, ConUnloadScript, this, "Unload a " SCRIPTING_IMPL " script loaded with " SCRIPTING_IMPL "_load");
+	Console()->Register(SCRIPTING_IMPL "_stats", "", CFGFLAG_CLIENT, ConScriptStats, this, "Show the execution times of " SCRIPTING_IMPL " scripts");
+}
+
+void CScripting::OnRender()
+{
+	if(m_vpLoadedScripts.empty())
+		return;
+	if(Client()->State() == IClient::STATE_ONLINE || Client()->State() == IClient::STATE_DEMOPLAYBACK)
+	{
+		const int Tick = Client()->GameTick(g_Config.m_ClDummy);
+		if(Tick != m_LastEventTick)
+		{
+			m_LastEventTick = Tick;
+			QueueEvent("tick", {Tick});
+		}
+	}
+	QueueEvent("render");
+	DispatchEvents();
+}
+
+void CScripting::OnNewSnapshot()
+{
+	if(m_vpLoadedScripts.empty() || GameClient()->m_SuppressEvents)
+		return;
+	QueueEvent("snapshot");
+}
+
+void CScripting::OnMessage(int MsgType, void *pRawMsg)
+{
+	if(m_vpLoadedScripts.empty() || GameClient()->m_SuppressEvents)
+		return;
+	if(MsgType == NETMSGTYPE_SV_CHAT)
+	{
+		const CNetMsg_Sv_Chat *pMsg = static_cast<CNetMsg_Sv_Chat *>(pRawMsg);
+		QueueEvent("chat", {pMsg->m_ClientId, pMsg->m_Team, std::string(pMsg->m_pMessage)});
+	}
 }
@@ -5,14 +5,78 @@
 
 #include <game/client/component.h>
 
+#include "scripting/impl.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CScriptRunner;
+
 class CScripting : public CComponent
 {
 private:
 	static void ConExecScript(IConsole::IResult *pResult, void *pUserData);
+	static void ConScriptStats(IConsole::IResult *pResult, void *pUserData);
+
+	static void ConLoadScript(IConsole::IResult *pResult, void *pUserData);
+	static void ConUnloadScript(IConsole::IResult *pResult, void *pUserData);
+
+	// Runners are kept between calls, one per nesting level of scripts executing scripts
+	std::vector<std::unique_ptr<CScriptRunner>> m_vpRunners;
+	int m_RunDepth = 0;
+
+	enum
+	{
+		// Events a script may have waiting before it is unloaded
+		MAX_QUEUED_EVENTS = 1024,
+		// A single handler taking this many budgets unloads its script
+		KILL_BUDGET_FACTOR = 10,
+	};
+
+	class CScriptEvent
+	{
+	public:
+		const char *m_pName;
+		std::vector<CScriptingCtx::Any> m_vArgs;
+	};
+
+	// A script which stays loaded to handle events
+	class CLoadedScript
+	{
+	public:
+		std::string m_Filename;
+		std::unique_ptr<CScriptRunner> m_pRunner;
+		std::deque<CScriptEvent> m_Events;
+		bool m_Unload = false;
+	};
+	std::vector<std::unique_ptr<CLoadedScript>> m_vpLoadedScripts;
+	// Loaded scripts are only removed when none of them is running
+	int m_LoadedScriptsBusy = 0;
+	int m_LastEventTick = -1;
+
+	void QueueEvent(const char *pEvent, const std::vector<CScriptingCtx::Any> &vArgs = {});
+	void DispatchEvents();
+	void RemoveUnloadedScripts();
 
 public:
+	CScripting();
+	~CScripting() override;
+
 	void ExecScript(const char *pFilename, const char *pArgs);
+	/**
+	 * Runs the script in its own context and keeps it loaded, so handlers
+	 * it registered with `on` receive events. Loading a loaded script again
+	 * replaces it.
+	 */
+	void LoadScript(const char *pFilename, const char *pArgs);
+	void UnloadScript(const char *pFilename);
+
 	void OnConsoleInit() override;
+	void OnRender() override;
+	void OnNewSnapshot() override;
+	void OnMessage(int MsgType, void *pRawMsg) override;
 	int Sizeof() const override { return sizeof(*this); }
 };
 
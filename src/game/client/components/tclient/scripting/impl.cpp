@@ -1,10 +1,14 @@
 #include "impl.h"
 
 #include <base/log.h>
+#include <base/system.h>
+#include <base/time.h>
 
 #include <engine/external/regex.h>
 #include <engine/storage.h>
 
+#include <memory>
+#include <optional>
 #include <variant>
 
 #define CHAISCRIPT_NO_THREADS
@@ -44,20 +48,150 @@ static const auto NAMESPACE_MATH = [](chaiscript::Namespace &Math) {
 	Math["abs"] = chaiscript::var(chaiscript::fun([](double x) { return fabs(x); }));
 };
 
-static const char *ReadScript(IStorage *pStorage, const char *pFilename)
-{
-	const char *pScript;
-	pScript = pStorage->ReadFileStr(pFilename, IStorage::TYPE_ALL);
-	if(!pScript || !*pScript)
-		throw std::string("Failed to open script '") + std::string(pFilename) + std::string("'");
-	return pScript;
-}
-
 class CScriptingCtx::CScriptingCtxData
 {
 public:
 	IStorage *m_pStorage;
 	chaiscript::ChaiScript m_Chai;
+
+	// State after all functions were added, restored before every run
+	std::optional<chaiscript::ChaiScript::State> m_InitialState;
+	std::map<std::string, chaiscript::Boxed_Value> m_InitialLocals;
+
+	class CCompiledScript
+	{
+	public:
+		char m_aPath[IO_MAX_PATH_LENGTH];
+		time_t m_Modified;
+		int64_t m_Size;
+		// shared, a script can include itself after it was changed
+		std::shared_ptr<chaiscript::AST_Node> m_pAst;
+	};
+	std::map<std::string, CCompiledScript> m_Scripts;
+
+	// Functions passed to `on`, by event name
+	std::map<std::string, std::vector<chaiscript::Boxed_Value>> m_Handlers;
+
+	void ResetState()
+	{
+		m_Handlers.clear();
+		if(!m_InitialState)
+		{
+			m_InitialState = m_Chai.get_state();
+			m_InitialLocals = m_Chai.get_locals();
+		}
+		else
+		{
+			m_Chai.set_state(*m_InitialState);
+			m_Chai.set_locals(m_InitialLocals);
+		}
+	}
+
+	std::shared_ptr<chaiscript::AST_Node> Compile(const char *pFilename, CScriptStats &Stats)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL, aPath, sizeof(aPath));
+		if(!File)
+			throw std::string("Failed to open script '") + std::string(pFilename) + std::string("'");
+		time_t Created, Modified;
+		if(fs_file_time(aPath, &Created, &Modified) != 0)
+			Modified = 0;
+		const int64_t Size = io_length(File);
+
+		auto It = m_Scripts.find(pFilename);
+		if(It != m_Scripts.end() && str_comp(It->second.m_aPath, aPath) == 0 && It->second.m_Modified == Modified && It->second.m_Size == Size)
+		{
+			io_close(File);
+			return It->second.m_pAst;
+		}
+
+		char *pScript = io_read_all_str(File);
+		io_close(File);
+		if(!pScript || !*pScript)
+		{
+			free(pScript);
+			throw std::string("Failed to open script '") + std::string(pFilename) + std::string("'");
+		}
+		const std::chrono::nanoseconds Start = time_get_nanoseconds();
+		std::shared_ptr<chaiscript::AST_Node> pAst;
+		try
+		{
+			pAst = m_Chai.get_parser().parse(pScript, pFilename);
+		}
+		catch(...)
+		{
+			free(pScript);
+			throw;
+		}
+		free(pScript);
+		Stats.m_NumCompiles++;
+		Stats.m_LastCompileTime = time_get_nanoseconds() - Start;
+
+		CCompiledScript &Script = m_Scripts[pFilename];
+		str_copy(Script.m_aPath, aPath);
+		Script.m_Modified = Modified;
+		Script.m_Size = Size;
+		Script.m_pAst = pAst;
+		return pAst;
+	}
+
+	chaiscript::Boxed_Value Eval(const chaiscript::AST_Node &Ast)
+	{
+		try
+		{
+			return m_Chai.eval(Ast);
+		}
+		catch(chaiscript::eval::detail::Return_Value &Rv)
+		{
+			return Rv.retval;
+		}
+		catch(const chaiscript::Boxed_Value &Value)
+		{
+			// Evaluation errors get boxed, unbox them to keep their location for the error message
+			if(Value.get_type_info().bare_equal(chaiscript::user_type<chaiscript::exception::eval_error>()))
+				throw chaiscript::boxed_cast<const chaiscript::exception::eval_error &>(Value);
+			throw;
+		}
+	}
+
+	// Must be called from a catch block
+	void LogException(const char *pFilename)
+	{
+		try
+		{
+			throw;
+		}
+		catch(const chaiscript::exception::eval_error &e)
+		{
+			log_error(SCRIPTING_IMPL, "Eval error in '%s': %s", pFilename, e.pretty_print().c_str());
+		}
+		catch(const std::exception &e)
+		{
+			log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, e.what());
+		}
+		catch(const std::string &e)
+		{
+			log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, e.c_str());
+		}
+		catch(const chaiscript::Boxed_Value &e)
+		{
+			try
+			{
+				chaiscript::Boxed_Value ToStringRaw = m_Chai.eval("to_string");
+				std::function<std::string(chaiscript::Boxed_Value)> ToString =
+					chaiscript::boxed_cast<std::function<std::string(chaiscript::Boxed_Value)>>(ToStringRaw);
+				log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, ToString(e).c_str());
+			}
+			catch(...)
+			{
+				log_error(SCRIPTING_IMPL, "Unknown exception while trying to print an error in '%s'", pFilename);
+			}
+		}
+		catch(...)
+		{
+			log_error(SCRIPTING_IMPL, "Unknown exception in '%s'", pFilename);
+		}
+	}
 };
 
 CScriptingCtx::CScriptingCtx()
@@ -79,16 +213,26 @@ CScriptingCtx::CScriptingCtx()
 	m_pData->m_Chai.add(PrintStrBoxed, "print");
 	m_pData->m_Chai.add(PrintStrBoxed, "puts");
 	m_pData->m_Chai.add(chaiscript::fun([&](const std::string &Module) {
-		const char *pScript = ReadScript(m_pData->m_pStorage, Module.c_str());
-		auto Out = m_pData->m_Chai.eval(pScript, chaiscript::Exception_Handler(), Module);
-		std::free((void *)pScript);
-		return Out;
+		const std::shared_ptr<chaiscript::AST_Node> pAst = m_pData->Compile(Module.c_str(), m_Stats[Module]);
+		return m_pData->Eval(*pAst);
 	}),
 		"include");
 	m_pData->m_Chai.add(chaiscript::fun([&](const std::string &Path) {
 		return m_pData->m_pStorage->FileExists(Path.c_str(), IStorage::TYPE_ALL);
 	}),
 		"file_exists");
+	m_pData->m_Chai.add(chaiscript::fun([&](const std::string &Event, const chaiscript::Boxed_Value &Handler) {
+		try
+		{
+			m_pData->m_Chai.boxed_cast<chaiscript::Const_Proxy_Function>(Handler);
+		}
+		catch(const chaiscript::exception::bad_boxed_cast &)
+		{
+			throw std::string("Handler for '") + Event + std::string("' is not a function");
+		}
+		m_pData->m_Handlers[Event].push_back(Handler);
+	}),
+		"on");
 	m_pData->m_Chai.register_namespace(NAMESPACE_RE, "re");
 	m_pData->m_Chai.register_namespace(NAMESPACE_MATH, "math");
 }
@@ -116,6 +260,7 @@ static chaiscript::Boxed_Value Any2Boxed(const CScriptingCtx::Any &Any)
 template<>
 void CScriptingCtx::AddFunctionInternal(const char *pName, const std::function<CScriptingCtx::Any(const std::string &Str, const CScriptingCtx::Any &Any)> &Function)
 {
+	m_pData->m_InitialState.reset();
 	m_pData->m_Chai.add(chaiscript::fun([=](const std::string &Str) {
 		return Any2Boxed(Function(Str, nullptr));
 	}),
@@ -141,54 +286,92 @@ void CScriptingCtx::AddFunctionInternal(const char *pName, const std::function<C
 template<>
 void CScriptingCtx::AddFunctionInternal(const char *pName, const std::function<void(const std::string &Str)> &Function)
 {
+	m_pData->m_InitialState.reset();
 	m_pData->m_Chai.add(chaiscript::fun([=](const std::string &Str) { Function(Str); }), pName);
 }
 
 template<>
 void CScriptingCtx::AddGlobal(const char *pName, const std::string &Object)
 {
+	m_pData->m_InitialState.reset();
 	m_pData->m_Chai.add_global_const(chaiscript::const_var(Object), pName);
 }
 
 void CScriptingCtx::Run(IStorage *pStorage, const char *pFilename, const char *pArgs)
 {
 	m_pData->m_pStorage = pStorage;
-	const char *pScript = nullptr;
+	m_pData->ResetState();
+	CScriptStats &Stats = m_Stats[pFilename];
+	const int NumCompiles = Stats.m_NumCompiles;
+	const std::chrono::nanoseconds Start = time_get_nanoseconds();
 	try
 	{
 		m_pData->m_Chai.add_global_const(chaiscript::const_var(std::string(pArgs)), "args");
-		pScript = ReadScript(pStorage, pFilename);
-		m_pData->m_Chai.eval(pScript, chaiscript::Exception_Handler(), pFilename);
-	}
-	catch(const chaiscript::exception::eval_error &e)
-	{
-		log_error(SCRIPTING_IMPL, "Eval error in '%s': %s", pFilename, e.pretty_print().c_str());
+		const std::shared_ptr<chaiscript::AST_Node> pAst = m_pData->Compile(pFilename, Stats);
+		m_pData->Eval(*pAst);
 	}
-	catch(const std::exception &e)
-	{
-		log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, e.what());
-	}
-	catch(const std::string &e)
+	catch(...)
 	{
-		log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, e.c_str());
+		m_pData->LogException(pFilename);
 	}
-	catch(const chaiscript::Boxed_Value &e)
+
+	std::chrono::nanoseconds RunTime = time_get_nanoseconds() - Start;
+	if(Stats.m_NumCompiles != NumCompiles)
+		RunTime -= Stats.m_LastCompileTime;
+	Stats.m_NumRuns++;
+	Stats.m_LastRunTime = RunTime;
+	Stats.m_MaxRunTime = std::max(Stats.m_MaxRunTime, RunTime);
+	Stats.m_TotalRunTime += RunTime;
+}
+
+bool CScriptingCtx::HasHandlers(const char *pEvent) const
+{
+	auto It = m_pData->m_Handlers.find(pEvent);
+	return It != m_pData->m_Handlers.end() && !It->second.empty();
+}
+
+void CScriptingCtx::Fire(const char *pFilename, const char *pEvent, const std::vector<Any> &vArgs)
+{
+	auto It = m_pData->m_Handlers.find(pEvent);
+	if(It == m_pData->m_Handlers.end())
+		return;
+	std::vector<chaiscript::Boxed_Value> vBoxedArgs;
+	vBoxedArgs.reserve(vArgs.size());
+	for(const Any &Arg : vArgs)
+		vBoxedArgs.push_back(Any2Boxed(Arg));
+
+	CScriptStats &Stats = m_Stats[pFilename];
+	const std::chrono::nanoseconds Start = time_get_nanoseconds();
+	// Copy, handlers may subscribe to more events
+	const std::vector<chaiscript::Boxed_Value> vHandlers = It->second;
+	for(const chaiscript::Boxed_Value &Handler : vHandlers)
 	{
 		try
 		{
-			chaiscript::Boxed_Value ToStringRaw = m_pData->m_Chai.eval("to_string");
-			std::function<std::string(chaiscript::Boxed_Value)> ToString =
-				chaiscript::boxed_cast<std::function<std::string(chaiscript::Boxed_Value)>>(ToStringRaw);
-			log_error(SCRIPTING_IMPL, "Exception in '%s': %s", pFilename, ToString(e).c_str());
+			using B = chaiscript::Boxed_Value;
+			switch(vBoxedArgs.size())
+			{
+			case 0:
+				m_pData->m_Chai.boxed_cast<std::function<void()>>(Handler)();
+				break;
+			case 1:
+				m_pData->m_Chai.boxed_cast<std::function<void(B)>>(Handler)(vBoxedArgs[0]);
+				break;
+			case 2:
+				m_pData->m_Chai.boxed_cast<std::function<void(B, B)>>(Handler)(vBoxedArgs[0], vBoxedArgs[1]);
+				break;
+			case 3:
+				m_pData->m_Chai.boxed_cast<std::function<void(B, B, B)>>(Handler)(vBoxedArgs[0], vBoxedArgs[1], vBoxedArgs[2]);
+				break;
+			default:
+				dbg_assert_failed("Too many event arguments: %d", (int)vBoxedArgs.size());
+			}
 		}
 		catch(...)
 		{
-			log_error(SCRIPTING_IMPL, "Unknown exception while trying to print an error in '%s'", pFilename);
+			m_pData->LogException(pFilename);
 		}
 	}
-	catch(...)
-	{
-		log_error(SCRIPTING_IMPL, "Unknown exception in '%s'", pFilename);
-	}
-	std::free((void *)pScript);
+	Stats.m_NumEvents++;
+	Stats.m_TotalEventTime += time_get_nanoseconds() - Start;
 }
@@ -1,20 +1,45 @@
 #ifndef GAME_CLIENT_COMPONENTS_TCLIENT_SCRIPTING_IMPL_H
 #define GAME_CLIENT_COMPONENTS_TCLIENT_SCRIPTING_IMPL_H
 
+#include <chrono>
 #include <functional>
+#include <map>
 #include <string>
 #include <variant>
+#include <vector>
 
 #define SCRIPTING_IMPL "chai"
 
 class IStorage;
 
+class CScriptStats
+{
+public:
+	int m_NumRuns = 0;
+	int m_NumCompiles = 0;
+	std::chrono::nanoseconds m_LastRunTime{0};
+	std::chrono::nanoseconds m_MaxRunTime{0};
+	std::chrono::nanoseconds m_TotalRunTime{0};
+	std::chrono::nanoseconds m_LastCompileTime{0};
+	int m_NumEvents = 0;
+	std::chrono::nanoseconds m_TotalEventTime{0};
+};
+
+/**
+ * A persistent scripting context. Scripts are compiled once and cached
+ * by path until the file changes. Every run starts from the state the
+ * context had before its first run, so definitions of one run don't leak
+ * into the next.
+ */
 class CScriptingCtx
 {
 private:
 	class CScriptingCtxData;
 	CScriptingCtxData *m_pData;
 
+	// by script filename
+	std::map<std::string, CScriptStats> m_Stats;
+
 	// If you are getting link errors, define more in the .cpp file
 	template<typename T, typename... Args>
 	void AddFunctionInternal(const char *pName, const std::function<T(Args...)> &Function);
@@ -35,6 +60,20 @@ public:
 		AddFunctionInternal(pName, std::function(Function));
 	}
 	void Run(IStorage *pStorage, const char *pFilename, const char *pArgs);
+
+	/**
+	 * Scripts subscribe to events with `on(event, function)`. Handlers are
+	 * dropped at the start of every run, so only contexts which are not
+	 * run again keep receiving events.
+	 */
+	bool HasHandlers(const char *pEvent) const;
+	/**
+	 * Calls all handlers of the event with the arguments, errors are logged
+	 * like in @link Run @endlink.
+	 */
+	void Fire(const char *pFilename, const char *pEvent, const std::vector<Any> &vArgs);
+
+	const std::map<std::string, CScriptStats> &Stats() const { return m_Stats; }
 };
 
 #endif
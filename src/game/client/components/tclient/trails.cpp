@@ -24,7 +24,7 @@ void CTrails::ClearAllHistory()
 }
 void CTrails::ClearHistory(int ClientId)
 {
-	for(int i = 0; i < 200; ++i)
+	for(int i = 0; i < HISTORY_SIZE; ++i)
 		m_History[ClientId][i] = {{}, -1};
 	m_HistoryValid[ClientId] = false;
 }
@@ -35,6 +35,9 @@ void CTrails::OnReset()
 
 void CTrails::OnRender()
 {
+	m_NumVertices = 0;
+	m_NumDrawCalls = 0;
+
 	if(!g_Config.m_TcTeeTrail)
 		return;
 
@@ -44,7 +47,17 @@ void CTrails::OnRender()
 	if(!GameClient()->m_Snap.m_pGameInfoObj)
 		return;
 
+	const bool LineMode = g_Config.m_TcTeeTrailWidth == 0;
+	const ColorRGBA SolidColor = color_cast<ColorRGBA>(ColorHSLA(g_Config.m_TcTeeTrailColor));
+
+	// The trails of all players are submitted as one batch, which is split
+	// into several draw calls when it exceeds the streamed vertex buffer
+	const uint64_t DrawCallsBefore = Graphics()->StreamedDrawCalls();
 	Graphics()->TextureClear();
+	if(LineMode)
+		Graphics()->LinesBegin();
+	else
+		Graphics()->QuadsBegin();
 
 	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
 	{
@@ -95,7 +108,7 @@ void CTrails::OnRender()
 
 		const vec2 CurServerPos = vec2(GameClient()->m_Snap.m_aCharacters[ClientId].m_Cur.m_X, GameClient()->m_Snap.m_aCharacters[ClientId].m_Cur.m_Y);
 		const vec2 PrevServerPos = vec2(GameClient()->m_Snap.m_aCharacters[ClientId].m_Prev.m_X, GameClient()->m_Snap.m_aCharacters[ClientId].m_Prev.m_Y);
-		m_History[ClientId][GameTick % 200] = {
+		m_History[ClientId][GameTick % HISTORY_SIZE] = {
 			mix(PrevServerPos, CurServerPos, IntraTick),
 			GameTick,
 		};
@@ -105,7 +118,6 @@ void CTrails::OnRender()
 		// m_History[ClientId][(GameTick + 2) % 200] = m_History[ClientId][GameTick % 200];
 
 		IGraphics::CLineItem LineItem;
-		bool LineMode = g_Config.m_TcTeeTrailWidth == 0;
 
 		float Alpha = g_Config.m_TcTeeTrailAlpha / 100.0f;
 		// Taken from players.cpp
@@ -139,9 +151,9 @@ void CTrails::OnRender()
 			}
 			else
 			{
-				if(m_History[ClientId][PosTick % 200].m_Tick != PosTick)
+				if(m_History[ClientId][PosTick % HISTORY_SIZE].m_Tick != PosTick)
 					continue;
-				Part.m_Pos = m_History[ClientId][PosTick % 200].m_Pos;
+				Part.m_Pos = m_History[ClientId][PosTick % HISTORY_SIZE].m_Pos;
 				if(i == TrailLength - 2 || i == TrailLength - 3)
 					TrailFull = true;
 			}
@@ -170,6 +182,8 @@ void CTrails::OnRender()
 		if(TrailFull)
 			s_Trail.at(s_Trail.size() - 1).m_Pos = mix(s_Trail.at(s_Trail.size() - 1).m_Pos, s_Trail.at(s_Trail.size() - 2).m_Pos, std::fmod(IntraTick, 1.0f));
 
+		const ColorRGBA TeeColor = TeeInfo.m_CustomColoredSkin ? TeeInfo.m_ColorBody : TeeInfo.m_BloodColor;
+
 		// Set progress
 		for(int i = 0; i < (int)s_Trail.size(); i++)
 		{
@@ -185,13 +199,10 @@ void CTrails::OnRender()
 			switch(g_Config.m_TcTeeTrailColorMode)
 			{
 			case COLORMODE_SOLID:
-				Part.m_Col = color_cast<ColorRGBA>(ColorHSLA(g_Config.m_TcTeeTrailColor));
+				Part.m_Col = SolidColor;
 				break;
 			case COLORMODE_TEE:
-				if(TeeInfo.m_CustomColoredSkin)
-					Part.m_Col = TeeInfo.m_ColorBody;
-				else
-					Part.m_Col = TeeInfo.m_BloodColor;
+				Part.m_Col = TeeColor;
 				break;
 			case COLORMODE_RAINBOW:
 			{
@@ -306,11 +317,6 @@ void CTrails::OnRender()
 			}
 		}
 
-		if(LineMode)
-			Graphics()->LinesBegin();
-		else
-			Graphics()->QuadsBegin();
-
 		// Draw the trail
 		for(int i = 0; i < (int)s_Trail.size() - 1; i++)
 		{
@@ -339,6 +345,7 @@ void CTrails::OnRender()
 				Graphics()->SetColor(Part.m_Col);
 				LineItem = IGraphics::CLineItem(Part.m_Pos.x, Part.m_Pos.y, NextPart.m_Pos.x, NextPart.m_Pos.y);
 				Graphics()->LinesDraw(&LineItem, 1);
+				m_NumVertices += 2;
 			}
 			else
 			{
@@ -359,11 +366,14 @@ void CTrails::OnRender()
 				IGraphics::CFreeformItem FreeformItem(NextPart.m_Top, NextPart.m_Bot, Top, Bot);
 
 				Graphics()->QuadsDrawFreeform(&FreeformItem, 1);
+				m_NumVertices += 4;
 			}
 		}
-		if(LineMode)
-			Graphics()->LinesEnd();
-		else
-			Graphics()->QuadsEnd();
 	}
+
+	if(LineMode)
+		Graphics()->LinesEnd();
+	else
+		Graphics()->QuadsEnd();
+	m_NumDrawCalls = Graphics()->StreamedDrawCalls() - DrawCallsBefore;
 }
@@ -43,16 +43,29 @@ public:
 		COLORMODE_SPEED,
 	};
 
+	// Statistics of the last rendered frame, shown in the debug HUD
+	int NumVertices() const { return m_NumVertices; }
+	int NumDrawCalls() const { return m_NumDrawCalls; }
+
 private:
+	enum
+	{
+		// per client ring buffer of positions, indexed by tick
+		HISTORY_SIZE = 200,
+	};
+
 	class CInfo
 	{
 	public:
 		vec2 m_Pos;
 		int m_Tick;
 	};
-	CInfo m_History[MAX_CLIENTS][200];
+	CInfo m_History[MAX_CLIENTS][HISTORY_SIZE];
 	bool m_HistoryValid[MAX_CLIENTS] = {};
 
+	int m_NumVertices = 0;
+	int m_NumDrawCalls = 0;
+
 	void ClearAllHistory();
 	void ClearHistory(int ClientId);
 	bool ShouldPredictPlayer(int ClientId);
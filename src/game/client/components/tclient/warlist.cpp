@@ -211,10 +211,14 @@ void CWarList::UpdateWarEntry(int Index, const char *pName, const char *pClan, c
 {
 	if(Index >= 0 && Index < static_cast<int>(m_vWarEntries.size()))
 	{
-		str_copy(m_vWarEntries[Index].m_aName, pName);
-		str_copy(m_vWarEntries[Index].m_aClan, pClan);
-		str_copy(m_vWarEntries[Index].m_aReason, pReason);
-		m_vWarEntries[Index].m_pWarType = pType;
+		CWarEntry &Entry = m_vWarEntries[Index];
+		m_WarEntryIndex.Remove(Index, Entry.m_aName, Entry.m_aClan);
+		str_copy(Entry.m_aName, pName);
+		str_copy(Entry.m_aClan, pClan);
+		str_copy(Entry.m_aReason, pReason);
+		Entry.m_pWarType = pType;
+		m_WarEntryIndex.Insert(Index, Entry.m_aName, Entry.m_aClan);
+		m_WarEntriesVersion++;
 	}
 }
 
@@ -257,6 +261,8 @@ void CWarList::AddWarEntry(const char *pName, const char *pClan, const char *pRe
 	if(!g_Config.m_TcWarListAllowDuplicates)
 		RemoveWarEntryDuplicates(pName, pClan);
 	m_vWarEntries.push_back(Entry);
+	m_WarEntryIndex.Add(m_vWarEntries.size() - 1, Entry.m_aName, Entry.m_aClan);
+	m_WarEntriesVersion++;
 }
 
 void CWarList::RemoveWarEntryDuplicates(const char *pName, const char *pClan)
@@ -264,17 +270,16 @@ void CWarList::RemoveWarEntryDuplicates(const char *pName, const char *pClan)
 	if(str_comp(pName, "") == 0 && str_comp(pClan, "") == 0)
 		return;
 
-	for(auto It = m_vWarEntries.begin(); It != m_vWarEntries.end();)
-	{
-		bool IsDuplicate =
-			(str_comp(It->m_aName, pName) == 0) &&
-			(str_comp(It->m_aClan, pClan) == 0);
-
-		if(IsDuplicate)
-			It = m_vWarEntries.erase(It);
-		else
-			++It;
-	}
+	auto IsDuplicate = [&](const CWarEntry &Entry) {
+		return str_comp(Entry.m_aName, pName) == 0 && str_comp(Entry.m_aClan, pClan) == 0;
+	};
+	// All duplicates have the name, or the clan if there is no name, so the index has all of them
+	std::vector<int> vDuplicates = str_comp(pName, "") != 0 ? m_WarEntryIndex.FindName(pName) : m_WarEntryIndex.FindClan(pClan);
+	vDuplicates.erase(std::remove_if(vDuplicates.begin(), vDuplicates.end(), [&](int Entry) { return !IsDuplicate(m_vWarEntries[Entry]); }), vDuplicates.end());
+
+	// Back to front, so the positions of the remaining duplicates don't move
+	for(auto It = vDuplicates.rbegin(); It != vDuplicates.rend(); ++It)
+		RemoveWarEntry(*It);
 }
 
 void CWarList::AddWarType(const char *pType, ColorRGBA Color)
@@ -296,19 +301,43 @@ void CWarList::AddWarType(const char *pType, ColorRGBA Color)
 
 void CWarList::RemoveWarEntry(const char *pName, const char *pClan, const char *pType)
 {
-	CWarType *pWarType = FindWarType(pType);
-	CWarEntry Entry(pWarType, pName, pClan, "");
-	auto It = std::find(m_vWarEntries.begin(), m_vWarEntries.end(), Entry);
-	if(It != m_vWarEntries.end())
-		m_vWarEntries.erase(It);
+	RemoveWarEntry(FindWarEntryIndex(pName, pClan, FindWarType(pType)));
 }
 
 void CWarList::RemoveWarEntry(CWarEntry *Entry)
 {
-	auto It = std::find_if(m_vWarEntries.begin(), m_vWarEntries.end(),
-		[Entry](const CWarEntry &WarEntry) { return &WarEntry == Entry; });
-	if(It != m_vWarEntries.end())
-		m_vWarEntries.erase(It);
+	if(m_vWarEntries.empty() || Entry < m_vWarEntries.data() || Entry >= m_vWarEntries.data() + m_vWarEntries.size())
+		return;
+	RemoveWarEntry(Entry - m_vWarEntries.data());
+}
+
+void CWarList::RemoveWarEntry(int Index)
+{
+	if(Index < 0 || Index >= static_cast<int>(m_vWarEntries.size()))
+		return;
+	m_WarEntryIndex.Erase(Index, m_vWarEntries[Index].m_aName, m_vWarEntries[Index].m_aClan);
+	m_vWarEntries.erase(m_vWarEntries.begin() + Index);
+	m_WarEntriesVersion++;
+}
+
+int CWarList::FindWarEntryIndex(const char *pName, const char *pClan, const CWarType *pType) const
+{
+	// Same as comparing with CWarEntry::operator==, the first entry with the name or clan and type is found
+	int Found = -1;
+	for(const std::vector<int> *pvEntries : {&m_WarEntryIndex.FindName(pName), &m_WarEntryIndex.FindClan(pClan)})
+	{
+		for(int Entry : *pvEntries)
+		{
+			if(Found != -1 && Entry >= Found)
+				break;
+			if(m_vWarEntries[Entry].m_pWarType == pType)
+			{
+				Found = Entry;
+				break;
+			}
+		}
+	}
+	return Found;
 }
 
 void CWarList::RemoveWarType(const char *pType)
@@ -348,12 +377,9 @@ CWarType *CWarList::FindWarType(const char *pType)
 
 CWarEntry *CWarList::FindWarEntry(const char *pName, const char *pClan, const char *pType)
 {
-	CWarType *pWarType = FindWarType(pType);
-	CWarEntry Entry(pWarType, pName, pClan, "");
-	auto It = std::find(m_vWarEntries.begin(), m_vWarEntries.end(), Entry);
-
-	if(It != m_vWarEntries.end())
-		return &(*It);
+	const int Index = FindWarEntryIndex(pName, pClan, FindWarType(pType));
+	if(Index >= 0)
+		return &m_vWarEntries[Index];
 	else
 		return nullptr;
 }
@@ -418,9 +444,26 @@ void CWarList::UpdateWarPlayers()
 
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 	{
-		if(!GameClient()->m_aClients[i].m_Active)
+		const CGameClient::CClientData &Client = GameClient()->m_aClients[i];
+		if(!Client.m_Active)
 			continue;
 
+		CWarPlayerMatches &Matches = m_aWarPlayerMatches[i];
+		if(Matches.m_Version != m_WarEntriesVersion || str_comp(Matches.m_aName, Client.m_aName) != 0 || str_comp(Matches.m_aClan, Client.m_aClan) != 0)
+		{
+			str_copy(Matches.m_aName, Client.m_aName);
+			str_copy(Matches.m_aClan, Client.m_aClan);
+			Matches.m_Version = m_WarEntriesVersion;
+			Matches.m_vNameEntries = m_WarEntryIndex.FindName(Client.m_aName);
+			// Entries matching by name don't also count as clan matches
+			Matches.m_vClanEntries.clear();
+			for(int Entry : m_WarEntryIndex.FindClan(Client.m_aClan))
+			{
+				if(str_comp(m_vWarEntries[Entry].m_aName, Client.m_aName) != 0 || str_comp(Client.m_aName, "") == 0)
+					Matches.m_vClanEntries.push_back(Entry);
+			}
+		}
+
 		m_WarPlayers[i].m_WarName = false;
 		m_WarPlayers[i].m_WarClan = false;
 		memset(m_WarPlayers[i].m_aReason, 0, sizeof(m_WarPlayers[i].m_aReason));
@@ -429,25 +472,25 @@ void CWarList::UpdateWarPlayers()
 		m_WarPlayers[i].m_WarGroupMatches.clear();
 		m_WarPlayers[i].m_WarGroupMatches.resize((int)m_WarTypes.size(), false);
 
-		for(CWarEntry &Entry : m_vWarEntries)
+		// The last matching entry wins
+		for(int Index : Matches.m_vNameEntries)
 		{
-			if(str_comp(GameClient()->m_aClients[i].m_aName, Entry.m_aName) == 0 && str_comp(Entry.m_aName, "") != 0)
-			{
+			const CWarEntry &Entry = m_vWarEntries[Index];
+			str_copy(m_WarPlayers[i].m_aReason, Entry.m_aReason);
+			m_WarPlayers[i].m_WarName = true;
+			m_WarPlayers[i].m_NameColor = Entry.m_pWarType->m_Color;
+			m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
+		}
+		for(int Index : Matches.m_vClanEntries)
+		{
+			const CWarEntry &Entry = m_vWarEntries[Index];
+			// Name war reason has priority over clan war reason
+			if(!m_WarPlayers[i].m_WarName)
 				str_copy(m_WarPlayers[i].m_aReason, Entry.m_aReason);
-				m_WarPlayers[i].m_WarName = true;
-				m_WarPlayers[i].m_NameColor = Entry.m_pWarType->m_Color;
-				m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
-			}
-			else if(str_comp(GameClient()->m_aClients[i].m_aClan, Entry.m_aClan) == 0 && str_comp(Entry.m_aClan, "") != 0)
-			{
-				// Name war reason has priority over clan war reason
-				if(!m_WarPlayers[i].m_WarName)
-					str_copy(m_WarPlayers[i].m_aReason, Entry.m_aReason);
 
-				m_WarPlayers[i].m_WarClan = true;
-				m_WarPlayers[i].m_ClanColor = Entry.m_pWarType->m_Color;
-				m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
-			}
+			m_WarPlayers[i].m_WarClan = true;
+			m_WarPlayers[i].m_ClanColor = Entry.m_pWarType->m_Color;
+			m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
 		}
 	}
 }
@@ -8,6 +8,8 @@
 
 #include <game/client/component.h>
 
+#include "warlist_index.h"
+
 enum
 {
 	MAX_WARLIST_TYPE_LENGTH = 16,
@@ -135,6 +137,25 @@ class CWarList : public CComponent
 
 	static void ConfigSaveCallback(IConfigManager *pConfigManager, void *pUserData);
 
+	// Positions of the entries in m_vWarEntries by name and clan
+	CWarEntryIndex m_WarEntryIndex;
+	// Incremented whenever m_vWarEntries changes
+	int m_WarEntriesVersion = 0;
+
+	// The entries matching a player, only looked up again if the name, clan or the war entries changed
+	class CWarPlayerMatches
+	{
+	public:
+		char m_aName[MAX_NAME_LENGTH] = "";
+		char m_aClan[MAX_CLAN_LENGTH] = "";
+		int m_Version = -1;
+		std::vector<int> m_vNameEntries;
+		std::vector<int> m_vClanEntries;
+	};
+	CWarPlayerMatches m_aWarPlayerMatches[MAX_CLIENTS];
+
+	int FindWarEntryIndex(const char *pName, const char *pClan, const CWarType *pType) const;
+
 public:
 	CWarList();
 	~CWarList() override;
@@ -150,9 +171,8 @@ public:
 	CWarType *m_pWarTypeNone = m_WarTypes[0];
 
 	// Duplicate war entries ARE allowed
+	// Only modify entries through the member functions, they keep the name and clan index up to date
 	std::vector<CWarEntry> m_vWarEntries;
-	// TODO: create an unordered map for war clans and war names, to speed up updating the WarPlayers cache
-	// It should be updated when m_WarList changes
 
 	CWarDataCache m_WarPlayers[MAX_CLIENTS];
 
@@ -0,0 +1,108 @@
+#include "warlist_index.h"
+
+#include <algorithm>
+
+void CWarEntryIndex::Clear()
+{
+	m_NameEntries.clear();
+	m_ClanEntries.clear();
+	m_vEntryLists.clear();
+}
+
+void CWarEntryIndex::Add(int Entry, const char *pName, const char *pClan)
+{
+	CEntryLists &Lists = EntryLists(Entry);
+	if(pName[0] != '\0')
+	{
+		Lists.m_pNameEntries = &m_NameEntries[pName];
+		Lists.m_pNameEntries->push_back(Entry);
+	}
+	if(pClan[0] != '\0')
+	{
+		Lists.m_pClanEntries = &m_ClanEntries[pClan];
+		Lists.m_pClanEntries->push_back(Entry);
+	}
+}
+
+void CWarEntryIndex::Insert(int Entry, const char *pName, const char *pClan)
+{
+	CEntryLists &Lists = EntryLists(Entry);
+	if(std::vector<int> *pEntries = Insert(m_NameEntries, pName, Entry))
+		Lists.m_pNameEntries = pEntries;
+	if(std::vector<int> *pEntries = Insert(m_ClanEntries, pClan, Entry))
+		Lists.m_pClanEntries = pEntries;
+}
+
+void CWarEntryIndex::Remove(int Entry, const char *pName, const char *pClan)
+{
+	const bool RemovedName = Remove(m_NameEntries, pName, Entry);
+	const bool RemovedClan = Remove(m_ClanEntries, pClan, Entry);
+	if(Entry >= (int)m_vEntryLists.size())
+		return;
+	if(RemovedName)
+		m_vEntryLists[Entry].m_pNameEntries = nullptr;
+	if(RemovedClan)
+		m_vEntryLists[Entry].m_pClanEntries = nullptr;
+}
+
+void CWarEntryIndex::Erase(int Entry, const char *pName, const char *pClan)
+{
+	Remove(Entry, pName, pClan);
+	if(Entry >= (int)m_vEntryLists.size())
+		return;
+
+	// Going up keeps the lists sorted, the previous position is already free
+	for(int i = Entry + 1; i < (int)m_vEntryLists.size(); i++)
+	{
+		for(std::vector<int> *pEntries : {m_vEntryLists[i].m_pNameEntries, m_vEntryLists[i].m_pClanEntries})
+		{
+			if(pEntries)
+				--*std::lower_bound(pEntries->begin(), pEntries->end(), i);
+		}
+	}
+	m_vEntryLists.erase(m_vEntryLists.begin() + Entry);
+}
+
+CWarEntryIndex::CEntryLists &CWarEntryIndex::EntryLists(int Entry)
+{
+	if(Entry >= (int)m_vEntryLists.size())
+		m_vEntryLists.resize(Entry + 1);
+	return m_vEntryLists[Entry];
+}
+
+std::vector<int> *CWarEntryIndex::Insert(CEntryMap &Map, const char *pKey, int Entry)
+{
+	if(pKey[0] == '\0')
+		return nullptr;
+	std::vector<int> &vEntries = Map[pKey];
+	vEntries.insert(std::lower_bound(vEntries.begin(), vEntries.end(), Entry), Entry);
+	return &vEntries;
+}
+
+bool CWarEntryIndex::Remove(CEntryMap &Map, const char *pKey, int Entry)
+{
+	if(pKey[0] == '\0')
+		return false;
+	auto It = Map.find(pKey);
+	if(It == Map.end())
+		return false;
+	std::vector<int> &vEntries = It->second;
+	auto EntryIt = std::lower_bound(vEntries.begin(), vEntries.end(), Entry);
+	if(EntryIt == vEntries.end() || *EntryIt != Entry)
+		return false;
+	vEntries.erase(EntryIt);
+	if(vEntries.empty())
+		Map.erase(It);
+	return true;
+}
+
+const std::vector<int> &CWarEntryIndex::Find(const CEntryMap &Map, const char *pKey)
+{
+	static const std::vector<int> s_vNone;
+	if(pKey[0] == '\0')
+		return s_vNone;
+	auto It = Map.find(pKey);
+	if(It == Map.end())
+		return s_vNone;
+	return It->second;
+}
@@ -0,0 +1,74 @@
+#ifndef GAME_CLIENT_COMPONENTS_TCLIENT_WARLIST_INDEX_H
+#define GAME_CLIENT_COMPONENTS_TCLIENT_WARLIST_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Maps the names and clans of war entries to the positions of the
+ * entries in the war list, so players can be matched without scanning
+ * the whole list.
+ */
+class CWarEntryIndex
+{
+public:
+	void Clear();
+
+	/**
+	 * Adds the entry at position `Entry` of the war list. Entries have to be
+	 * added in ascending order, empty names and clans are not indexed.
+	 */
+	void Add(int Entry, const char *pName, const char *pClan);
+
+	/**
+	 * Adds the entry at position `Entry` of the war list in any order, for
+	 * example after its name or clan changed.
+	 */
+	void Insert(int Entry, const char *pName, const char *pClan);
+
+	/**
+	 * Removes the entry at position `Entry` with the given name and clan,
+	 * the positions of the other entries are unchanged.
+	 */
+	void Remove(int Entry, const char *pName, const char *pClan);
+
+	/**
+	 * Removes the entry at position `Entry` and moves all following entries
+	 * one position down, like erasing it from the war list does. Only the
+	 * positions of the following entries are touched, not the whole index.
+	 */
+	void Erase(int Entry, const char *pName, const char *pClan);
+
+	/**
+	 * @return The positions of all entries with the given name or clan in
+	 *         ascending order, empty if there are none
+	 */
+	const std::vector<int> &FindName(const char *pName) const { return Find(m_NameEntries, pName); }
+	const std::vector<int> &FindClan(const char *pClan) const { return Find(m_ClanEntries, pClan); }
+
+	int NumNames() const { return m_NameEntries.size(); }
+	int NumClans() const { return m_ClanEntries.size(); }
+
+private:
+	typedef std::unordered_map<std::string, std::vector<int>> CEntryMap;
+
+	// The position lists an entry is in, elements of unordered maps keep their address
+	class CEntryLists
+	{
+	public:
+		std::vector<int> *m_pNameEntries = nullptr;
+		std::vector<int> *m_pClanEntries = nullptr;
+	};
+
+	static const std::vector<int> &Find(const CEntryMap &Map, const char *pKey);
+	static std::vector<int> *Insert(CEntryMap &Map, const char *pKey, int Entry);
+	static bool Remove(CEntryMap &Map, const char *pKey, int Entry);
+	CEntryLists &EntryLists(int Entry);
+
+	CEntryMap m_NameEntries;
+	CEntryMap m_ClanEntries;
+	std::vector<CEntryLists> m_vEntryLists;
+};
+
+#endif
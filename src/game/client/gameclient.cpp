@@ -443,6 +443,7 @@ void CGameClient::OnInit()
 	}
 
 	m_GameWorld.Init(Collision(), m_aTuningList, &m_MapBugs);
+	m_GameWorld.SetWorkers(&m_PredictionWorkers);
 	OnReset();
 
 	// Set free binds to DDRace binds if it's active
@@ -643,6 +644,8 @@ void CGameClient::OnReset()
 
 	m_PredictedTick = -1;
 	std::fill(std::begin(m_aLastNewPredictedTick), std::end(m_aLastNewPredictedTick), -1);
+	m_PredictionResume.m_Tick = -1;
+	m_PredictionTicksSimulated = 0;
 
 	m_LastRoundStartTick = -1;
 	m_LastRaceTick = -1;
@@ -1238,6 +1241,8 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 	{
 		CNetMsg_Sv_PreInput *pMsg = (CNetMsg_Sv_PreInput *)pRawMsg;
 		m_aClients[pMsg->m_Owner].m_aPreInputs[pMsg->m_IntendedTick % 200] = *pMsg;
+		// the input of an already predicted tick may have changed
+		m_PredictionResume.m_Tick = -1;
 	}
 	else if(MsgId == NETMSGTYPE_SV_SAVECODE)
 	{
@@ -1281,6 +1286,7 @@ void CGameClient::OnShutdown()
 		pComponent->OnShutdown();
 
 	m_LocalServer.KillServer();
+	m_PredictionWorkers.Shutdown();
 }
 
 void CGameClient::OnEnterGame()
@@ -2448,6 +2454,7 @@ void CGameClient::OnNewSnapshot()
 
 	UpdateLocalTuning();
 	m_IsDummySwapping = 0;
+	m_PredictionResume.m_Tick = -1;
 	if(Client()->State() != IClient::STATE_DEMOPLAYBACK)
 		UpdatePrediction();
 }
@@ -2555,6 +2562,10 @@ void CGameClient::ApplyPreInputs(int Tick, bool Direct, CGameWorld &GameWorld)
 
 void CGameClient::OnPredict()
 {
+	m_PredictionTicksSimulated = 0;
+	if(m_PredictionWorkers.NumThreads() != g_Config.m_TcPredictThreads)
+		m_PredictionWorkers.Init(g_Config.m_TcPredictThreads);
+
 	// store the previous values so we can detect prediction errors
 	CCharacterCore BeforePrevChar = m_PredictedPrevChar;
 	CCharacterCore BeforeChar = m_PredictedChar;
@@ -2586,23 +2597,43 @@ void CGameClient::OnPredict()
 	// init
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
 
+	int FinalTickRegular = Client()->PredGameTick(g_Config.m_ClDummy); // The vanilla final tick disregarding fast input
+	int FinalTickSelf = FinalTickRegular + g_Config.m_TcFastInput; // the final tick for just our local tee
+	int FinalTickOthers = FinalTickSelf; // the final tick for all other tees
+	if(g_Config.m_TcFastInput && !g_Config.m_TcFastInputOthers)
+		FinalTickOthers = FinalTickSelf - g_Config.m_TcFastInput;
+
 	// PredictedEvents are only handled in predicted world, so update them here
 	m_GameWorld.m_PredictedEvents = m_PredictedWorld.m_PredictedEvents;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
-
-	// don't predict inactive players, or entities from other teams
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
-			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
-				pChar->Destroy();
 
-	CProjectile *pProjNext = nullptr;
-	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
+	int StartTick = Client()->GameTick(g_Config.m_ClDummy) + 1;
+	const bool Resumed = CanResumePrediction(FinalTickSelf);
+	if(Resumed)
 	{
-		pProjNext = (CProjectile *)pProj->TypeNext();
-		if(IsOtherTeam(pProj->GetOwner()))
+		// TClient: nothing changed since the last prediction, continue from the last tick with confirmed input
+		m_PredictionResumeWorld.m_PredictedEvents = m_PredictedWorld.m_PredictedEvents;
+		m_PredictedWorld.CopyWorld(&m_PredictionResumeWorld);
+		m_PredictedWorld.AdoptParent(&m_GameWorld);
+		StartTick = m_PredictionResume.m_Tick + 1;
+	}
+	else
+	{
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
+
+		// don't predict inactive players, or entities from other teams
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
+				if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
+					pChar->Destroy();
+
+		CProjectile *pProjNext = nullptr;
+		for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
 		{
-			pProj->Destroy();
+			pProjNext = (CProjectile *)pProj->TypeNext();
+			if(IsOtherTeam(pProj->GetOwner()))
+			{
+				pProj->Destroy();
+			}
 		}
 	}
 
@@ -2616,18 +2647,23 @@ void CGameClient::OnPredict()
 	bool RealPredTick = false;
 	// predict
 	// prediction actually happens here
-
-	int FinalTickRegular = Client()->PredGameTick(g_Config.m_ClDummy); // The vanilla final tick disregarding fast input
-	int FinalTickSelf = FinalTickRegular + g_Config.m_TcFastInput; // the final tick for just our local tee
-	int FinalTickOthers = FinalTickSelf; // the final tick for all other tees
-	if(g_Config.m_TcFastInput && !g_Config.m_TcFastInputOthers)
-		FinalTickOthers = FinalTickSelf - g_Config.m_TcFastInput;
-
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= FinalTickSelf; Tick++)
+	for(int Tick = StartTick; Tick <= FinalTickSelf; Tick++)
 	{
 		// fetch the previous characters
 		if(Tick == FinalTickSelf)
 		{
+			// the input of all ticks before the final one is confirmed, remember the world to continue from it next frame
+			if(!IncrementalPrediction())
+				m_PredictionResume.m_Tick = -1;
+			else if(!Resumed || Tick != StartTick)
+			{
+				m_PredictionResumeWorld.CopyWorld(&m_PredictedWorld);
+				m_PredictionResume.m_Tick = Tick - 1;
+				m_PredictionResume.m_SnapTick = Client()->GameTick(g_Config.m_ClDummy);
+				m_PredictionResume.m_Dummy = g_Config.m_ClDummy;
+				m_PredictionResume.m_DummySwapping = m_IsDummySwapping;
+				m_PredictionResume.m_LocalClientId = m_Snap.m_LocalClientId;
+			}
 			m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
 			m_PredictedPrevChar = pLocalChar->GetCore();
 			m_aClients[m_Snap.m_LocalClientId].m_PrevPredicted = pLocalChar->GetCore();
@@ -2678,6 +2714,7 @@ void CGameClient::OnPredict()
 		ApplyPreInputs(Tick, false, m_PredictedWorld);
 
 		m_PredictedWorld.Tick();
+		m_PredictionTicksSimulated++;
 
 		// fetch the current characters
 		if(Tick == FinalTickSelf)
@@ -2839,6 +2876,7 @@ void CGameClient::OnPredict()
 				{
 					m_ExtraPredictedWorld.m_GameTick++;
 					m_ExtraPredictedWorld.Tick();
+					m_PredictionTicksSimulated++;
 				}
 				else
 				{
@@ -2950,6 +2988,7 @@ void CGameClient::OnPredict()
 		if(pDummyInputData && pSmoothDummyChar)
 			pSmoothDummyChar->OnPredictedInput(pDummyInputData);
 		m_PredSmoothingWorld.Tick();
+		m_PredictionTicksSimulated++;
 
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
@@ -3165,6 +3204,24 @@ void CGameClient::OnPredict()
 		m_Ghost.OnNewPredictedSnapshot();
 }
 
+bool CGameClient::IncrementalPrediction() const
+{
+	// prediction that depends on the final tick can't be continued from an earlier tick
+	return g_Config.m_TcPredictIncremental && !g_Config.m_TcFastInput && g_Config.m_ClPredictFreeze != 2;
+}
+
+bool CGameClient::CanResumePrediction(int FinalTick) const
+{
+	if(!IncrementalPrediction())
+		return false;
+	const int SnapTick = Client()->GameTick(g_Config.m_ClDummy);
+	return m_PredictionResume.m_Tick >= SnapTick && m_PredictionResume.m_Tick < FinalTick &&
+	       m_PredictionResume.m_SnapTick == SnapTick &&
+	       m_PredictionResume.m_Dummy == g_Config.m_ClDummy &&
+	       m_PredictionResume.m_DummySwapping == m_IsDummySwapping &&
+	       m_PredictionResume.m_LocalClientId == m_Snap.m_LocalClientId;
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
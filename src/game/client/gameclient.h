@@ -13,6 +13,7 @@
 #include <engine/console.h>
 #include <engine/shared/config.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/worker_group.h>
 
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
@@ -271,6 +272,21 @@ private:
 	int m_PredictedTick;
 	int m_aLastNewPredictedTick[NUM_DUMMIES];
 
+	// TClient: incremental prediction
+	struct SPredictionResume
+	{
+		int m_Tick = -1; // last tick simulated in m_PredictionResumeWorld, -1 if invalid
+		int m_SnapTick = -1; // game tick of the snapshot the cached world was predicted from
+		int m_Dummy = 0;
+		int m_DummySwapping = 0;
+		int m_LocalClientId = -1;
+	} m_PredictionResume;
+	CGameWorld m_PredictionResumeWorld;
+	int m_PredictionTicksSimulated = 0;
+	CWorkerGroup m_PredictionWorkers;
+	bool IncrementalPrediction() const;
+	bool CanResumePrediction(int FinalTick) const;
+
 	int m_LastRoundStartTick;
 	int m_LastRaceTick;
 
@@ -349,6 +365,7 @@ public:
 		return m_NetObjHandler.NumObjCorrections();
 	}
 	const char *NetobjCorrectedOn() { return m_NetObjHandler.CorrectedObjOn(); }
+	int PredictionTicksSimulated() const { return m_PredictionTicksSimulated; }
 
 	bool m_SuppressEvents;
 	bool m_NewTick;
@@ -605,9 +605,18 @@ void CCharacter::ResetInput()
 }
 
 void CCharacter::PreTick()
+{
+	PreTickInput();
+	PreTickCore();
+}
+
+void CCharacter::PreTickInput()
 {
 	DDRaceTick();
+}
 
+void CCharacter::PreTickCore()
+{
 	m_Core.m_Input = m_Input;
 	m_Core.Tick(true, !m_pGameWorld->m_WorldConfig.m_NoWeakHookAndBounce);
 }
@@ -637,7 +646,7 @@ void CCharacter::Tick()
 
 void CCharacter::TickDeferred()
 {
-	m_Core.Move();
+	m_Core.FinishMove();
 	m_Core.Quantize();
 	m_Pos = m_Core.m_Pos;
 }
@@ -28,8 +28,10 @@ public:
 	~CCharacter() override;
 
 	void PreTick() override;
+	void PreTickInput(); // only touches this character, safe to run in parallel for all characters
+	void PreTickCore();
 	void Tick() override;
-	void TickDeferred() override;
+	void TickDeferred() override; // CGameWorld::Tick prepares the moves of all characters first
 
 	bool IsGrounded();
 
@@ -0,0 +1,81 @@
+#ifndef GAME_CLIENT_PREDICTION_ENTITY_POOL_H
+#define GAME_CLIENT_PREDICTION_ENTITY_POOL_H
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+ * Keeps the memory of destroyed entities around, one free list per entity type,
+ * so that the prediction world copies made every frame can construct their
+ * entities into it instead of allocating them again.
+ *
+ * Memory is obtained with `::operator new(sizeof(T))`, so an entity created by
+ * the pool may also be released with a plain `delete`.
+ */
+template<int NumTypes>
+class CEntityPool
+{
+public:
+	CEntityPool() = default;
+	CEntityPool(const CEntityPool &) = delete;
+	CEntityPool &operator=(const CEntityPool &) = delete;
+	~CEntityPool() { Release(); }
+
+	/**
+	 * Copy-constructs an entity of type `Type`, reusing recycled memory if there is any.
+	 *
+	 * @param Type The free list to take the memory from, all entities recycled
+	 * into it must have the same dynamic type `T`.
+	 * @param From The entity to copy.
+	 */
+	template<typename T>
+	T *Copy(int Type, const T &From)
+	{
+		std::vector<void *> &vpFree = m_avpFree[Type];
+		void *pMem;
+		if(vpFree.empty())
+		{
+			pMem = ::operator new(sizeof(T));
+			m_NumAllocations++;
+		}
+		else
+		{
+			pMem = vpFree.back();
+			vpFree.pop_back();
+		}
+		return ::new(pMem) T(From);
+	}
+
+	/**
+	 * Destroys an entity and keeps its memory for the next @link Copy @endlink of the same type.
+	 */
+	template<typename T>
+	void Recycle(int Type, T *pEntity)
+	{
+		pEntity->~T();
+		m_avpFree[Type].push_back(pEntity);
+	}
+
+	/**
+	 * Frees all recycled memory.
+	 */
+	void Release()
+	{
+		for(auto &vpFree : m_avpFree)
+		{
+			for(void *pMem : vpFree)
+				::operator delete(pMem);
+			vpFree.clear();
+		}
+	}
+
+	int NumFree(int Type) const { return m_avpFree[Type].size(); }
+	int64_t NumAllocations() const { return m_NumAllocations; }
+
+private:
+	std::vector<void *> m_avpFree[NumTypes];
+	int64_t m_NumAllocations = 0;
+};
+
+#endif
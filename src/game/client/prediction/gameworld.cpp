@@ -13,10 +13,12 @@
 #include "entity.h"
 
 #include <engine/shared/config.h>
+#include <engine/shared/worker_group.h>
 
 #include <game/client/laser_data.h>
 #include <game/client/pickup_data.h>
 #include <game/client/projectile_data.h>
+#include <game/collision.h>
 #include <game/mapbugs.h>
 #include <game/mapitems.h>
 
@@ -33,6 +35,7 @@ CGameWorld::CGameWorld()
 	for(auto &pCharacter : m_apCharacters)
 		pCharacter = nullptr;
 	m_pCollision = nullptr;
+	m_pWorkers = nullptr;
 	m_GameTick = 0;
 	m_pParent = nullptr;
 	m_pChild = nullptr;
@@ -205,11 +208,12 @@ void CGameWorld::Tick()
 		// If we call PreTick() before, and Tick() after other entities have been processed, it causes physics changes such as a stronger shotgun or grenade.
 		if(m_WorldConfig.m_NoWeakHookAndBounce && i == ENTTYPE_CHARACTER)
 		{
+			TickCharacterInputs();
 			auto *pEnt = m_apFirstEntityTypes[i];
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-				((CCharacter *)pEnt)->PreTick();
+				((CCharacter *)pEnt)->PreTickCore();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -223,7 +227,12 @@ void CGameWorld::Tick()
 		}
 	}
 
-	for(auto *pEnt : m_apFirstEntityTypes)
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+	{
+		if(i == ENTTYPE_CHARACTER)
+			PrepareCharacterMoves();
+
+		auto *pEnt = m_apFirstEntityTypes[i];
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
@@ -231,9 +240,13 @@ void CGameWorld::Tick()
 			pEnt->m_SnapTicks++;
 			pEnt = m_pNextTraverseEntity;
 		}
+	}
 
 	RemoveEntities();
 
+	// TClient
+	Collision()->FlushSolidDistance();
+
 	// update switch state
 	for(auto &Switcher : Switchers())
 	{
@@ -257,6 +270,54 @@ void CGameWorld::Tick()
 	OnModified();
 }
 
+void CGameWorld::CollectTickCharacters()
+{
+	m_NumTickCharacters = 0;
+	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt && m_NumTickCharacters < MAX_CLIENTS; pEnt = pEnt->m_pNextTypeEntity)
+	{
+		m_apTickCharacters[m_NumTickCharacters] = (CCharacter *)pEnt;
+		m_apTickCores[m_NumTickCharacters] = &((CCharacter *)pEnt)->m_Core;
+		m_NumTickCharacters++;
+	}
+}
+
+void CGameWorld::TickCharacterInputs()
+{
+	CollectTickCharacters();
+	// waking up the workers only pays off with enough characters
+	if(m_pWorkers && m_NumTickCharacters >= MIN_PARALLEL_CHARACTERS)
+		m_pWorkers->Run(m_NumTickCharacters, TickCharacterInput, this);
+	else
+		for(int i = 0; i < m_NumTickCharacters; i++)
+			TickCharacterInput(this, i);
+}
+
+void CGameWorld::TickCharacterInput(void *pUser, int Index)
+{
+	// the input and tile state of a character only depends on itself and the map,
+	// so it can be updated for all characters before any of them moves
+	CGameWorld *pThis = static_cast<CGameWorld *>(pUser);
+	pThis->m_apTickCharacters[Index]->PreTickInput();
+}
+
+void CGameWorld::PrepareCharacterMoves()
+{
+	// the tile collision of a character only depends on itself and the map, only
+	// the collision with the other characters has to be done in order
+	CollectTickCharacters();
+	if(m_pWorkers && m_NumTickCharacters >= MIN_PARALLEL_CHARACTERS)
+		m_pWorkers->Run((m_NumTickCharacters + MOVE_BATCH_SIZE - 1) / MOVE_BATCH_SIZE, PrepareCharacterMoveBatch, this);
+	else
+		CCharacterCore::PrepareMoves(m_apTickCores, m_NumTickCharacters);
+}
+
+void CGameWorld::PrepareCharacterMoveBatch(void *pUser, int Index)
+{
+	CGameWorld *pThis = static_cast<CGameWorld *>(pUser);
+	const int First = Index * MOVE_BATCH_SIZE;
+	CCharacterCore::PrepareMoves(pThis->m_apTickCores + First, minimum((int)MOVE_BATCH_SIZE, pThis->m_NumTickCharacters - First));
+}
+
 CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, vec2 &NewPos, const CCharacter *pNotThis, int CollideWith, const CCharacter *pThisOnly)
 {
 	return (CCharacter *)IntersectEntity(Pos0, Pos1, Radius, ENTTYPE_CHARACTER, NewPos, pNotThis, CollideWith, pThisOnly);
@@ -634,12 +695,13 @@ void CGameWorld::CopyWorldClean(CGameWorld *pFrom)
 
 	m_GameTick = pFrom->m_GameTick;
 	m_pCollision = pFrom->m_pCollision;
+	m_pWorkers = pFrom->m_pWorkers;
 	m_WorldConfig = pFrom->m_WorldConfig;
 	m_pTuningList = pFrom->m_pTuningList;
 	m_Teams = pFrom->m_Teams;
 	m_Core.m_vSwitchers = pFrom->m_Core.m_vSwitchers;
-	// delete the previous entities
-	Clear();
+	// recycle the previous entities
+	Clear(true);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		m_apCharacters[i] = 0;
@@ -650,17 +712,17 @@ void CGameWorld::CopyWorldClean(CGameWorld *pFrom)
 	{
 		for(CEntity *pEnt = pFrom->FindLast(Type); pEnt; pEnt = pEnt->TypePrev())
 		{
-			CEntity *pCopy = 0;
+			CEntity *pCopy = nullptr;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = CopyEntity((CProjectile *)pEnt);
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = CopyEntity((CLaser *)pEnt);
 			else if(Type == ENTTYPE_DRAGGER)
-				pCopy = new CDragger(*((CDragger *)pEnt));
+				pCopy = CopyEntity((CDragger *)pEnt);
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = CopyEntity((CCharacter *)pEnt);
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = CopyEntity((CPickup *)pEnt);
 			if(pCopy)
 			{
 				pCopy->m_pParent = nullptr;
@@ -683,14 +745,15 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 
 	m_GameTick = pFrom->m_GameTick;
 	m_pCollision = pFrom->m_pCollision;
+	m_pWorkers = pFrom->m_pWorkers;
 	m_WorldConfig = pFrom->m_WorldConfig;
 	m_pTuningList = pFrom->m_pTuningList;
 	m_pMapBugs = pFrom->m_pMapBugs;
 	m_Teams = pFrom->m_Teams;
 	m_Core.m_vSwitchers = pFrom->m_Core.m_vSwitchers;
 	m_PredictedEvents = pFrom->m_PredictedEvents;
-	// delete the previous entities
-	Clear();
+	// recycle the previous entities
+	Clear(true);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		m_apCharacters[i] = nullptr;
@@ -703,17 +766,17 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 		{
 			CEntity *pCopy = nullptr;
 			if(Type == ENTTYPE_PROJECTILE)
-				pCopy = new CProjectile(*((CProjectile *)pEnt));
+				pCopy = CopyEntity((CProjectile *)pEnt);
 			else if(Type == ENTTYPE_LASER)
-				pCopy = new CLaser(*((CLaser *)pEnt));
+				pCopy = CopyEntity((CLaser *)pEnt);
 			else if(Type == ENTTYPE_DRAGGER)
-				pCopy = new CDragger(*((CDragger *)pEnt));
+				pCopy = CopyEntity((CDragger *)pEnt);
 			else if(Type == ENTTYPE_CHARACTER)
-				pCopy = new CCharacter(*((CCharacter *)pEnt));
+				pCopy = CopyEntity((CCharacter *)pEnt);
 			else if(Type == ENTTYPE_PICKUP)
-				pCopy = new CPickup(*((CPickup *)pEnt));
+				pCopy = CopyEntity((CPickup *)pEnt);
 			else if(Type == ENTTYPE_PLASMA)
-				pCopy = new CPlasma(*((CPlasma *)pEnt));
+				pCopy = CopyEntity((CPlasma *)pEnt);
 			if(pCopy)
 			{
 				pCopy->m_pParent = pEnt;
@@ -725,6 +788,30 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 	m_IsValidCopy = true;
 }
 
+void CGameWorld::AdoptParent(CGameWorld *pParent)
+{
+	// link this world to pParent as if it had been copied from it, entities are matched by their id
+	if(m_pParent && m_pParent->m_pChild == this)
+		m_pParent->m_pChild = nullptr;
+	m_pParent = pParent;
+	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
+		m_pParent->m_pChild->m_IsValidCopy = false;
+	m_pParent->m_pChild = this;
+
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			if(pEnt->m_pParent)
+				pEnt->m_pParent->m_pChild = nullptr;
+			pEnt->m_pParent = pEnt->m_Id < 0 ? nullptr : m_pParent->GetEntity(pEnt->m_Id, Type);
+			if(pEnt->m_pParent)
+				pEnt->m_pParent->m_pChild = pEnt;
+		}
+	}
+	m_IsValidCopy = true;
+}
+
 CEntity *CGameWorld::FindMatch(int ObjId, int ObjType, const void *pObjData)
 {
 	switch(ObjType)
@@ -809,12 +896,35 @@ void CGameWorld::OnModified() const
 		m_pChild->m_IsValidCopy = false;
 }
 
-void CGameWorld::Clear()
+void CGameWorld::Clear(bool Recycle)
 {
 	// delete all entities
-	for(auto &pFirstEntityType : m_apFirstEntityTypes)
-		while(pFirstEntityType)
-			delete pFirstEntityType; // NOLINT(clang-analyzer-cplusplus.NewDelete)
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		while(m_apFirstEntityTypes[Type])
+		{
+			CEntity *pEnt = m_apFirstEntityTypes[Type];
+			if(Recycle && IsPooledType(Type))
+			{
+				// keep the memory around for the next copy, the destructor unlinks the entity
+				m_EntityPool.Recycle(Type, pEnt);
+			}
+			else
+				delete pEnt; // NOLINT(clang-analyzer-cplusplus.NewDelete)
+		}
+	}
+}
+
+bool CGameWorld::IsPooledType(int Type)
+{
+	return Type == ENTTYPE_PROJECTILE || Type == ENTTYPE_LASER || Type == ENTTYPE_DRAGGER ||
+	       Type == ENTTYPE_CHARACTER || Type == ENTTYPE_PICKUP || Type == ENTTYPE_PLASMA;
+}
+
+template<typename T>
+T *CGameWorld::CopyEntity(const T *pFrom)
+{
+	return m_EntityPool.Copy(pFrom->m_ObjType, *pFrom);
 }
 
 bool CGameWorld::EmulateBug(int Bug) const
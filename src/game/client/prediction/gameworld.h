@@ -3,6 +3,8 @@
 #ifndef GAME_CLIENT_PREDICTION_GAMEWORLD_H
 #define GAME_CLIENT_PREDICTION_GAMEWORLD_H
 
+#include "entity_pool.h"
+
 #include <game/gamecore.h>
 #include <game/teamscore.h>
 
@@ -13,6 +15,7 @@ class CCollision;
 class CCharacter;
 class CEntity;
 class CMapBugs;
+class CWorkerGroup;
 
 class CGameWorld
 {
@@ -38,6 +41,7 @@ public:
 	CGameWorld();
 	~CGameWorld();
 	void Init(CCollision *pCollision, CTuningParams *pTuningList, const CMapBugs *pMapBugs);
+	void SetWorkers(CWorkerGroup *pWorkers) { m_pWorkers = pWorkers; } // TClient
 
 	CEntity *FindFirst(int Type);
 	CEntity *FindLast(int Type);
@@ -100,8 +104,9 @@ public:
 	void NetObjEnd();
 	void CopyWorld(CGameWorld *pFrom);
 	void CopyWorldClean(CGameWorld *pFrom); // TClient
+	void AdoptParent(CGameWorld *pParent); // TClient
 	CEntity *FindMatch(int ObjId, int ObjType, const void *pObjData);
-	void Clear();
+	void Clear(bool Recycle = false);
 
 	const CTuningParams *TuningList() const { return m_pTuningList; }
 	CTuningParams *TuningList() { return m_pTuningList; }
@@ -142,6 +147,12 @@ public:
 
 private:
 	void RemoveEntities();
+	static bool IsPooledType(int Type);
+	template<typename T>
+	T *CopyEntity(const T *pFrom);
+
+	// memory of entities removed by Clear(true), reused by CopyWorld to avoid allocations on every prediction
+	CEntityPool<NUM_ENTTYPES> m_EntityPool;
 
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
@@ -151,6 +162,22 @@ private:
 	CCollision *m_pCollision;
 	CTuningParams *m_pTuningList;
 	const CMapBugs *m_pMapBugs;
+	CWorkerGroup *m_pWorkers;
+
+	// per character phases of the tick that can be spread over m_pWorkers
+	enum
+	{
+		MIN_PARALLEL_CHARACTERS = 16,
+		MOVE_BATCH_SIZE = 8,
+	};
+	void CollectTickCharacters();
+	void TickCharacterInputs();
+	static void TickCharacterInput(void *pUser, int Index);
+	void PrepareCharacterMoves();
+	static void PrepareCharacterMoveBatch(void *pUser, int Index);
+	int m_NumTickCharacters = 0;
+	CCharacter *m_apTickCharacters[MAX_CLIENTS];
+	CCharacterCore *m_apTickCores[MAX_CLIENTS];
 };
 
 class CCharOrder
@@ -13,6 +13,7 @@
 #include <game/layers.h>
 #include <game/mapitems.h>
 
+#include <algorithm>
 #include <cmath>
 
 vec2 ClampVel(int MoveRestriction, vec2 Vel)
@@ -55,6 +56,7 @@ void CCollision::Init(class CLayers *pLayers)
 	m_Width = m_pLayers->GameLayer()->m_Width;
 	m_Height = m_pLayers->GameLayer()->m_Height;
 	m_pTiles = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data));
+	InitSolidMap();
 
 	if(m_pLayers->TeleLayer())
 	{
@@ -154,6 +156,9 @@ void CCollision::Unload()
 	m_Width = 0;
 	m_Height = 0;
 	m_pLayers = nullptr;
+	m_vSolidBits.clear();
+	m_vSolidDistance.clear();
+	m_vClearedSolidTiles.clear();
 
 	m_HighestSwitchNumber = 0;
 
@@ -171,6 +176,129 @@ void CCollision::Unload()
 	m_pDoor = nullptr;
 }
 
+void CCollision::InitSolidMap()
+{
+	const int NumTiles = m_Width * m_Height;
+	m_vSolidBits.assign((NumTiles + 7) / 8, 0);
+	m_vSolidDistance.assign(NumTiles, 0);
+	m_vClearedSolidTiles.clear();
+	for(int i = 0; i < NumTiles; i++)
+	{
+		if(m_pTiles[i].m_Index == TILE_SOLID || m_pTiles[i].m_Index == TILE_NOHOOK)
+			m_vSolidBits[i / 8] |= 1 << (i % 8);
+	}
+	UpdateSolidDistance(0, 0, m_Width - 1, m_Height - 1);
+}
+
+void CCollision::UpdateSolidDistance(int MinX, int MinY, int MaxX, int MaxY)
+{
+	// only solid tiles up to MAX_SOLID_DISTANCE tiles away can affect the updated tiles
+	const int RegionX = maximum(MinX - MAX_SOLID_DISTANCE, 0);
+	const int RegionY = maximum(MinY - MAX_SOLID_DISTANCE, 0);
+	const int RegionWidth = minimum(MaxX + MAX_SOLID_DISTANCE, m_Width - 1) - RegionX + 1;
+	const int RegionHeight = minimum(MaxY + MAX_SOLID_DISTANCE, m_Height - 1) - RegionY + 1;
+	std::vector<uint8_t> vDistance((size_t)RegionWidth * RegionHeight);
+	for(int y = 0; y < RegionHeight; y++)
+	{
+		for(int x = 0; x < RegionWidth; x++)
+		{
+			const int Index = (RegionY + y) * m_Width + RegionX + x;
+			vDistance[y * RegionWidth + x] = (m_vSolidBits[Index / 8] >> (Index % 8)) & 1 ? 0 : MAX_SOLID_DISTANCE;
+		}
+	}
+
+	// two pass distance transform, with all 8 neighbours at distance 1 this is exact for the chebyshev distance
+	const auto &&Relax = [&](int x, int y, int NeighbourX, int NeighbourY) {
+		if(NeighbourX < 0 || NeighbourX >= RegionWidth || NeighbourY < 0 || NeighbourY >= RegionHeight)
+			return;
+		uint8_t &Distance = vDistance[y * RegionWidth + x];
+		Distance = std::min<int>(Distance, vDistance[NeighbourY * RegionWidth + NeighbourX] + 1);
+	};
+	for(int y = 0; y < RegionHeight; y++)
+	{
+		for(int x = 0; x < RegionWidth; x++)
+		{
+			Relax(x, y, x - 1, y);
+			Relax(x, y, x - 1, y - 1);
+			Relax(x, y, x, y - 1);
+			Relax(x, y, x + 1, y - 1);
+		}
+	}
+	for(int y = RegionHeight - 1; y >= 0; y--)
+	{
+		for(int x = RegionWidth - 1; x >= 0; x--)
+		{
+			Relax(x, y, x + 1, y);
+			Relax(x, y, x + 1, y + 1);
+			Relax(x, y, x, y + 1);
+			Relax(x, y, x - 1, y + 1);
+		}
+	}
+
+	for(int y = maximum(MinY, 0); y <= minimum(MaxY, m_Height - 1); y++)
+	{
+		for(int x = maximum(MinX, 0); x <= minimum(MaxX, m_Width - 1); x++)
+			m_vSolidDistance[y * m_Width + x] = vDistance[(y - RegionY) * RegionWidth + x - RegionX];
+	}
+}
+
+void CCollision::SetSolid(int Index, bool Solid)
+{
+	if((bool)((m_vSolidBits[Index / 8] >> (Index % 8)) & 1) == Solid)
+		return;
+	m_vSolidBits[Index / 8] ^= 1 << (Index % 8);
+	if(!Solid)
+	{
+		// the distances around the tile are too small now, that only makes
+		// IntersectLine skip less, so they are rebuilt once per tick
+		if(std::find(m_vClearedSolidTiles.begin(), m_vClearedSolidTiles.end(), Index) == m_vClearedSolidTiles.end())
+			m_vClearedSolidTiles.push_back(Index);
+		return;
+	}
+
+	// a new solid tile can only make the tiles around it closer to a solid tile
+	const int TileX = Index % m_Width;
+	const int TileY = Index / m_Width;
+	const int MinX = maximum(TileX - MAX_SOLID_DISTANCE + 1, 0);
+	const int MaxX = minimum(TileX + MAX_SOLID_DISTANCE - 1, m_Width - 1);
+	for(int y = maximum(TileY - MAX_SOLID_DISTANCE + 1, 0); y <= minimum(TileY + MAX_SOLID_DISTANCE - 1, m_Height - 1); y++)
+	{
+		const int DistanceY = absolute(y - TileY);
+		uint8_t *pRow = &m_vSolidDistance[y * m_Width];
+		for(int x = MinX; x <= MaxX; x++)
+			pRow[x] = minimum<int>(pRow[x], maximum(absolute(x - TileX), DistanceY));
+	}
+}
+
+void CCollision::FlushSolidDistance()
+{
+	for(int Index : m_vClearedSolidTiles)
+	{
+		const int TileX = Index % m_Width;
+		const int TileY = Index / m_Width;
+		UpdateSolidDistance(TileX - MAX_SOLID_DISTANCE + 1, TileY - MAX_SOLID_DISTANCE + 1, TileX + MAX_SOLID_DISTANCE - 1, TileY + MAX_SOLID_DISTANCE - 1);
+	}
+	m_vClearedSolidTiles.clear();
+}
+
+int CCollision::EmptySteps(int x, int y, float StepLength, int MaxSteps) const
+{
+	const int Nx = std::clamp(x / 32, 0, m_Width - 1);
+	const int Ny = std::clamp(y / 32, 0, m_Height - 1);
+	const int Distance = m_vSolidDistance[Ny * m_Width + Nx];
+	if(Distance < 2)
+		return 0;
+
+	// Positions within (Distance - 1) tiles are not solid. GetTile divides
+	// rounded positions with truncation, so positions can end up one tile further
+	// apart than their distance suggests, and rounding as well as float
+	// inaccuracies add up to a few more pixels.
+	const float Reach = (Distance - 1) * 32.0f - 4.0f;
+	if(StepLength * MaxSteps <= Reach)
+		return MaxSteps;
+	return (int)(Reach / StepLength);
+}
+
 void CCollision::FillAntibot(CAntibotMapData *pMapData) const
 {
 	pMapData->m_Width = m_Width;
@@ -331,6 +459,12 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
 	vec2 Last = Pos0;
+	// TClient: skip steps in empty space, far away from the map float inaccuracies are too large for that
+	const float MaxCoordinate = 1 << 19;
+	const bool SkipEmpty = !m_vSolidDistance.empty() &&
+			       maximum(absolute(Pos0.x), absolute(Pos0.y)) < MaxCoordinate &&
+			       maximum(absolute(Pos1.x), absolute(Pos1.y)) < MaxCoordinate;
+	const float StepLength = maximum(absolute(Pos1.x - Pos0.x), absolute(Pos1.y - Pos0.y)) / End;
 	for(int i = 0; i <= End; i++)
 	{
 		float a = i / (float)End;
@@ -348,6 +482,17 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 			return GetCollisionAt(ix, iy);
 		}
 
+		if(SkipEmpty)
+		{
+			// the skipped steps are known to be empty, continue as if they were checked
+			const int Skip = EmptySteps(ix, iy, StepLength, End - i);
+			if(Skip > 0)
+			{
+				i += Skip;
+				Pos = mix(Pos0, Pos1, i / (float)End);
+			}
+		}
+
 		Last = Pos;
 	}
 	if(pOutCollision)
@@ -597,8 +742,12 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elast
 
 int CCollision::IsSolid(int x, int y) const
 {
-	const int Index = GetTile(x, y);
-	return Index == TILE_SOLID || Index == TILE_NOHOOK;
+	if(m_vSolidBits.empty())
+		return false;
+	const int Nx = std::clamp(x / 32, 0, m_Width - 1);
+	const int Ny = std::clamp(y / 32, 0, m_Height - 1);
+	const int Index = Ny * m_Width + Nx;
+	return (m_vSolidBits[Index / 8] >> (Index % 8)) & 1;
 }
 
 bool CCollision::IsThrough(int x, int y, int OffsetX, int OffsetY, vec2 Pos0, vec2 Pos1) const
@@ -1079,6 +1228,7 @@ void CCollision::SetCollisionAt(float x, float y, int Index)
 	int Ny = std::clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = Index;
+	SetSolid(Ny * m_Width + Nx, Index == TILE_SOLID || Index == TILE_NOHOOK);
 }
 
 void CCollision::SetDoorCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -7,6 +7,7 @@
 
 #include <engine/shared/protocol.h>
 
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -53,8 +54,35 @@ public:
 	void MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, vec2 Elasticity, bool *pGrounded = nullptr) const;
 	bool TestBox(vec2 Pos, vec2 Size) const;
 
+	// TClient
+	/**
+	 * Boxes for @link MoveBoxes @endlink in structure-of-arrays layout,
+	 * positions and velocities are updated in place. `m_pGrounded` is
+	 * optional, it is only ever set to `true`.
+	 */
+	struct SMoveBatch
+	{
+		int m_Num = 0;
+		float *m_pPosX = nullptr;
+		float *m_pPosY = nullptr;
+		float *m_pVelX = nullptr;
+		float *m_pVelY = nullptr;
+		bool *m_pGrounded = nullptr;
+	};
+
+	/**
+	 * Batched version of @link MoveBox @endlink. Several boxes are processed at
+	 * once using SIMD where available, the results are identical to calling
+	 * `MoveBox` for every box.
+	 */
+	void MoveBoxes(const SMoveBatch &Batch, vec2 Size, vec2 Elasticity) const;
+
 	// DDRace
 	void SetCollisionAt(float x, float y, int Index);
+	// TClient: rebuilds the solid distances around the tiles that stopped being solid, called once per tick
+	void FlushSolidDistance();
+	// TClient: the distance in tiles from the tile to the closest solid tile, see m_vSolidDistance
+	int SolidDistance(int TileX, int TileY) const { return m_vSolidDistance[TileY * m_Width + TileX]; }
 	void SetDoorCollisionAt(float x, float y, int Type, int Flags, int Number);
 	void GetDoorTile(int Index, CDoorTile *pDoorTile) const;
 	int GetFrontCollisionAt(float x, float y) const { return GetFrontTile(round_to_int(x), round_to_int(y)); }
@@ -145,6 +173,17 @@ public:
 	const std::vector<vec2> &TeleOthers(int Number) { return m_TeleOthers[Number]; }
 
 private:
+	// TClient
+	enum
+	{
+		// distances are capped to keep the updates from SetCollisionAt local
+		MAX_SOLID_DISTANCE = 32,
+	};
+	void InitSolidMap();
+	void UpdateSolidDistance(int MinX, int MinY, int MaxX, int MaxY);
+	void SetSolid(int Index, bool Solid);
+	int EmptySteps(int x, int y, float StepLength, int MaxSteps) const;
+
 	CLayers *m_pLayers;
 
 	int m_Width;
@@ -158,6 +197,13 @@ private:
 	CTuneTile *m_pTune;
 	CDoorTile *m_pDoor;
 
+	// TClient: 1 bit per game tile, set for TILE_SOLID and TILE_NOHOOK
+	std::vector<uint8_t> m_vSolidBits;
+	// TClient: per game tile, the chebyshev distance in tiles to the closest solid tile, capped at MAX_SOLID_DISTANCE.
+	// Around the tiles in m_vClearedSolidTiles the distances may be too small until FlushSolidDistance.
+	std::vector<uint8_t> m_vSolidDistance;
+	std::vector<int> m_vClearedSolidTiles;
+
 	// TILE_TELEIN
 	std::map<int, std::vector<vec2>> m_TeleIns;
 	// TILE_TELEOUT
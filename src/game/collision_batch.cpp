@@ -0,0 +1,306 @@
+#include <base/math.h>
+#include <base/vmath.h>
+
+#include <game/collision.h>
+#include <game/mapitems.h>
+
+#include <algorithm>
+#include <cstdint>
+
+// The SIMD paths only use operations that are exactly rounded (add, sub, mul,
+// truncating conversion) in the same order as the scalar code, so their results
+// are bit-identical to it as long as the compiler doesn't fuse multiplications
+// and additions, which the build disables with -ffp-contract=off. 32-bit x86 may
+// compute the scalar code with x87 precision, it uses the scalar fallback like
+// all other architectures.
+#if defined(__AVX2__)
+#define COLLISION_BATCH_AVX2
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64)
+#define COLLISION_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+struct STileMap
+{
+	const CTile *m_pTiles;
+	int m_Width;
+	int m_Height;
+
+	// same as CCollision::GetTile, but returns the raw index
+	int Tile(int x, int y) const
+	{
+		const int Nx = std::clamp(x / 32, 0, m_Width - 1);
+		const int Ny = std::clamp(y / 32, 0, m_Height - 1);
+		return m_pTiles[Ny * m_Width + Nx].m_Index;
+	}
+
+	static bool IsSolid(int Index) { return Index == TILE_SOLID || Index == TILE_NOHOOK; }
+};
+
+#if defined(COLLISION_BATCH_AVX2)
+class CLanes
+{
+public:
+	enum
+	{
+		NUM = 8,
+	};
+	typedef __m256 F;
+	typedef __m256 M;
+
+	static F Load(const float *pData) { return _mm256_loadu_ps(pData); }
+	static void Store(float *pData, F Value) { _mm256_storeu_ps(pData, Value); }
+	static F Set(float Value) { return _mm256_set1_ps(Value); }
+	static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static M Greater(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static M Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static M And(M a, M b) { return _mm256_and_ps(a, b); }
+	static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+	static M AndNot(M a, M b) { return _mm256_andnot_ps(b, a); }
+	static M True() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+	static M False() { return _mm256_setzero_ps(); }
+	static F Select(M Mask, F a, F b) { return _mm256_blendv_ps(b, a, Mask); }
+	static int Bits(M Mask) { return _mm256_movemask_ps(Mask); }
+
+	static M Solid(const STileMap &Map, F X, F Y, int *pTiles)
+	{
+		const __m256i Zero = _mm256_setzero_si256();
+		// x / 32 truncates while the shift floors, both are clamped to 0 for negative values
+		const __m256i Nx = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(RoundToInt(X), 5), Zero), _mm256_set1_epi32(Map.m_Width - 1));
+		const __m256i Ny = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(RoundToInt(Y), 5), Zero), _mm256_set1_epi32(Map.m_Height - 1));
+		const __m256i Index = _mm256_add_epi32(_mm256_mullo_epi32(Ny, _mm256_set1_epi32(Map.m_Width)), Nx);
+		// CTile is 4 bytes with m_Index as the first one
+		const __m256i Tiles = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int *>(Map.m_pTiles), Index, 4), _mm256_set1_epi32(0xff));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(pTiles), Tiles);
+		return _mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_cmpeq_epi32(Tiles, _mm256_set1_epi32(TILE_SOLID)),
+			_mm256_cmpeq_epi32(Tiles, _mm256_set1_epi32(TILE_NOHOOK))));
+	}
+
+private:
+	static __m256i RoundToInt(F a)
+	{
+		const F Half = Select(Greater(a, _mm256_setzero_ps()), Set(0.5f), Set(-0.5f));
+		return _mm256_cvttps_epi32(Add(a, Half));
+	}
+};
+#elif defined(COLLISION_BATCH_SSE2)
+class CLanes
+{
+public:
+	enum
+	{
+		NUM = 4,
+	};
+	typedef __m128 F;
+	typedef __m128 M;
+
+	static F Load(const float *pData) { return _mm_loadu_ps(pData); }
+	static void Store(float *pData, F Value) { _mm_storeu_ps(pData, Value); }
+	static F Set(float Value) { return _mm_set1_ps(Value); }
+	static F Add(F a, F b) { return _mm_add_ps(a, b); }
+	static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static M Greater(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static M Equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+	static M And(M a, M b) { return _mm_and_ps(a, b); }
+	static M Or(M a, M b) { return _mm_or_ps(a, b); }
+	static M AndNot(M a, M b) { return _mm_andnot_ps(b, a); }
+	static M True() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+	static M False() { return _mm_setzero_ps(); }
+	static F Select(M Mask, F a, F b) { return _mm_or_ps(_mm_and_ps(Mask, a), _mm_andnot_ps(Mask, b)); }
+	static int Bits(M Mask) { return _mm_movemask_ps(Mask); }
+
+	static M Solid(const STileMap &Map, F X, F Y, int *pTiles)
+	{
+		// see the AVX2 version, SSE2 lacks 32-bit min, max and multiplication as well as gathers
+		const __m128i Nx = Clamp(_mm_srai_epi32(RoundToInt(X), 5), Map.m_Width - 1);
+		const __m128i Ny = Clamp(_mm_srai_epi32(RoundToInt(Y), 5), Map.m_Height - 1);
+		const __m128i Width = _mm_set1_epi32(Map.m_Width);
+		const __m128i Even = _mm_mul_epu32(Ny, Width);
+		const __m128i Odd = _mm_mul_epu32(_mm_srli_epi64(Ny, 32), Width);
+		const __m128i Rows = _mm_unpacklo_epi32(_mm_shuffle_epi32(Even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(Odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		alignas(16) int aIndex[NUM];
+		_mm_store_si128(reinterpret_cast<__m128i *>(aIndex), _mm_add_epi32(Rows, Nx));
+		const __m128i Tiles = _mm_set_epi32(Map.m_pTiles[aIndex[3]].m_Index, Map.m_pTiles[aIndex[2]].m_Index, Map.m_pTiles[aIndex[1]].m_Index, Map.m_pTiles[aIndex[0]].m_Index);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pTiles), Tiles);
+		return _mm_castsi128_ps(_mm_or_si128(
+			_mm_cmpeq_epi32(Tiles, _mm_set1_epi32(TILE_SOLID)),
+			_mm_cmpeq_epi32(Tiles, _mm_set1_epi32(TILE_NOHOOK))));
+	}
+
+private:
+	static __m128i RoundToInt(F a)
+	{
+		const F Half = Select(Greater(a, _mm_setzero_ps()), Set(0.5f), Set(-0.5f));
+		return _mm_cvttps_epi32(Add(a, Half));
+	}
+
+	static __m128i Clamp(__m128i a, int Max)
+	{
+		a = _mm_andnot_si128(_mm_srai_epi32(a, 31), a);
+		const __m128i Limit = _mm_set1_epi32(Max);
+		const __m128i Over = _mm_cmpgt_epi32(a, Limit);
+		return _mm_or_si128(_mm_and_si128(Over, Limit), _mm_andnot_si128(Over, a));
+	}
+};
+#endif
+
+#if defined(COLLISION_BATCH_AVX2) || defined(COLLISION_BATCH_SSE2)
+#define COLLISION_BATCH_SIMD
+
+typedef CLanes::F F;
+typedef CLanes::M M;
+typedef CLanes L;
+
+M TestBoxLanes(const STileMap &Map, F X, F Y, F HalfX, F HalfY)
+{
+	int aTiles[L::NUM];
+	const F Left = L::Sub(X, HalfX);
+	const F Right = L::Add(X, HalfX);
+	const F Top = L::Sub(Y, HalfY);
+	const F Bottom = L::Add(Y, HalfY);
+	M Hit = L::Solid(Map, Left, Top, aTiles);
+	Hit = L::Or(Hit, L::Solid(Map, Right, Top, aTiles));
+	Hit = L::Or(Hit, L::Solid(Map, Left, Bottom, aTiles));
+	return L::Or(Hit, L::Solid(Map, Right, Bottom, aTiles));
+}
+
+// Boxes move different distances, so instead of stepping a fixed group of boxes
+// until the farthest one is done, a lane is refilled with the next box as soon as
+// its current one stops moving.
+void MoveBoxesLanes(const STileMap &Map, const CCollision::SMoveBatch &Batch, vec2 Size, vec2 Elasticity)
+{
+	float aPosX[L::NUM], aPosY[L::NUM], aVelX[L::NUM], aVelY[L::NUM];
+	float aMax[L::NUM], aFraction[L::NUM], aStep[L::NUM];
+	int aIndex[L::NUM];
+	int Next = 0;
+	int Occupied = 0;
+	int Grounded = 0;
+
+	const auto &&Refill = [&](int Lane) {
+		Grounded &= ~(1 << Lane);
+		while(Next < Batch.m_Num)
+		{
+			const int Index = Next++;
+			const vec2 Vel(Batch.m_pVelX[Index], Batch.m_pVelY[Index]);
+			const float Distance = length(Vel);
+			// boxes that don't move keep their position and velocity
+			if(!(Distance > 0.00001f))
+				continue;
+			const int Max = (int)Distance;
+			aIndex[Lane] = Index;
+			aPosX[Lane] = Batch.m_pPosX[Index];
+			aPosY[Lane] = Batch.m_pPosY[Index];
+			aVelX[Lane] = Vel.x;
+			aVelY[Lane] = Vel.y;
+			aMax[Lane] = (float)Max;
+			aFraction[Lane] = 1.0f / (float)(Max + 1);
+			aStep[Lane] = 0.0f;
+			Occupied |= 1 << Lane;
+			return;
+		}
+		aPosX[Lane] = aPosY[Lane] = aVelX[Lane] = aVelY[Lane] = 0.0f;
+		aMax[Lane] = aFraction[Lane] = aStep[Lane] = 0.0f;
+		Occupied &= ~(1 << Lane);
+	};
+	for(int Lane = 0; Lane < L::NUM; Lane++)
+		Refill(Lane);
+
+	const F Zero = L::Set(0.0f);
+	const F One = L::Set(1.0f);
+	const F HalfX = L::Set(Size.x * 0.5f);
+	const F HalfY = L::Set(Size.y * 0.5f);
+	const float ElasticityY = std::clamp(Elasticity.y, -1.0f, 1.0f);
+	const F BounceX = L::Set(-std::clamp(Elasticity.x, -1.0f, 1.0f));
+	const F BounceY = L::Set(-ElasticityY);
+	const M CanGround = ElasticityY > 0 ? L::True() : L::False();
+
+	F PosX = L::Load(aPosX), PosY = L::Load(aPosY), VelX = L::Load(aVelX), VelY = L::Load(aVelY);
+	F Max = L::Load(aMax), Fraction = L::Load(aFraction), Step = L::Load(aStep);
+	while(Occupied)
+	{
+		F NewX = L::Add(PosX, L::Mul(VelX, Fraction));
+		F NewY = L::Add(PosY, L::Mul(VelY, Fraction));
+		M Stop = L::Greater(Step, Max);
+		Stop = L::Or(Stop, L::And(L::Equal(VelX, Zero), L::Equal(VelY, Zero)));
+		Stop = L::Or(Stop, L::And(L::Equal(NewX, PosX), L::Equal(NewY, PosY)));
+		if(const int StopBits = L::Bits(Stop) & Occupied)
+		{
+			L::Store(aPosX, PosX);
+			L::Store(aPosY, PosY);
+			L::Store(aVelX, VelX);
+			L::Store(aVelY, VelY);
+			L::Store(aStep, Step);
+			for(int Lane = 0; Lane < L::NUM; Lane++)
+			{
+				if(!(StopBits & (1 << Lane)))
+					continue;
+				const int Index = aIndex[Lane];
+				Batch.m_pPosX[Index] = aPosX[Lane];
+				Batch.m_pPosY[Index] = aPosY[Lane];
+				Batch.m_pVelX[Index] = aVelX[Lane];
+				Batch.m_pVelY[Index] = aVelY[Lane];
+				if(Batch.m_pGrounded && (Grounded & (1 << Lane)))
+					Batch.m_pGrounded[Index] = true;
+				Refill(Lane);
+			}
+			PosX = L::Load(aPosX);
+			PosY = L::Load(aPosY);
+			VelX = L::Load(aVelX);
+			VelY = L::Load(aVelY);
+			Max = L::Load(aMax);
+			Fraction = L::Load(aFraction);
+			Step = L::Load(aStep);
+			continue;
+		}
+
+		// all occupied lanes are moving
+		const M Hit = TestBoxLanes(Map, NewX, NewY, HalfX, HalfY);
+		if(L::Bits(Hit))
+		{
+			const M HitY = L::And(Hit, TestBoxLanes(Map, PosX, NewY, HalfX, HalfY));
+			const M HitX = L::And(Hit, TestBoxLanes(Map, NewX, PosY, HalfX, HalfY));
+			const M Neither = L::AndNot(L::AndNot(Hit, HitY), HitX);
+			const M ResetY = L::Or(HitY, Neither);
+			const M ResetX = L::Or(HitX, Neither);
+			Grounded |= L::Bits(L::And(L::And(ResetY, CanGround), L::Greater(VelY, Zero)));
+			NewY = L::Select(ResetY, PosY, NewY);
+			VelY = L::Select(ResetY, L::Mul(VelY, BounceY), VelY);
+			NewX = L::Select(ResetX, PosX, NewX);
+			VelX = L::Select(ResetX, L::Mul(VelX, BounceX), VelX);
+		}
+		PosX = NewX;
+		PosY = NewY;
+		Step = L::Add(Step, One);
+	}
+}
+#endif
+
+}
+
+void CCollision::MoveBoxes(const SMoveBatch &Batch, vec2 Size, vec2 Elasticity) const
+{
+#if defined(COLLISION_BATCH_SIMD)
+	if(m_pTiles)
+	{
+		MoveBoxesLanes(STileMap{m_pTiles, m_Width, m_Height}, Batch, Size, Elasticity);
+		return;
+	}
+#endif
+	for(int i = 0; i < Batch.m_Num; i++)
+	{
+		vec2 Pos(Batch.m_pPosX[i], Batch.m_pPosY[i]);
+		vec2 Vel(Batch.m_pVelX[i], Batch.m_pVelY[i]);
+		MoveBox(&Pos, &Vel, Size, Elasticity, Batch.m_pGrounded ? &Batch.m_pGrounded[i] : nullptr);
+		Batch.m_pPosX[i] = Pos.x;
+		Batch.m_pPosY[i] = Pos.y;
+		Batch.m_pVelX[i] = Vel.x;
+		Batch.m_pVelY[i] = Vel.y;
+	}
+}
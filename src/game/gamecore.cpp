@@ -146,6 +146,9 @@ void CCharacterCore::Reset()
 {
 	m_Pos = vec2(0, 0);
 	m_Vel = vec2(0, 0);
+	m_MoveNewPos = vec2(0, 0);
+	m_MoveOldVelX = 0.0f;
+	m_MoveRampValue = 1.0f;
 	m_NewHook = false;
 	m_HookPos = vec2(0, 0);
 	m_HookDir = vec2(0, 0);
@@ -528,19 +531,82 @@ void CCharacterCore::TickDeferred()
 
 void CCharacterCore::Move()
 {
-	float RampValue = VelocityRamp(length(m_Vel) * 50, m_Tuning.m_VelrampStart, m_Tuning.m_VelrampRange, m_Tuning.m_VelrampCurvature);
+	PrepareMove();
+	FinishMove();
+}
 
-	m_Vel.x = m_Vel.x * RampValue;
+void CCharacterCore::PrepareMove()
+{
+	StartMove();
+	bool Grounded = false;
+	m_pCollision->MoveBox(&m_MoveNewPos, &m_Vel, PhysicalSizeVec2(), MoveElasticity(), &Grounded);
+	EndMove(Grounded);
+}
 
-	vec2 NewPos = m_Pos;
+void CCharacterCore::PrepareMoves(CCharacterCore *const *ppCores, int Num)
+{
+	dbg_assert(Num <= MAX_CLIENTS, "too many characters to move at once");
+	float aPosX[MAX_CLIENTS], aPosY[MAX_CLIENTS], aVelX[MAX_CLIENTS], aVelY[MAX_CLIENTS];
+	bool aGrounded[MAX_CLIENTS];
 
-	vec2 OldVel = m_Vel;
-	bool Grounded = false;
-	m_pCollision->MoveBox(&NewPos, &m_Vel, PhysicalSizeVec2(),
-		vec2(m_Tuning.m_GroundElasticityX,
-			m_Tuning.m_GroundElasticityY),
-		&Grounded);
+	// characters in different tune zones can have a different elasticity, move the ones that share it together
+	int First = 0;
+	while(First < Num)
+	{
+		const CCollision *pCollision = ppCores[First]->m_pCollision;
+		const vec2 Elasticity = ppCores[First]->MoveElasticity();
+		int End = First + 1;
+		while(End < Num && ppCores[End]->m_pCollision == pCollision && ppCores[End]->MoveElasticity() == Elasticity)
+			End++;
 
+		for(int i = First; i < End; i++)
+		{
+			CCharacterCore *pCore = ppCores[i];
+			pCore->StartMove();
+			aPosX[i] = pCore->m_MoveNewPos.x;
+			aPosY[i] = pCore->m_MoveNewPos.y;
+			aVelX[i] = pCore->m_Vel.x;
+			aVelY[i] = pCore->m_Vel.y;
+			aGrounded[i] = false;
+		}
+
+		CCollision::SMoveBatch Batch;
+		Batch.m_Num = End - First;
+		Batch.m_pPosX = aPosX + First;
+		Batch.m_pPosY = aPosY + First;
+		Batch.m_pVelX = aVelX + First;
+		Batch.m_pVelY = aVelY + First;
+		Batch.m_pGrounded = aGrounded + First;
+		pCollision->MoveBoxes(Batch, PhysicalSizeVec2(), Elasticity);
+
+		for(int i = First; i < End; i++)
+		{
+			CCharacterCore *pCore = ppCores[i];
+			pCore->m_MoveNewPos = vec2(aPosX[i], aPosY[i]);
+			pCore->m_Vel = vec2(aVelX[i], aVelY[i]);
+			pCore->EndMove(aGrounded[i]);
+		}
+		First = End;
+	}
+}
+
+vec2 CCharacterCore::MoveElasticity() const
+{
+	return vec2(m_Tuning.m_GroundElasticityX, m_Tuning.m_GroundElasticityY);
+}
+
+void CCharacterCore::StartMove()
+{
+	m_MoveRampValue = VelocityRamp(length(m_Vel) * 50, m_Tuning.m_VelrampStart, m_Tuning.m_VelrampRange, m_Tuning.m_VelrampCurvature);
+
+	m_Vel.x = m_Vel.x * m_MoveRampValue;
+
+	m_MoveNewPos = m_Pos;
+	m_MoveOldVelX = m_Vel.x;
+}
+
+void CCharacterCore::EndMove(bool Grounded)
+{
 	if(Grounded)
 	{
 		m_Jumped &= ~2;
@@ -550,16 +616,20 @@ void CCharacterCore::Move()
 	m_Colliding = 0;
 	if(m_Vel.x < 0.001f && m_Vel.x > -0.001f)
 	{
-		if(OldVel.x > 0)
+		if(m_MoveOldVelX > 0)
 			m_Colliding = 1;
-		else if(OldVel.x < 0)
+		else if(m_MoveOldVelX < 0)
 			m_Colliding = 2;
 	}
 	else
 		m_LeftWall = true;
 
-	m_Vel.x = m_Vel.x * (1.0f / RampValue);
+	m_Vel.x = m_Vel.x * (1.0f / m_MoveRampValue);
+}
 
+void CCharacterCore::FinishMove()
+{
+	const vec2 NewPos = m_MoveNewPos;
 	if(m_pWorld && (m_Super || (m_Tuning.m_PlayerCollision && !m_CollisionDisabled && !m_Solo)))
 	{
 		// check player collision
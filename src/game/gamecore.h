@@ -233,6 +233,18 @@ public:
 	void TickDeferred();
 	void Tick(bool UseInput, bool DoDeferredTick = true);
 	void Move();
+	/**
+	 * @link Move @endlink in two steps. The tile collision in `PrepareMove` only
+	 * depends on this character, so it can be done for all characters before any
+	 * of them calls `FinishMove`, which handles the collision with the others.
+	 */
+	void PrepareMove();
+	void FinishMove();
+	/**
+	 * Calls `PrepareMove` for several characters, doing their tile collision
+	 * at once with @link CCollision::MoveBoxes @endlink.
+	 */
+	static void PrepareMoves(CCharacterCore *const *ppCores, int Num);
 
 	void Read(const CNetObj_CharacterCore *pObjCore);
 	void Write(CNetObj_CharacterCore *pObjCore) const;
@@ -275,6 +287,12 @@ private:
 	CTeamsCore *m_pTeams;
 	int m_MoveRestrictions;
 	int m_HookedPlayer;
+	vec2 m_MoveNewPos;
+	float m_MoveOldVelX;
+	float m_MoveRampValue;
+	vec2 MoveElasticity() const;
+	void StartMove();
+	void EndMove(bool Grounded);
 	static bool IsSwitchActiveCb(int Number, void *pUser);
 };
 
@@ -78,6 +78,13 @@ void CDoor::Snap(int SnappingClient)
 		StartTick = Server()->Tick();
 	}
 
-	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
-		m_Pos, From, StartTick, -1, LASERTYPE_DOOR, 0, m_Number);
+	const auto SnapItems = [&]() {
+		GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
+			m_Pos, From, StartTick, -1, LASERTYPE_DOOR, 0, m_Number);
+	};
+	// old clients see the door state of the team they are watching
+	if(SnappingClientVersion >= VERSION_DDNET_ENTITY_NETOBJS)
+		SnapCached(SnappingClient, SnapItems);
+	else
+		SnapItems();
 }
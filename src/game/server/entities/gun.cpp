@@ -169,6 +169,8 @@ void CGun::Snap(int SnappingClient)
 		StartTick = m_EvalTick;
 	}
 
-	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
-		m_Pos, m_Pos, StartTick, -1, LASERTYPE_GUN, Subtype, m_Number);
+	SnapCached(SnappingClient, [&]() {
+		GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
+			m_Pos, m_Pos, StartTick, -1, LASERTYPE_GUN, Subtype, m_Number);
+	});
 }
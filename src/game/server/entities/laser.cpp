@@ -298,8 +298,10 @@ void CLaser::Snap(int SnappingClient)
 	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
 	int LaserType = m_Type == WEAPON_LASER ? LASERTYPE_RIFLE : (m_Type == WEAPON_SHOTGUN ? LASERTYPE_SHOTGUN : -1);
 
-	GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
-		m_Pos, m_From, m_EvalTick, m_Owner, LaserType, 0, m_Number);
+	SnapCached(SnappingClient, [&]() {
+		GameServer()->SnapLaserObject(CSnapContext(SnappingClientVersion, Server()->IsSixup(SnappingClient), SnappingClient), GetId(),
+			m_Pos, m_From, m_EvalTick, m_Owner, LaserType, 0, m_Number);
+	});
 }
 
 void CLaser::SwapClients(int Client1, int Client2)
@@ -306,36 +306,38 @@ void CProjectile::Snap(int SnappingClient)
 	if(SnappingClient != SERVER_DEMO_CLIENT && m_Owner != -1 && !TeamMask.test(SnappingClient))
 		return;
 
-	CNetObj_DDRaceProjectile DDRaceProjectile;
+	SnapCached(SnappingClient, [&]() {
+		CNetObj_DDRaceProjectile DDRaceProjectile;
 
-	if(SnappingClientVersion >= VERSION_DDNET_ENTITY_NETOBJS)
-	{
-		CNetObj_DDNetProjectile *pDDNetProjectile = static_cast<CNetObj_DDNetProjectile *>(Server()->SnapNewItem(NETOBJTYPE_DDNETPROJECTILE, GetId(), sizeof(CNetObj_DDNetProjectile)));
-		if(!pDDNetProjectile)
+		if(SnappingClientVersion >= VERSION_DDNET_ENTITY_NETOBJS)
 		{
-			return;
+			CNetObj_DDNetProjectile *pDDNetProjectile = static_cast<CNetObj_DDNetProjectile *>(Server()->SnapNewItem(NETOBJTYPE_DDNETPROJECTILE, GetId(), sizeof(CNetObj_DDNetProjectile)));
+			if(!pDDNetProjectile)
+			{
+				return;
+			}
+			FillExtraInfo(pDDNetProjectile);
 		}
-		FillExtraInfo(pDDNetProjectile);
-	}
-	else if(SnappingClientVersion >= VERSION_DDNET_ANTIPING_PROJECTILE && FillExtraInfoLegacy(&DDRaceProjectile))
-	{
-		int Type = SnappingClientVersion < VERSION_DDNET_MSG_LEGACY ? (int)NETOBJTYPE_PROJECTILE : NETOBJTYPE_DDRACEPROJECTILE;
-		void *pProj = Server()->SnapNewItem(Type, GetId(), sizeof(DDRaceProjectile));
-		if(!pProj)
+		else if(SnappingClientVersion >= VERSION_DDNET_ANTIPING_PROJECTILE && FillExtraInfoLegacy(&DDRaceProjectile))
 		{
-			return;
+			int Type = SnappingClientVersion < VERSION_DDNET_MSG_LEGACY ? (int)NETOBJTYPE_PROJECTILE : NETOBJTYPE_DDRACEPROJECTILE;
+			void *pProj = Server()->SnapNewItem(Type, GetId(), sizeof(DDRaceProjectile));
+			if(!pProj)
+			{
+				return;
+			}
+			mem_copy(pProj, &DDRaceProjectile, sizeof(DDRaceProjectile));
 		}
-		mem_copy(pProj, &DDRaceProjectile, sizeof(DDRaceProjectile));
-	}
-	else
-	{
-		CNetObj_Projectile *pProj = Server()->SnapNewItem<CNetObj_Projectile>(GetId());
-		if(!pProj)
+		else
 		{
-			return;
+			CNetObj_Projectile *pProj = Server()->SnapNewItem<CNetObj_Projectile>(GetId());
+			if(!pProj)
+			{
+				return;
+			}
+			FillInfo(pProj);
 		}
-		FillInfo(pProj);
-	}
+	});
 }
 
 void CProjectile::SwapClients(int Client1, int Client2)
@@ -31,6 +31,26 @@ CEntity::~CEntity()
 	Server()->SnapFreeId(m_Id);
 }
 
+int CEntity::SnapCacheVariant(int SnappingClient)
+{
+	return GameServer()->GetClientVersion(SnappingClient) * 2 + (Server()->IsSixup(SnappingClient) ? 1 : 0);
+}
+
+bool CEntity::SnapCacheAdd(int SnappingClient)
+{
+	return Server()->SnapCacheAdd(this, SnapCacheVariant(SnappingClient));
+}
+
+void CEntity::SnapCacheBegin()
+{
+	Server()->SnapCacheBegin();
+}
+
+void CEntity::SnapCacheEnd(int SnappingClient)
+{
+	Server()->SnapCacheEnd(this, SnapCacheVariant(SnappingClient));
+}
+
 bool CEntity::NetworkClipped(int SnappingClient) const
 {
 	return ::NetworkClipped(m_pGameWorld->GameServer(), SnappingClient, m_Pos);
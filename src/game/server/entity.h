@@ -39,6 +39,11 @@ private:
 	*/
 	float m_ProximityRadius;
 
+	int SnapCacheVariant(int SnappingClient);
+	bool SnapCacheAdd(int SnappingClient);
+	void SnapCacheBegin();
+	void SnapCacheEnd(int SnappingClient);
+
 protected:
 	/* State */
 	bool m_MarkedForDestroy;
@@ -170,6 +175,29 @@ public: // TODO: Maybe make protected
 	bool NetworkClipped(int SnappingClient, vec2 CheckPos) const;
 	bool NetworkClippedLine(int SnappingClient, vec2 StartPos, vec2 EndPos) const;
 
+	/*
+		Function: SnapCached
+			Adds the items created by SnapItems to the snapshot. They are
+			only created for the first client with the same version in a
+			tick, later clients get copies of them.
+			Only use it after the visibility checks, for items which
+			don't depend on the snapping client apart from its version.
+
+		Arguments:
+			SnappingClient - ID of the client which snapshot is
+				being generated.
+			SnapItems - Function creating the snap items.
+	*/
+	template<typename T>
+	void SnapCached(int SnappingClient, T &&SnapItems)
+	{
+		if(SnapCacheAdd(SnappingClient))
+			return;
+		SnapCacheBegin();
+		SnapItems();
+		SnapCacheEnd(SnappingClient);
+	}
+
 	bool GameLayerClipped(vec2 CheckPos);
 	virtual bool CanCollide(int ClientId) { return true; }
 
@@ -856,6 +856,29 @@ void CGameContext::SendSkinChange7(int ClientId)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, -1);
 }
 
+bool CGameContext::VoteCommandMap(const char *pCommand, char *pMap, int MapSize)
+{
+	const char *pArgs = str_startswith(pCommand, "change_map ");
+	if(!pArgs)
+		pArgs = str_startswith(pCommand, "sv_map ");
+	if(!pArgs || str_find(pArgs, ";") || str_find(pArgs, "\\"))
+		return false;
+
+	pArgs = str_skip_whitespaces_const(pArgs);
+	if(pArgs[0] == '"')
+	{
+		const char *pEnd = str_find(pArgs + 1, "\"");
+		if(!pEnd || pEnd[1] != '\0')
+			return false;
+		str_truncate(pMap, MapSize, pArgs + 1, pEnd - pArgs - 1);
+	}
+	else
+	{
+		str_copy(pMap, pArgs, MapSize);
+	}
+	return pMap[0] != '\0';
+}
+
 void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc)
 {
 	// reset votes
@@ -877,12 +900,21 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 	str_copy(m_aVoteReason, pReason, sizeof(m_aVoteReason));
 	SendVoteSet(-1);
 	m_VoteUpdate = true;
+
+	// load the map while the vote runs, so changing to it is quick if the vote passes
+	char aMap[IO_MAX_PATH_LENGTH];
+	if(VoteCommandMap(pCommand, aMap, sizeof(aMap)))
+		Server()->PrepareMap(aMap);
 }
 
-void CGameContext::EndVote()
+void CGameContext::EndVote(bool Passed)
 {
 	m_VoteCloseTime = 0;
 	SendVoteSet(-1);
+
+	// the map of a failed map vote is not needed anymore
+	if(!Passed)
+		Server()->CancelPrepareMap();
 }
 
 void CGameContext::SendVoteSet(int ClientId)
@@ -1144,7 +1176,7 @@ void CGameContext::OnTick()
 		if(m_VoteEnforce == VOTE_ENFORCE_ABORT)
 		{
 			SendChat(-1, TEAM_ALL, "Vote aborted");
-			EndVote();
+			EndVote(false);
 		}
 		else if(m_VoteEnforce == VOTE_ENFORCE_CANCEL)
 		{
@@ -1158,7 +1190,7 @@ void CGameContext::OnTick()
 				str_format(aBuf, sizeof(aBuf), "'%s' canceled their vote", Server()->ClientName(m_VoteCreator));
 			}
 			SendChat(-1, TEAM_ALL, aBuf);
-			EndVote();
+			EndVote(false);
 		}
 		else
 		{
@@ -1290,7 +1322,7 @@ void CGameContext::OnTick()
 				Server()->SetRconCid(IServer::RCON_CID_VOTE);
 				Console()->ExecuteLine(m_aVoteCommand, IConsole::CLIENT_ID_UNSPECIFIED);
 				Server()->SetRconCid(IServer::RCON_CID_SERV);
-				EndVote();
+				EndVote(true);
 				SendChat(-1, TEAM_ALL, "Vote passed", -1, FLAG_SIX);
 
 				if(m_VoteCreator != -1 && m_apPlayers[m_VoteCreator] && !IsKickVote() && !IsSpecVote())
@@ -1301,7 +1333,7 @@ void CGameContext::OnTick()
 				Server()->SetRconCid(IServer::RCON_CID_VOTE);
 				Console()->ExecuteLine(m_aVoteCommand, IConsole::CLIENT_ID_UNSPECIFIED);
 				Server()->SetRconCid(IServer::RCON_CID_SERV);
-				EndVote();
+				EndVote(true);
 				SendChat(-1, TEAM_ALL, "Vote passed enforced by authorized player", -1, FLAG_SIX);
 
 				if(m_VoteCreator != -1 && m_apPlayers[m_VoteCreator])
@@ -1309,12 +1341,12 @@ void CGameContext::OnTick()
 			}
 			else if(m_VoteEnforce == VOTE_ENFORCE_NO_ADMIN)
 			{
-				EndVote();
+				EndVote(false);
 				SendChat(-1, TEAM_ALL, "Vote failed enforced by authorized player", -1, FLAG_SIX);
 			}
 			else if(m_VoteEnforce == VOTE_ENFORCE_NO || (time_get() > m_VoteCloseTime && g_Config.m_SvVoteMajority))
 			{
-				EndVote();
+				EndVote(false);
 				if(VetoStop || (m_VoteWillPass && Veto))
 					SendChat(-1, TEAM_ALL, "Vote failed because of veto. Find an empty server instead", -1, FLAG_SIX);
 				else
@@ -231,8 +231,10 @@ public:
 	std::vector<SSwitchers> &Switchers() { return m_World.m_Core.m_vSwitchers; }
 
 	// voting
+	// Gets the map that a vote command changes to, if the command does nothing else
+	static bool VoteCommandMap(const char *pCommand, char *pMap, int MapSize);
 	void StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc);
-	void EndVote();
+	void EndVote(bool Passed);
 	void SendVoteSet(int ClientId);
 	void SendVoteStatus(int ClientId, int Total, int Yes, int No);
 	void AbortVoteKickOnDisconnect(int ClientId);
@@ -254,6 +254,9 @@ void CGameWorld::Tick()
 
 	RemoveEntities();
 
+	// TClient
+	GameServer()->Collision()->FlushSolidDistance();
+
 	// find the characters' strong/weak id
 	int StrongWeakId = 0;
 	for(CCharacter *pChar = (CCharacter *)FindFirst(ENTTYPE_CHARACTER); pChar; pChar = (CCharacter *)pChar->TypeNext())
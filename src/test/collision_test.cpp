@@ -0,0 +1,334 @@
+#include "test.h"
+
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+class CTestCollision : public ::testing::Test
+{
+public:
+	std::unique_ptr<IKernel> m_pKernel;
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	std::mt19937 m_Random{1337};
+
+	CTestCollision()
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		EXPECT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+		EXPECT_TRUE(m_pMap->Load("maps/coverage.map", IStorage::TYPE_ALL));
+
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+	}
+
+	~CTestCollision() override
+	{
+		m_Collision.Unload();
+		m_pMap->Unload();
+	}
+
+	// positions slightly outside of the map to cover the clamping
+	float RandomX() { return std::uniform_real_distribution<float>(-64.0f, m_Collision.GetWidth() * 32.0f + 64.0f)(m_Random); }
+	float RandomY() { return std::uniform_real_distribution<float>(-64.0f, m_Collision.GetHeight() * 32.0f + 64.0f)(m_Random); }
+	float RandomVel(float Max)
+	{
+		switch(m_Random() % 8)
+		{
+		case 0: return 0.0f;
+		case 1: return std::uniform_real_distribution<float>(-0.00001f, 0.00001f)(m_Random);
+		default: return std::uniform_real_distribution<float>(-Max, Max)(m_Random);
+		}
+	}
+};
+
+struct SLines
+{
+	std::vector<float> m_vPos0X, m_vPos0Y, m_vPos1X, m_vPos1Y;
+	std::vector<int> m_vResult;
+};
+
+struct SMoves
+{
+	std::vector<float> m_vPosX, m_vPosY, m_vVelX, m_vVelY;
+	std::shared_ptr<bool[]> m_pGrounded;
+
+	CCollision::SMoveBatch Batch()
+	{
+		m_pGrounded = std::shared_ptr<bool[]>(new bool[m_vPosX.size()]());
+
+		CCollision::SMoveBatch Batch;
+		Batch.m_Num = m_vPosX.size();
+		Batch.m_pPosX = m_vPosX.data();
+		Batch.m_pPosY = m_vPosY.data();
+		Batch.m_pVelX = m_vVelX.data();
+		Batch.m_pVelY = m_vVelY.data();
+		Batch.m_pGrounded = m_pGrounded.get();
+		return Batch;
+	}
+};
+
+static SLines RandomLines(CTestCollision *pTest, int Num, float MaxLength)
+{
+	SLines Lines;
+	for(int i = 0; i < Num; i++)
+	{
+		const float X = pTest->RandomX();
+		const float Y = pTest->RandomY();
+		Lines.m_vPos0X.push_back(X);
+		Lines.m_vPos0Y.push_back(Y);
+		Lines.m_vPos1X.push_back(X + pTest->RandomVel(MaxLength));
+		Lines.m_vPos1Y.push_back(Y + pTest->RandomVel(MaxLength));
+	}
+	Lines.m_vResult.resize(Num);
+	return Lines;
+}
+
+static SMoves RandomMoves(CTestCollision *pTest, int Num, float MaxVel)
+{
+	SMoves Moves;
+	for(int i = 0; i < Num; i++)
+	{
+		Moves.m_vPosX.push_back(pTest->RandomX());
+		Moves.m_vPosY.push_back(pTest->RandomY());
+		Moves.m_vVelX.push_back(pTest->RandomVel(MaxVel));
+		Moves.m_vVelY.push_back(pTest->RandomVel(MaxVel));
+	}
+	return Moves;
+}
+
+TEST_F(CTestCollision, MoveBoxes)
+{
+	for(vec2 Elasticity : {vec2(0.0f, 0.0f), vec2(0.5f, 0.5f), vec2(-0.3f, 2.0f)})
+	{
+		// odd count to also cover the boxes that don't fill a whole SIMD register
+		SMoves Moves = RandomMoves(this, 4099, 100.0f);
+		SMoves Expected = Moves;
+		m_Collision.MoveBoxes(Moves.Batch(), vec2(28.0f, 28.0f), Elasticity);
+
+		for(size_t i = 0; i < Expected.m_vPosX.size(); i++)
+		{
+			vec2 Pos(Expected.m_vPosX[i], Expected.m_vPosY[i]);
+			vec2 Vel(Expected.m_vVelX[i], Expected.m_vVelY[i]);
+			bool Grounded = false;
+			m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), Elasticity, &Grounded);
+			EXPECT_EQ(Moves.m_vPosX[i], Pos.x) << "box " << i;
+			EXPECT_EQ(Moves.m_vPosY[i], Pos.y) << "box " << i;
+			EXPECT_EQ(Moves.m_vVelX[i], Vel.x) << "box " << i;
+			EXPECT_EQ(Moves.m_vVelY[i], Vel.y) << "box " << i;
+			EXPECT_EQ(Moves.m_pGrounded[i], Grounded) << "box " << i;
+		}
+	}
+}
+
+// IntersectLine without skipping empty space and without the solid bitmap
+static int IntersectLineReference(const CCollision &Collision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		const int Tile = Collision.GetTile(round_to_int(Pos.x), round_to_int(Pos.y));
+		if(Tile == TILE_SOLID || Tile == TILE_NOHOOK)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Tile;
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static void ExpectSameIntersection(const CCollision &Collision, vec2 Pos0, vec2 Pos1)
+{
+	vec2 Collision0, BeforeCollision0, Collision1, BeforeCollision1;
+	const int Result0 = IntersectLineReference(Collision, Pos0, Pos1, &Collision0, &BeforeCollision0);
+	const int Result1 = Collision.IntersectLine(Pos0, Pos1, &Collision1, &BeforeCollision1);
+	EXPECT_EQ(Result0, Result1) << Pos0.x << "," << Pos0.y << " -> " << Pos1.x << "," << Pos1.y;
+	EXPECT_EQ(Collision0, Collision1) << Pos0.x << "," << Pos0.y << " -> " << Pos1.x << "," << Pos1.y;
+	EXPECT_EQ(BeforeCollision0, BeforeCollision1) << Pos0.x << "," << Pos0.y << " -> " << Pos1.x << "," << Pos1.y;
+}
+
+TEST_F(CTestCollision, SolidBitmap)
+{
+	for(int i = 0; i < 100000; i++)
+	{
+		const int x = RandomX();
+		const int y = RandomY();
+		const int Tile = m_Collision.GetTile(x, y);
+		EXPECT_EQ(m_Collision.IsSolid(x, y), Tile == TILE_SOLID || Tile == TILE_NOHOOK) << x << "," << y;
+	}
+}
+
+TEST_F(CTestCollision, IntersectLineSkipsEmptySpace)
+{
+	for(int i = 0; i < 20000; i++)
+	{
+		const vec2 Pos0(RandomX(), RandomY());
+		ExpectSameIntersection(m_Collision, Pos0, Pos0 + vec2(RandomVel(3000.0f), RandomVel(3000.0f)));
+	}
+	// straight lines along the borders of tiles and the trunc division around 0
+	for(int i = -64; i < 64; i++)
+	{
+		ExpectSameIntersection(m_Collision, vec2(i, -40.0f), vec2(i, 2000.0f));
+		ExpectSameIntersection(m_Collision, vec2(-40.0f, i), vec2(2000.0f, i));
+		ExpectSameIntersection(m_Collision, vec2(i * 32.0f + 0.5f, 0.0f), vec2(i * 32.0f + 0.5f, 4000.0f));
+	}
+}
+
+TEST_F(CTestCollision, SetCollisionAtUpdatesSolidMap)
+{
+	for(int i = 0; i < 200; i++)
+	{
+		const vec2 Pos0(RandomX(), RandomY());
+		const vec2 Pos1 = Pos0 + vec2(RandomVel(2000.0f), RandomVel(2000.0f));
+		const vec2 Middle = mix(Pos0, Pos1, 0.5f);
+		const int Old = m_Collision.GetTile(round_to_int(Middle.x), round_to_int(Middle.y));
+
+		m_Collision.SetCollisionAt(Middle.x, Middle.y, TILE_SOLID);
+		EXPECT_TRUE(m_Collision.CheckPoint(Middle));
+		ExpectSameIntersection(m_Collision, Pos0, Pos1);
+
+		m_Collision.SetCollisionAt(Middle.x, Middle.y, TILE_AIR);
+		EXPECT_FALSE(m_Collision.CheckPoint(Middle));
+		ExpectSameIntersection(m_Collision, Pos0, Pos1);
+
+		m_Collision.SetCollisionAt(Middle.x, Middle.y, Old);
+		ExpectSameIntersection(m_Collision, Pos0, Pos1);
+		if(i % 10 == 0)
+			m_Collision.FlushSolidDistance();
+	}
+}
+
+TEST_F(CTestCollision, SolidDistanceMatchesRebuild)
+{
+	// start from an empty map, so that the distances get large
+	for(int y = 0; y < m_Collision.GetHeight(); y++)
+	{
+		for(int x = 0; x < m_Collision.GetWidth(); x++)
+			m_Collision.SetCollisionAt(x * 32.0f, y * 32.0f, TILE_AIR);
+	}
+	m_Collision.FlushSolidDistance();
+
+	for(int Round = 0; Round < 50; Round++)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			const int Index = m_Random() % 3 == 0 ? TILE_AIR : TILE_SOLID;
+			m_Collision.SetCollisionAt(RandomX(), RandomY(), Index);
+		}
+
+		// the tiles were changed in the map data, so this builds the distances from scratch
+		CCollision Rebuilt;
+		Rebuilt.Init(&m_Layers);
+		for(int y = 0; y < m_Collision.GetHeight(); y++)
+		{
+			for(int x = 0; x < m_Collision.GetWidth(); x++)
+				ASSERT_LE(m_Collision.SolidDistance(x, y), Rebuilt.SolidDistance(x, y)) << x << "," << y;
+		}
+
+		m_Collision.FlushSolidDistance();
+		for(int y = 0; y < m_Collision.GetHeight(); y++)
+		{
+			for(int x = 0; x < m_Collision.GetWidth(); x++)
+				ASSERT_EQ(m_Collision.SolidDistance(x, y), Rebuilt.SolidDistance(x, y)) << x << "," << y;
+		}
+		Rebuilt.Unload();
+	}
+}
+
+// Microbenchmark comparing the batched and the single versions,
+// run with --gtest_also_run_disabled_tests
+TEST_F(CTestCollision, DISABLED_Benchmark)
+{
+	const int Num = 1 << 14;
+	const int Rounds = 20;
+	const SLines Lines = RandomLines(this, Num, 800.0f);
+	const SMoves Moves = RandomMoves(this, Num, 30.0f);
+
+	const auto Measure = [&](const char *pName, const auto &Func) {
+		const auto Start = std::chrono::steady_clock::now();
+		for(int Round = 0; Round < Rounds; Round++)
+			Func();
+		const std::chrono::nanoseconds Duration = std::chrono::steady_clock::now() - Start;
+		log_info("collision_test", "%-20s %8.2f ns/element", pName, Duration.count() / (double)(Num * Rounds));
+	};
+
+	SLines BatchLines = Lines;
+	Measure("IntersectLine", [&]() {
+		vec2 Collision, BeforeCollision;
+		for(int i = 0; i < Num; i++)
+			BatchLines.m_vResult[i] = m_Collision.IntersectLine(vec2(Lines.m_vPos0X[i], Lines.m_vPos0Y[i]), vec2(Lines.m_vPos1X[i], Lines.m_vPos1Y[i]), &Collision, &BeforeCollision);
+	});
+	Measure("IntersectLine (ref)", [&]() {
+		vec2 Collision, BeforeCollision;
+		for(int i = 0; i < Num; i++)
+			BatchLines.m_vResult[i] = IntersectLineReference(m_Collision, vec2(Lines.m_vPos0X[i], Lines.m_vPos0Y[i]), vec2(Lines.m_vPos1X[i], Lines.m_vPos1Y[i]), &Collision, &BeforeCollision);
+	});
+
+	// a tele weapon laser bounce makes a tile solid and resets it
+	Measure("SetCollisionAt", [&]() {
+		for(int i = 0; i < Num; i++)
+		{
+			const float X = Lines.m_vPos0X[i];
+			const float Y = Lines.m_vPos0Y[i];
+			const int Old = m_Collision.GetTile(round_to_int(X), round_to_int(Y));
+			m_Collision.SetCollisionAt(X, Y, TILE_SOLID);
+			m_Collision.SetCollisionAt(X, Y, Old);
+			// as if there were 8 bounces per tick
+			if(i % 8 == 0)
+				m_Collision.FlushSolidDistance();
+		}
+		m_Collision.FlushSolidDistance();
+	});
+
+	SMoves BatchMoves = Moves;
+	const CCollision::SMoveBatch MoveBatch = BatchMoves.Batch();
+	Measure("MoveBox", [&]() {
+		for(int i = 0; i < Num; i++)
+		{
+			vec2 Pos(Moves.m_vPosX[i], Moves.m_vPosY[i]);
+			vec2 Vel(Moves.m_vVelX[i], Moves.m_vVelY[i]);
+			m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), vec2(0.0f, 0.0f));
+			BatchMoves.m_vPosX[i] = Pos.x;
+		}
+	});
+	Measure("MoveBoxes", [&]() {
+		// restore the inputs, the batch moves in place
+		std::copy(Moves.m_vPosX.begin(), Moves.m_vPosX.end(), BatchMoves.m_vPosX.begin());
+		std::copy(Moves.m_vPosY.begin(), Moves.m_vPosY.end(), BatchMoves.m_vPosY.begin());
+		std::copy(Moves.m_vVelX.begin(), Moves.m_vVelX.end(), BatchMoves.m_vVelX.begin());
+		std::copy(Moves.m_vVelY.begin(), Moves.m_vVelY.end(), BatchMoves.m_vVelY.begin());
+		m_Collision.MoveBoxes(MoveBatch, vec2(28.0f, 28.0f), vec2(0.0f, 0.0f));
+	});
+}
@@ -1,5 +1,7 @@
 #include "test.h"
 
+#include <base/system.h>
+
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
@@ -8,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +115,225 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, ParallelCompression)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	// enough data to be compressed on multiple threads
+	std::vector<std::vector<int>> vvData;
+	for(int i = 0; i < 40; i++)
+	{
+		std::vector<int> &vData = vvData.emplace_back(i % 8 == 0 ? 1024 * 1024 : 1000 + i * 100);
+		for(size_t j = 0; j < vData.size(); j++)
+			vData[j] = (j * (i + 1)) % 1000;
+	}
+
+	const auto &Write = [&](const char *pFilename, int NumThreads) {
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), pFilename));
+		Writer.SetCompressionThreads(NumThreads);
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			const int Item[2] = {(int)i, Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data(), i % 3 == 0 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT)};
+			Writer.AddItem(1, i, sizeof(Item), Item);
+		}
+		Writer.Finish();
+	};
+
+	char aSequential[IO_MAX_PATH_LENGTH];
+	str_format(aSequential, sizeof(aSequential), "%s.sequential", Info.m_aFilename);
+	Write(aSequential, 0);
+	void *pSequential;
+	unsigned SequentialSize;
+	ASSERT_TRUE(pStorage->ReadFile(aSequential, IStorage::TYPE_SAVE, &pSequential, &SequentialSize));
+
+	// the output is the same, no matter how many threads compress the data
+	for(int NumThreads : {1, 4, -1})
+	{
+		Write(Info.m_aFilename, NumThreads);
+		void *pData;
+		unsigned Size;
+		ASSERT_TRUE(pStorage->ReadFile(Info.m_aFilename, IStorage::TYPE_SAVE, &pData, &Size));
+		EXPECT_EQ(Size, SequentialSize) << NumThreads;
+		EXPECT_TRUE(Size == SequentialSize && mem_comp(pData, pSequential, Size) == 0) << NumThreads;
+		free(pData);
+	}
+	free(pSequential);
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			const int *pItem = (const int *)Reader.FindItem(1, i);
+			ASSERT_NE(pItem, nullptr);
+			ASSERT_EQ(Reader.GetDataSize(pItem[1]), (int)(vvData[i].size() * sizeof(int)));
+			EXPECT_EQ(mem_comp(Reader.GetData(pItem[1]), vvData[i].data(), vvData[i].size() * sizeof(int)), 0) << i;
+		}
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aSequential, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, MappedReader)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	std::vector<std::vector<int>> vvData;
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		for(int i = 0; i < 20; i++)
+		{
+			std::vector<int> &vData = vvData.emplace_back(10000 + i * 1000);
+			for(size_t j = 0; j < vData.size(); j++)
+				vData[j] = j * (i + 1);
+			const int Item[2] = {i, Writer.AddData(vData.size() * sizeof(int), vData.data())};
+			Writer.AddItem(1, i, sizeof(Item), Item);
+		}
+		Writer.Finish();
+	}
+
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+
+	for(int Flags : {(int)CDataFileReader::OPEN_MAPPED, CDataFileReader::OPEN_MAPPED | CDataFileReader::OPEN_PREFETCH})
+	{
+		CDataFileReader Mapped;
+		ASSERT_TRUE(Mapped.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, Flags));
+		EXPECT_EQ(Mapped.Sha256(), Reader.Sha256());
+		EXPECT_EQ(Mapped.Crc(), Reader.Crc());
+		EXPECT_EQ(Mapped.Size(), Reader.Size());
+		ASSERT_EQ(Mapped.NumItems(), (int)vvData.size());
+		ASSERT_EQ(Mapped.NumData(), (int)vvData.size());
+
+		// in any order, while the prefetch thread may still be running
+		for(int n = 0; n < (int)vvData.size(); n++)
+		{
+			const int i = (n * 7) % vvData.size();
+			const int *pItem = (const int *)Mapped.FindItem(1, i);
+			ASSERT_NE(pItem, nullptr);
+			EXPECT_EQ(pItem[0], i);
+			ASSERT_EQ(Mapped.GetDataSize(pItem[1]), (int)(vvData[i].size() * sizeof(int)));
+			const void *pData = Mapped.GetData(pItem[1]);
+			ASSERT_NE(pData, nullptr);
+			EXPECT_EQ(mem_comp(pData, vvData[i].data(), vvData[i].size() * sizeof(int)), 0) << i;
+			EXPECT_EQ(Mapped.GetData(pItem[1]), pData);
+		}
+
+		// unloaded data is loaded again, replaced data is returned as is
+		Mapped.UnloadData(0);
+		EXPECT_EQ(mem_comp(Mapped.GetData(0), vvData[0].data(), vvData[0].size() * sizeof(int)), 0);
+		char *pReplaced = static_cast<char *>(malloc(4));
+		mem_copy(pReplaced, "abc", 4);
+		Mapped.ReplaceData(1, pReplaced, 4);
+		EXPECT_EQ(Mapped.GetDataSize(1), 4);
+		EXPECT_STREQ(Mapped.GetDataString(1), "abc");
+		EXPECT_EQ(Mapped.GetData(1000), nullptr);
+		EXPECT_EQ(Mapped.GetDataSize(-1), 0);
+		Mapped.Close();
+	}
+
+	// closing while prefetching stops the thread
+	{
+		CDataFileReader Mapped;
+		ASSERT_TRUE(Mapped.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, CDataFileReader::OPEN_MAPPED | CDataFileReader::OPEN_PREFETCH));
+	}
+
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, MappedReaderVersion3)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	// the writer only writes version 4, version 3 files store the data uncompressed and without sizes
+	std::vector<std::vector<int>> vvData = {std::vector<int>(1000), std::vector<int>(500)};
+	for(size_t i = 0; i < vvData.size(); i++)
+	{
+		for(size_t j = 0; j < vvData[i].size(); j++)
+			vvData[i][j] = j * (i + 3);
+	}
+	{
+		std::vector<int> vFile;
+		const int NumItems = vvData.size();
+		const int ItemSize = NumItems * 4 * sizeof(int);
+		const int DataSize = (vvData[0].size() + vvData[1].size()) * sizeof(int);
+		const int HeaderSize = 9 + 3 + NumItems + vvData.size();
+		const int FileSize = (HeaderSize * sizeof(int)) + ItemSize + DataSize;
+		vFile.insert(vFile.end(), {0, 3, FileSize - 16, FileSize - DataSize - 16, 1, NumItems, (int)vvData.size(), ItemSize, DataSize});
+		mem_copy(vFile.data(), "DATA", 4);
+		vFile.insert(vFile.end(), {1, 0, NumItems}); // item type
+		vFile.insert(vFile.end(), {0, 4 * sizeof(int)}); // item offsets
+		vFile.insert(vFile.end(), {0, (int)(vvData[0].size() * sizeof(int))}); // data offsets
+		for(int i = 0; i < NumItems; i++)
+			vFile.insert(vFile.end(), {(1 << 16) | i, 2 * sizeof(int), i, i}); // items referencing their data
+		for(const auto &vData : vvData)
+			vFile.insert(vFile.end(), vData.begin(), vData.end());
+		ASSERT_EQ(vFile.size() * sizeof(int), (size_t)FileSize);
+
+		IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		io_write(File, vFile.data(), FileSize);
+		io_close(File);
+	}
+
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+	CDataFileReader Mapped;
+	ASSERT_TRUE(Mapped.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, CDataFileReader::OPEN_MAPPED));
+	EXPECT_EQ(Mapped.Sha256(), Reader.Sha256());
+	ASSERT_EQ(Mapped.NumItems(), 2);
+	ASSERT_EQ(Mapped.NumData(), 2);
+	for(int i = 0; i < 2; i++)
+	{
+		const int *pItem = (const int *)Mapped.FindItem(1, i);
+		ASSERT_NE(pItem, nullptr);
+		ASSERT_EQ(pItem[1], i);
+		ASSERT_EQ(Mapped.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+		ASSERT_EQ(Reader.GetDataSize(i), Mapped.GetDataSize(i));
+		EXPECT_EQ(mem_comp(Mapped.GetData(i), vvData[i].data(), Mapped.GetDataSize(i)), 0) << i;
+		EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)), 0) << i;
+	}
+
+	// the data is used in place, so the blocks follow each other like in the file
+	const char *pFirst = static_cast<const char *>(Mapped.GetData(0));
+	EXPECT_EQ(static_cast<const char *>(Mapped.GetData(1)), pFirst + Mapped.GetDataSize(0));
+	// unloading data in place does not free it
+	Mapped.UnloadData(0);
+	EXPECT_EQ(static_cast<const char *>(Mapped.GetData(0)), pFirst);
+	// replacing it does not either, the replacement is owned by the reader
+	char *pReplaced = static_cast<char *>(malloc(4));
+	mem_copy(pReplaced, "abc", 4);
+	Mapped.ReplaceData(1, pReplaced, 4);
+	EXPECT_STREQ(Mapped.GetDataString(1), "abc");
+
+	Mapped.Close();
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
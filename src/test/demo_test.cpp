@@ -0,0 +1,275 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/filecollection.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+static const int NUM_TICKS = 30 * SERVER_TICK_SPEED;
+
+class CDemoListener : public CDemoPlayer::IListener
+{
+public:
+	int m_LastTick = -1;
+	int m_NumSnapshots = 0;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		const CSnapshot *pSnap = (CSnapshot *)pData;
+		const int Index = pSnap->GetItemIndex(1 << 16);
+		ASSERT_GE(Index, 0);
+		m_LastTick = pSnap->GetItem(Index)->Data()[0];
+		m_NumSnapshots++;
+	}
+	void OnDemoPlayerMessage(void *pData, int Size) override {}
+};
+
+static void RecordDemo(IStorage *pStorage, IConsole *pConsole, CSnapshotDelta *pDelta, const char *pFilename, int NumItems, bool Markers = false)
+{
+	CNetBase::Init();
+	CDemoRecorder Recorder(pDelta, true);
+	unsigned char aMapData[1] = {0};
+	const SHA256_DIGEST Sha256 = {};
+	ASSERT_EQ(Recorder.Start(pStorage, pConsole, pFilename, "0.6 626fce9a778df4d4", "test", Sha256, 0, "client", 0, aMapData, nullptr, nullptr, nullptr), 0);
+
+	CSnapshotBuilder Builder;
+	char aData[CSnapshot::MAX_SIZE];
+	for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		Builder.Init();
+		int *pItem = (int *)Builder.NewItem(1, 0, 2 * sizeof(int));
+		pItem[0] = Tick;
+		pItem[1] = Tick / 10;
+		for(int i = 0; i < NumItems; i++)
+		{
+			// items that rarely change, so the deltas stay small
+			int *pOther = (int *)Builder.NewItem(2, i, sizeof(int));
+			pOther[0] = i + Tick / 100;
+		}
+		const int Size = Builder.Finish(aData);
+		Recorder.RecordSnapshot(Tick, aData, Size);
+		if(Markers && Tick % 500 == 100)
+			Recorder.AddDemoMarker(Tick);
+	}
+	Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE);
+}
+
+TEST(Demo, SeekSnapshotCache)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+
+	auto pConsole = CreateConsole(CFGFLAG_CLIENT);
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating test storage";
+
+	CSnapshotDelta Delta;
+	RecordDemo(pStorage.get(), pConsole.get(), &Delta, "seek.demo", 32);
+
+	g_Config.m_ClDemoSnapshotCache = 64;
+	CDemoListener Listener;
+	CDemoPlayer Player(&Delta, false);
+	Player.SetListener(&Listener);
+	ASSERT_EQ(Player.Load(pStorage.get(), pConsole.get(), "seek.demo", IStorage::TYPE_SAVE), 0);
+	Player.Play();
+	EXPECT_EQ(Player.SnapshotCacheMemoryUsage(), 0u);
+
+	auto Seek = [&](int Tick) {
+		Listener.m_NumSnapshots = 0;
+		ASSERT_TRUE(Player.SetPos(Tick));
+		EXPECT_EQ(Listener.m_LastTick, Player.BaseInfo()->m_CurrentTick);
+		EXPECT_GE(Player.BaseInfo()->m_CurrentTick, Tick - 1);
+	};
+
+	// without cached states, seeking replays from the previous keyframe
+	Seek(NUM_TICKS - 10);
+	Seek(SERVER_TICK_SPEED * 5 - 10);
+	Seek(SERVER_TICK_SPEED * 20 + 40);
+
+	// play the whole demo once to fill the cache
+	Seek(10);
+	while(Player.BaseInfo()->m_CurrentTick < NUM_TICKS - 10)
+		Seek(Player.Info()->m_NextTick + 1);
+	const size_t MemoryUsage = Player.SnapshotCacheMemoryUsage();
+	EXPECT_GT(MemoryUsage, 0u);
+	EXPECT_LE(MemoryUsage, 64u * 1024 * 1024);
+
+	// seeks backwards and forwards now decode only a few ticks
+	for(int Tick : {SERVER_TICK_SPEED * 5 - 10, SERVER_TICK_SPEED * 20 + 40, 100, NUM_TICKS - 20, 777, 778, 500})
+	{
+		Seek(Tick);
+		EXPECT_LE(Listener.m_NumSnapshots, 20) << Tick;
+	}
+	EXPECT_EQ(Player.SnapshotCacheMemoryUsage(), MemoryUsage);
+
+	Player.Stop();
+	EXPECT_EQ(Player.SnapshotCacheMemoryUsage(), 0u);
+}
+
+TEST(Demo, SnapshotCacheLimit)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+
+	auto pConsole = CreateConsole(CFGFLAG_CLIENT);
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating test storage";
+
+	CSnapshotDelta Delta;
+	RecordDemo(pStorage.get(), pConsole.get(), &Delta, "limit.demo", 800);
+
+	g_Config.m_ClDemoSnapshotCache = 0;
+	CDemoListener Listener;
+	CDemoPlayer Player(&Delta, false);
+	Player.SetListener(&Listener);
+	ASSERT_EQ(Player.Load(pStorage.get(), pConsole.get(), "limit.demo", IStorage::TYPE_SAVE), 0);
+	Player.Play();
+	while(Player.IsPlaying() && !Player.BaseInfo()->m_Paused)
+		Player.Update(false);
+	EXPECT_EQ(Player.SnapshotCacheMemoryUsage(), 0u);
+
+	// the least recently used states are dropped to stay within the limit
+	g_Config.m_ClDemoSnapshotCache = 1;
+	for(int Tick = 10; Tick < NUM_TICKS - 10; Tick += 20)
+	{
+		ASSERT_TRUE(Player.SetPos(Tick));
+		EXPECT_EQ(Listener.m_LastTick, Player.BaseInfo()->m_CurrentTick);
+		EXPECT_LE(Player.SnapshotCacheMemoryUsage(), 1024u * 1024);
+	}
+	Player.Stop();
+}
+
+static bool LoadIndex(IStorage *pStorage, const char *pFilename, CDemoIndex *pIndex)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+	const int64_t Size = io_length(File);
+	io_close(File);
+	time_t Created, Modified;
+	return pStorage->RetrieveTimes(pFilename, IStorage::TYPE_SAVE, &Created, &Modified) &&
+	       pIndex->Load(pStorage, pFilename, IStorage::TYPE_SAVE, Size, Modified);
+}
+
+TEST(Demo, Index)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+
+	auto pConsole = CreateConsole(CFGFLAG_CLIENT);
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating test storage";
+
+	CSnapshotDelta Delta;
+	RecordDemo(pStorage.get(), pConsole.get(), &Delta, "index.demo", 32, true);
+	EXPECT_TRUE(pStorage->FileExists("index.demo.idx", IStorage::TYPE_SAVE));
+
+	// the index written by the recorder has the infos of the demo header
+	CDemoIndex Index;
+	ASSERT_TRUE(LoadIndex(pStorage.get(), "index.demo", &Index));
+	CDemoPlayer Player(&Delta, false);
+	CDemoHeader Header;
+	CTimelineMarkers TimelineMarkers;
+	CMapInfo MapInfo;
+	ASSERT_TRUE(Player.GetDemoInfo(pStorage.get(), nullptr, "index.demo", IStorage::TYPE_SAVE, &Header, &TimelineMarkers, &MapInfo));
+	EXPECT_EQ(mem_comp(&Index.m_Header, &Header, sizeof(Header)), 0);
+	EXPECT_EQ(mem_comp(&Index.m_TimelineMarkers, &TimelineMarkers, sizeof(TimelineMarkers)), 0);
+	EXPECT_EQ(bytes_be_to_uint(Index.m_TimelineMarkers.m_aNumTimelineMarkers), 3u);
+	EXPECT_EQ(Index.m_MapSha256, MapInfo.m_Sha256);
+	EXPECT_EQ(Index.m_FirstTick, 0);
+	EXPECT_EQ(Index.m_LastTick, NUM_TICKS - 1);
+	ASSERT_GT(Index.m_vKeyFrames.size(), 1u);
+	EXPECT_EQ(Index.m_vKeyFrames[0].m_Tick, 0);
+
+	// the player writes the same index when it has to scan the demo
+	ASSERT_TRUE(pStorage->RemoveFile("index.demo.idx", IStorage::TYPE_SAVE));
+	ASSERT_EQ(Player.Load(pStorage.get(), pConsole.get(), "index.demo", IStorage::TYPE_SAVE), 0);
+	EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 0);
+	EXPECT_EQ(Player.BaseInfo()->m_LastTick, NUM_TICKS - 1);
+	Player.Stop();
+	CDemoIndex ScannedIndex;
+	ASSERT_TRUE(LoadIndex(pStorage.get(), "index.demo", &ScannedIndex));
+	EXPECT_EQ(mem_comp(&ScannedIndex.m_Header, &Index.m_Header, sizeof(Header)), 0);
+	EXPECT_EQ(ScannedIndex.m_FirstTick, Index.m_FirstTick);
+	EXPECT_EQ(ScannedIndex.m_LastTick, Index.m_LastTick);
+	ASSERT_EQ(ScannedIndex.m_vKeyFrames.size(), Index.m_vKeyFrames.size());
+	for(size_t i = 0; i < Index.m_vKeyFrames.size(); i++)
+	{
+		EXPECT_EQ(ScannedIndex.m_vKeyFrames[i].m_Filepos, Index.m_vKeyFrames[i].m_Filepos);
+		EXPECT_EQ(ScannedIndex.m_vKeyFrames[i].m_Tick, Index.m_vKeyFrames[i].m_Tick);
+	}
+
+	// playing from the index seeks like playing from a scan
+	CDemoListener Listener;
+	Player.SetListener(&Listener);
+	ASSERT_EQ(Player.Load(pStorage.get(), pConsole.get(), "index.demo", IStorage::TYPE_SAVE), 0);
+	Player.Play();
+	for(int Tick : {1000, 10, 600})
+	{
+		ASSERT_TRUE(Player.SetPos(Tick));
+		EXPECT_EQ(Listener.m_LastTick, Player.BaseInfo()->m_CurrentTick);
+	}
+	Player.Stop();
+
+	// the index does not match anymore once the demo changes
+	IOHANDLE File = pStorage->OpenFile("index.demo", IOFLAG_APPEND, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, "\0", 1);
+	io_close(File);
+	EXPECT_FALSE(LoadIndex(pStorage.get(), "index.demo", &Index));
+
+	CDemoIndex::Rename(pStorage.get(), "index.demo", "renamed.demo", IStorage::TYPE_SAVE);
+	EXPECT_TRUE(pStorage->FileExists("renamed.demo.idx", IStorage::TYPE_SAVE));
+	CDemoIndex::Remove(pStorage.get(), "renamed.demo", IStorage::TYPE_SAVE);
+	EXPECT_FALSE(pStorage->FileExists("renamed.demo.idx", IStorage::TYPE_SAVE));
+}
+
+TEST(Demo, AutoDemoCleanupRemovesIndex)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating test storage";
+	ASSERT_TRUE(pStorage->CreateFolder("auto", IStorage::TYPE_SAVE));
+
+	const char *apDemos[] = {
+		"auto/map_2024-01-01_10-00-00.demo",
+		"auto/map_2024-01-02_10-00-00.demo",
+		"auto/map_2024-01-03_10-00-00.demo",
+	};
+	for(const char *pDemo : apDemos)
+	{
+		char aIndex[IO_MAX_PATH_LENGTH];
+		CDemoIndex::Filename(pDemo, aIndex, sizeof(aIndex));
+		for(const char *pFilename : {pDemo, (const char *)aIndex})
+		{
+			IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+			ASSERT_TRUE(File);
+			io_close(File);
+		}
+	}
+	// an index without its demo is left alone
+	IOHANDLE File = pStorage->OpenFile("auto/other_2024-01-01_09-00-00.demo.idx", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_close(File);
+
+	CFileCollection AutoDemos;
+	AutoDemos.Init(pStorage.get(), "auto", "", ".demo", 1, CDemoIndex::Remove);
+
+	EXPECT_FALSE(pStorage->FileExists("auto/map_2024-01-01_10-00-00.demo", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(pStorage->FileExists("auto/map_2024-01-01_10-00-00.demo.idx", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(pStorage->FileExists("auto/map_2024-01-02_10-00-00.demo", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(pStorage->FileExists("auto/map_2024-01-02_10-00-00.demo.idx", IStorage::TYPE_SAVE));
+	EXPECT_TRUE(pStorage->FileExists("auto/map_2024-01-03_10-00-00.demo", IStorage::TYPE_SAVE));
+	EXPECT_TRUE(pStorage->FileExists("auto/map_2024-01-03_10-00-00.demo.idx", IStorage::TYPE_SAVE));
+	EXPECT_TRUE(pStorage->FileExists("auto/other_2024-01-01_09-00-00.demo.idx", IStorage::TYPE_SAVE));
+}
@@ -0,0 +1,113 @@
+#include <game/client/prediction/entity_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+enum
+{
+	TYPE_SMALL = 0,
+	TYPE_BIG,
+	NUM_TYPES,
+};
+
+class CTestEntity
+{
+public:
+	CTestEntity(int Type, int Value) :
+		m_Type(Type), m_Value(Value) { s_NumAlive++; }
+	CTestEntity(const CTestEntity &Other) :
+		m_Type(Other.m_Type), m_Value(Other.m_Value) { s_NumAlive++; }
+	virtual ~CTestEntity() { s_NumAlive--; }
+
+	int m_Type;
+	int m_Value;
+
+	static int s_NumAlive;
+};
+
+int CTestEntity::s_NumAlive = 0;
+
+class CTestSmall : public CTestEntity
+{
+public:
+	CTestSmall(int Value) :
+		CTestEntity(TYPE_SMALL, Value) {}
+};
+
+class CTestBig : public CTestEntity
+{
+public:
+	CTestBig(int Value) :
+		CTestEntity(TYPE_BIG, Value), m_vHistory(16, Value) {}
+
+	std::vector<int> m_vHistory;
+};
+
+// the same recycle-then-copy cycle as CGameWorld::CopyWorld
+void CopyWorld(CEntityPool<NUM_TYPES> &Pool, std::vector<CTestEntity *> &vpWorld, const std::vector<std::unique_ptr<CTestEntity>> &vpFrom)
+{
+	for(CTestEntity *pEnt : vpWorld)
+		Pool.Recycle(pEnt->m_Type, pEnt);
+	vpWorld.clear();
+	for(const auto &pEnt : vpFrom)
+	{
+		if(pEnt->m_Type == TYPE_SMALL)
+			vpWorld.push_back(Pool.Copy(TYPE_SMALL, *static_cast<CTestSmall *>(pEnt.get())));
+		else
+			vpWorld.push_back(Pool.Copy(TYPE_BIG, *static_cast<CTestBig *>(pEnt.get())));
+	}
+}
+
+}
+
+TEST(EntityPool, RepeatedCopiesStopAllocating)
+{
+	std::vector<std::unique_ptr<CTestEntity>> vpFrom;
+	for(int i = 0; i < 10; i++)
+	{
+		vpFrom.push_back(std::make_unique<CTestSmall>(i));
+		vpFrom.push_back(std::make_unique<CTestBig>(i));
+	}
+
+	{
+		CEntityPool<NUM_TYPES> Pool;
+		std::vector<CTestEntity *> vpWorld;
+
+		CopyWorld(Pool, vpWorld, vpFrom);
+		EXPECT_EQ(Pool.NumAllocations(), 20);
+		for(int i = 0; i < 100; i++)
+			CopyWorld(Pool, vpWorld, vpFrom);
+		EXPECT_EQ(Pool.NumAllocations(), 20);
+		EXPECT_EQ(CTestEntity::s_NumAlive, 40);
+
+		ASSERT_EQ(vpWorld.size(), vpFrom.size());
+		for(size_t i = 0; i < vpWorld.size(); i++)
+		{
+			EXPECT_EQ(vpWorld[i]->m_Type, vpFrom[i]->m_Type);
+			EXPECT_EQ(vpWorld[i]->m_Value, vpFrom[i]->m_Value);
+			if(vpWorld[i]->m_Type == TYPE_BIG)
+			{
+				EXPECT_EQ(static_cast<CTestBig *>(vpWorld[i])->m_vHistory, static_cast<CTestBig *>(vpFrom[i].get())->m_vHistory);
+			}
+		}
+
+		// only entities beyond the previous high water mark allocate
+		vpFrom.push_back(std::make_unique<CTestBig>(10));
+		CopyWorld(Pool, vpWorld, vpFrom);
+		EXPECT_EQ(Pool.NumAllocations(), 21);
+		vpFrom.pop_back();
+		CopyWorld(Pool, vpWorld, vpFrom);
+		EXPECT_EQ(Pool.NumFree(TYPE_SMALL), 0);
+		EXPECT_EQ(Pool.NumFree(TYPE_BIG), 1);
+		EXPECT_EQ(Pool.NumAllocations(), 21);
+
+		// entities created by the pool can still be deleted normally
+		for(CTestEntity *pEnt : vpWorld)
+			delete pEnt;
+	}
+	EXPECT_EQ(CTestEntity::s_NumAlive, 20);
+}
@@ -345,3 +345,45 @@ TEST(Filesystem, RenameOpenFileDeleteTarget)
 
 	EXPECT_FALSE(fs_remove(aNewFilename));
 }
+
+TEST(Filesystem, ListdirFileinfo)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	str_format(aFilename, sizeof(aFilename), "%s/test.txt", Info.m_aFilename);
+	char aSubdirectory[IO_MAX_PATH_LENGTH];
+	str_format(aSubdirectory, sizeof(aSubdirectory), "%s/subdirectory", Info.m_aFilename);
+
+	EXPECT_FALSE(fs_makedir(Info.m_aFilename));
+	EXPECT_FALSE(fs_makedir(aSubdirectory));
+	IOHANDLE File = io_open(aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, "0123456789", 10), 10u);
+	EXPECT_FALSE(io_close(File));
+
+	int aNumFound[2] = {0, 0};
+	fs_listdir_fileinfo(
+		Info.m_aFilename, [](const CFsFileInfo *pInfo, int IsDir, int Type, void *pUser) {
+			int *pNumFound = (int *)pUser;
+			if(str_comp(pInfo->m_pName, "test.txt") == 0)
+			{
+				EXPECT_FALSE(IsDir);
+				EXPECT_EQ(pInfo->m_Size, 10);
+				EXPECT_GT(pInfo->m_TimeModified, 0);
+				pNumFound[0]++;
+			}
+			else if(str_comp(pInfo->m_pName, "subdirectory") == 0)
+			{
+				EXPECT_TRUE(IsDir);
+				pNumFound[1]++;
+			}
+			return 0;
+		},
+		0, aNumFound);
+	EXPECT_EQ(aNumFound[0], 1);
+	EXPECT_EQ(aNumFound[1], 1);
+
+	EXPECT_FALSE(fs_remove(aFilename));
+	EXPECT_FALSE(fs_removedir(aSubdirectory));
+	EXPECT_FALSE(fs_removedir(Info.m_aFilename));
+}
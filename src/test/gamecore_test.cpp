@@ -0,0 +1,190 @@
+#include "test.h"
+
+#include <base/math.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/worker_group.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/teamscore.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+static const int NUM_CHARACTERS = 48;
+
+struct SCoreWorld
+{
+	CWorldCore m_World;
+	CTeamsCore m_Teams;
+	CCharacterCore m_aCores[NUM_CHARACTERS];
+};
+
+class CTestCharacterMove : public ::testing::Test
+{
+public:
+	std::unique_ptr<IKernel> m_pKernel;
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	std::mt19937 m_Random{1337};
+
+	CTestCharacterMove()
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		EXPECT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+		EXPECT_TRUE(m_pMap->Load("maps/coverage.map", IStorage::TYPE_ALL));
+
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+	}
+
+	~CTestCharacterMove() override
+	{
+		m_Collision.Unload();
+		m_pMap->Unload();
+	}
+
+	// characters close to each other, so that they hook and collide
+	std::vector<vec2> SpawnPositions()
+	{
+		std::uniform_real_distribution<float> RandomX(64.0f, m_Collision.GetWidth() * 32.0f - 64.0f);
+		std::uniform_real_distribution<float> RandomY(64.0f, m_Collision.GetHeight() * 32.0f - 64.0f);
+		std::uniform_real_distribution<float> RandomOffset(-160.0f, 160.0f);
+		vec2 Center;
+		do
+		{
+			Center = vec2(RandomX(m_Random), RandomY(m_Random));
+		} while(m_Collision.TestBox(Center, CCharacterCore::PhysicalSizeVec2()));
+
+		std::vector<vec2> vPositions;
+		while((int)vPositions.size() < NUM_CHARACTERS)
+		{
+			vec2 Pos = Center + vec2(RandomOffset(m_Random), RandomOffset(m_Random));
+			if(!m_Collision.TestBox(Pos, CCharacterCore::PhysicalSizeVec2()))
+				vPositions.push_back(Pos);
+		}
+		return vPositions;
+	}
+
+	void InitWorld(SCoreWorld &World, const std::vector<vec2> &vPositions)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CCharacterCore &Core = World.m_aCores[i];
+			Core.Init(&World.m_World, &m_Collision, &World.m_Teams);
+			Core.Reset();
+			Core.m_Id = i;
+			Core.m_Pos = vPositions[i];
+			World.m_World.m_apCharacters[i] = &Core;
+		}
+	}
+};
+
+static void PrepareMove(void *pUser, int Index)
+{
+	static_cast<SCoreWorld *>(pUser)->m_aCores[Index].PrepareMove();
+}
+
+static const int MOVE_BATCH_SIZE = 5;
+
+static void PrepareMoveBatch(void *pUser, int Index)
+{
+	SCoreWorld *pWorld = static_cast<SCoreWorld *>(pUser);
+	CCharacterCore *apCores[MOVE_BATCH_SIZE];
+	const int First = Index * MOVE_BATCH_SIZE;
+	const int Num = minimum(MOVE_BATCH_SIZE, NUM_CHARACTERS - First);
+	for(int i = 0; i < Num; i++)
+		apCores[i] = &pWorld->m_aCores[First + i];
+	CCharacterCore::PrepareMoves(apCores, Num);
+}
+
+static void ExpectPreparedMoveMatchesSerial(CTestCharacterMove *pTest, bool Batched)
+{
+	std::mt19937 &Random = pTest->m_Random;
+	const std::vector<vec2> vPositions = pTest->SpawnPositions();
+	auto pSerial = std::make_unique<SCoreWorld>();
+	auto pParallel = std::make_unique<SCoreWorld>();
+	pTest->InitWorld(*pSerial, vPositions);
+	pTest->InitWorld(*pParallel, vPositions);
+
+	CWorkerGroup Workers;
+	Workers.Init(3);
+
+	std::uniform_int_distribution<int> RandomDirection(-1, 1);
+	std::uniform_int_distribution<int> RandomTarget(-300, 300);
+	for(int Tick = 0; Tick < 500; Tick++)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_PlayerInput Input = {};
+			Input.m_Direction = RandomDirection(Random);
+			Input.m_TargetX = RandomTarget(Random);
+			Input.m_TargetY = RandomTarget(Random);
+			if(Input.m_TargetX == 0 && Input.m_TargetY == 0)
+				Input.m_TargetY = -1;
+			Input.m_Jump = Random() % 4 == 0;
+			Input.m_Hook = Random() % 3 != 0;
+			pSerial->m_aCores[i].m_Input = Input;
+			pParallel->m_aCores[i].m_Input = Input;
+		}
+
+		for(auto &Core : pSerial->m_aCores)
+			Core.Tick(true);
+		for(auto &Core : pSerial->m_aCores)
+		{
+			Core.Move();
+			Core.Quantize();
+		}
+
+		for(auto &Core : pParallel->m_aCores)
+			Core.Tick(true);
+		if(Batched)
+			Workers.Run((NUM_CHARACTERS + MOVE_BATCH_SIZE - 1) / MOVE_BATCH_SIZE, PrepareMoveBatch, pParallel.get());
+		else
+			Workers.Run(NUM_CHARACTERS, PrepareMove, pParallel.get());
+		for(auto &Core : pParallel->m_aCores)
+		{
+			Core.FinishMove();
+			Core.Quantize();
+		}
+
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			const CCharacterCore &Serial = pSerial->m_aCores[i];
+			const CCharacterCore &Parallel = pParallel->m_aCores[i];
+			ASSERT_EQ(Serial.m_Pos, Parallel.m_Pos) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.m_Vel, Parallel.m_Vel) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.m_HookPos, Parallel.m_HookPos) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.m_HookState, Parallel.m_HookState) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.HookedPlayer(), Parallel.HookedPlayer()) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.m_Jumped, Parallel.m_Jumped) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Serial.m_Colliding, Parallel.m_Colliding) << "tick " << Tick << " character " << i;
+		}
+	}
+}
+
+TEST_F(CTestCharacterMove, PrepareMoveMatchesMove)
+{
+	ExpectPreparedMoveMatchesSerial(this, false);
+}
+
+TEST_F(CTestCharacterMove, PrepareMovesMatchesMove)
+{
+	ExpectPreparedMoveMatchesSerial(this, true);
+}
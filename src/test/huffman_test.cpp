@@ -1,9 +1,19 @@
+#include <base/logger.h>
 #include <base/system.h>
 
 #include <engine/shared/huffman.h>
+#include <engine/shared/snapshot.h>
+
+#include <generated/protocol.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
 TEST(Huffman, CompressionShouldNotChangeData)
 {
 	CHuffman Huffman;
@@ -47,3 +57,132 @@ TEST(Huffman, CompressionCompatible)
 	EXPECT_EQ(match, 0) << "The compression is not compatible with older/other implementations anymore";
 	EXPECT_EQ(Size, 15);
 }
+
+// Packet payloads like the ones the network sends: snapshot deltas of moving
+// players, chat messages and random bytes
+static std::vector<std::vector<unsigned char>> PacketCorpus()
+{
+	std::vector<std::vector<unsigned char>> vvPackets;
+	std::mt19937 Random(1337);
+
+	char aFromData[CSnapshot::MAX_SIZE];
+	char aToData[CSnapshot::MAX_SIZE];
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	CSnapshotDelta Delta;
+	for(int Tick = 0; Tick < 50; Tick++)
+	{
+		CSnapshotBuilder Builder;
+		Builder.Init();
+		const int NumPlayers = 1 + Tick % 64;
+		for(int i = 0; i < NumPlayers; i++)
+		{
+			CNetObj_Character *pCharacter = static_cast<CNetObj_Character *>(Builder.NewItem(NETOBJTYPE_CHARACTER, i, sizeof(CNetObj_Character)));
+			pCharacter->m_Tick = Tick;
+			pCharacter->m_X = i * 100 + Tick * (i % 3);
+			pCharacter->m_Y = 500 + Tick % 7;
+			pCharacter->m_VelX = Random() % 256 - 128;
+			pCharacter->m_Direction = i % 3 - 1;
+			pCharacter->m_Weapon = i % 5;
+		}
+		Builder.Finish(aToData);
+		if(Tick > 0)
+		{
+			const int Size = Delta.CreateDelta((CSnapshot *)aFromData, (CSnapshot *)aToData, aDeltaData);
+			if(Size > 0)
+				vvPackets.emplace_back(aDeltaData, aDeltaData + std::min(Size, 1400));
+		}
+		mem_copy(aFromData, aToData, sizeof(aToData));
+	}
+
+	for(int i = 0; i < 50; i++)
+	{
+		std::string Message = "player" + std::to_string(i) + ": ";
+		for(int k = 0; k < 1 + i % 20; k++)
+			Message += "gg wp nice finish ";
+		vvPackets.emplace_back(Message.begin(), Message.end());
+	}
+
+	for(int i = 0; i < 50; i++)
+	{
+		std::vector<unsigned char> vPacket(Random() % 1400);
+		for(auto &Byte : vPacket)
+			Byte = Random() % 4 ? 0 : Random();
+		vvPackets.push_back(vPacket);
+	}
+	return vvPackets;
+}
+
+TEST(Huffman, Roundtrip)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	unsigned char aCompressed[4096];
+	unsigned char aDecompressed[2048];
+	for(const auto &vPacket : PacketCorpus())
+	{
+		const int Size = Huffman.Compress(vPacket.data(), vPacket.size(), aCompressed, sizeof(aCompressed));
+		ASSERT_GT(Size, 0);
+		ASSERT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, sizeof(aDecompressed)), (int)vPacket.size());
+		EXPECT_EQ(mem_comp(aDecompressed, vPacket.data(), vPacket.size()), 0);
+
+		// output buffers that are too small
+		EXPECT_EQ(Huffman.Compress(vPacket.data(), vPacket.size(), aCompressed, Size - 1), -1);
+		EXPECT_EQ(Huffman.Compress(vPacket.data(), vPacket.size(), aCompressed, Size), Size);
+		if(!vPacket.empty())
+		{
+			EXPECT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, vPacket.size() - 1), -1);
+		}
+		EXPECT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, vPacket.size()), (int)vPacket.size());
+	}
+}
+
+// Throughput on the packet corpus, run with --gtest_also_run_disabled_tests
+TEST(Huffman, DISABLED_BenchmarkCorpus)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	const auto vvPackets = PacketCorpus();
+	std::vector<std::vector<unsigned char>> vvCompressed;
+	size_t TotalSize = 0;
+	size_t TotalCompressedSize = 0;
+	for(const auto &vPacket : vvPackets)
+	{
+		unsigned char aCompressed[4096];
+		const int Size = Huffman.Compress(vPacket.data(), vPacket.size(), aCompressed, sizeof(aCompressed));
+		ASSERT_GT(Size, 0);
+		vvCompressed.emplace_back(aCompressed, aCompressed + Size);
+		TotalSize += vPacket.size();
+		TotalCompressedSize += Size;
+	}
+
+	// best throughput of a few rounds in MB/s of uncompressed data
+	double BestCompress = 0.0;
+	double BestDecompress = 0.0;
+	int Checksum = 0;
+	for(int Round = 0; Round < 5; Round++)
+	{
+		unsigned char aBuffer[4096];
+		auto Start = std::chrono::steady_clock::now();
+		for(int Repeat = 0; Repeat < 20; Repeat++)
+		{
+			for(const auto &vPacket : vvPackets)
+				Checksum += Huffman.Compress(vPacket.data(), vPacket.size(), aBuffer, sizeof(aBuffer));
+		}
+		std::chrono::duration<double> Duration = std::chrono::steady_clock::now() - Start;
+		BestCompress = std::max(BestCompress, TotalSize * 20 / Duration.count() / 1e6);
+
+		Start = std::chrono::steady_clock::now();
+		for(int Repeat = 0; Repeat < 20; Repeat++)
+		{
+			for(const auto &vCompressed : vvCompressed)
+				Checksum += Huffman.Decompress(vCompressed.data(), vCompressed.size(), aBuffer, sizeof(aBuffer));
+		}
+		Duration = std::chrono::steady_clock::now() - Start;
+		BestDecompress = std::max(BestDecompress, TotalSize * 20 / Duration.count() / 1e6);
+	}
+	EXPECT_GT(Checksum, 0);
+	log_info("huffman_test", "%d packets, %d bytes compressed to %d: compress %.0f MB/s, decompress %.0f MB/s",
+		(int)vvPackets.size(), (int)TotalSize, (int)TotalCompressedSize, BestCompress, BestDecompress);
+}
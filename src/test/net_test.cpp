@@ -1,5 +1,8 @@
 #include <base/system.h>
 
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
 #include <gtest/gtest.h>
 
 #include <chrono>
@@ -52,3 +55,255 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+TEST(Net, BatchedSendKeepsOrder)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	// more packets than fit into one batch, few enough for the receive buffer
+	const int NumPackets = 200;
+	NETSTATS Before;
+	net_stats(&Before);
+	net_udp_batch_begin(Socket2);
+	for(int i = 0; i < NumPackets; i++)
+		EXPECT_EQ(net_udp_send(Socket2, &Target, &i, sizeof(i)), (int)sizeof(i));
+#if defined(CONF_PLATFORM_LINUX)
+	NETSTATS Queued;
+	net_stats(&Queued);
+	EXPECT_LT(Queued.send_calls - Before.send_calls, 5u);
+#endif
+	net_udp_batch_end(Socket2);
+	NETSTATS After;
+	net_stats(&After);
+	EXPECT_EQ(After.sent_packets - Before.sent_packets, (uint64_t)NumPackets);
+#if defined(CONF_PLATFORM_LINUX)
+	EXPECT_LT(After.send_calls - Before.send_calls, 5u);
+#endif
+
+	NETADDR Addr;
+	unsigned char *pData;
+	for(int i = 0; i < NumPackets; i++)
+	{
+		// received packets are buffered, only wait once they are used up
+		int Size = net_udp_recv(Socket1, &Addr, &pData);
+		if(Size <= 0)
+		{
+			ASSERT_EQ(net_socket_read_wait(Socket1, 10s), 1) << i;
+			Size = net_udp_recv(Socket1, &Addr, &pData);
+		}
+		ASSERT_EQ(Size, (int)sizeof(i));
+		int Received;
+		mem_copy(&Received, pData, sizeof(Received));
+		EXPECT_EQ(Received, i);
+	}
+
+	// sends after the batch go out immediately again
+	EXPECT_EQ(net_udp_send(Socket2, &Target, "abc", 3), 3);
+	EXPECT_EQ(net_socket_read_wait(Socket1, 10s), 1);
+	ASSERT_EQ(net_udp_recv(Socket1, &Addr, &pData), 3);
+	EXPECT_EQ(mem_comp(pData, "abc", 3), 0);
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
+
+TEST(Net, SendErrorsAreCounted)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+	// nothing can be sent to port 0
+	NETADDR Invalid = Target;
+	Invalid.port = 0;
+
+	NETSTATS Before;
+	net_stats(&Before);
+	EXPECT_EQ(net_udp_send(Socket2, &Invalid, "abc", 3), -1);
+	NETSTATS After;
+	net_stats(&After);
+	EXPECT_EQ(After.send_errors - Before.send_errors, 1u);
+
+	// a failed packet in a batch is dropped, the others are still sent
+	net_udp_batch_begin(Socket2);
+	EXPECT_EQ(net_udp_send(Socket2, &Target, "abc", 3), 3);
+	net_udp_send(Socket2, &Invalid, "def", 3);
+	EXPECT_EQ(net_udp_send(Socket2, &Target, "ghi", 3), 3);
+	net_udp_batch_end(Socket2);
+	Before = After;
+	net_stats(&After);
+	EXPECT_EQ(After.send_errors - Before.send_errors, 1u);
+
+	NETADDR Addr;
+	unsigned char *pData;
+	for(const char *pExpected : {"abc", "ghi"})
+	{
+		int Size = net_udp_recv(Socket1, &Addr, &pData);
+		if(Size <= 0)
+		{
+			ASSERT_EQ(net_socket_read_wait(Socket1, 10s), 1) << pExpected;
+			Size = net_udp_recv(Socket1, &Addr, &pData);
+		}
+		ASSERT_EQ(Size, 3);
+		EXPECT_EQ(mem_comp(pData, pExpected, 3), 0);
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
+
+TEST(Net, ServerIoThreads)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	{
+		CNetServerIo Io(Socket1);
+
+		// received on the receive thread
+		const int NumPackets = 100;
+		for(int i = 0; i < NumPackets; i++)
+			EXPECT_EQ(net_udp_send(Socket2, &Target, &i, sizeof(i)), (int)sizeof(i));
+		NETADDR Sender = {};
+		for(int i = 0; i < NumPackets; i++)
+		{
+			const CNetServerIo::CRecvPacket *pPacket = Io.Recv();
+			if(!pPacket)
+			{
+				ASSERT_TRUE(Io.WaitForPackets(10s)) << i;
+				pPacket = Io.Recv();
+			}
+			ASSERT_NE(pPacket, nullptr);
+			ASSERT_EQ(pPacket->m_Size, (int)sizeof(i));
+			int Received;
+			mem_copy(&Received, pPacket->m_aData, sizeof(Received));
+			EXPECT_EQ(Received, i);
+			Sender = pPacket->m_Addr;
+		}
+		EXPECT_EQ(Io.Recv(), nullptr);
+
+		// sent on the send thread, in order
+		Io.BeginBatch();
+		for(int i = 0; i < NumPackets; i++)
+			Io.Send(&Sender, &i, sizeof(i));
+		Io.EndBatch();
+
+		NETADDR Addr;
+		unsigned char *pData;
+		for(int i = 0; i < NumPackets; i++)
+		{
+			int Size = net_udp_recv(Socket2, &Addr, &pData);
+			if(Size <= 0)
+			{
+				ASSERT_EQ(net_socket_read_wait(Socket2, 10s), 1) << i;
+				Size = net_udp_recv(Socket2, &Addr, &pData);
+			}
+			ASSERT_EQ(Size, (int)sizeof(i));
+			int Received;
+			mem_copy(&Received, pData, sizeof(Received));
+			EXPECT_EQ(Received, i);
+		}
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
+
+static int StoreNewClient(int ClientId, void *pUser, bool Sixup)
+{
+	*static_cast<int *>(pUser) = ClientId;
+	return 0;
+}
+
+static int IgnoreDelClient(int ClientId, const char *pReason, void *pUser)
+{
+	return 0;
+}
+
+TEST(Net, ServerSlotAddrsStayBounded)
+{
+	const int ConnlimitBefore = g_Config.m_SvConnlimit;
+	g_Config.m_SvConnlimit = 100;
+
+	NETADDR Bindaddr = {};
+	ASSERT_FALSE(net_addr_from_str(&Bindaddr, "127.0.0.1"));
+	CNetServer Server;
+	do
+	{
+		Bindaddr.port = secure_rand_below(65535 - 1024) + 1024;
+	} while(!Server.Open(Bindaddr, nullptr, 8, 8));
+	int NewClientId = -1;
+	Server.SetCallbacks(StoreNewClient, IgnoreDelClient, &NewClientId);
+
+	NETADDR ClientBindaddr = {};
+	ClientBindaddr.type = NETTYPE_IPV4;
+	for(int i = 0; i < 30; i++)
+	{
+		// every client gets a new port, so a new address
+		CNetClient Client;
+		ASSERT_TRUE(Client.Open(ClientBindaddr));
+		Client.Connect(&Bindaddr, 1);
+
+		NewClientId = -1;
+		const int64_t Timeout = time_get() + 10 * time_freq();
+		while(NewClientId == -1 && time_get() < Timeout)
+		{
+			CNetChunk Chunk;
+			SECURITY_TOKEN ResponseToken;
+			Client.Update();
+			while(Client.Recv(&Chunk, &ResponseToken, false))
+			{
+			}
+			Server.WaitForPackets(10ms);
+			while(Server.Recv(&Chunk, &ResponseToken))
+			{
+			}
+		}
+		ASSERT_NE(NewClientId, -1) << i;
+		EXPECT_EQ(Server.NumSlotAddrs(), 1);
+		EXPECT_EQ(Server.NumSlotIps(), 1);
+
+		Server.Drop(NewClientId, "test");
+		EXPECT_EQ(Server.NumSlotAddrs(), 0);
+		EXPECT_EQ(Server.NumSlotIps(), 0);
+		Client.Close();
+	}
+
+	Server.Close();
+	g_Config.m_SvConnlimit = ConnlimitBefore;
+}
@@ -0,0 +1,131 @@
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static NETADDR RandomAddr(bool Ipv6)
+{
+	NETADDR Addr = {};
+	Addr.type = Ipv6 ? NETTYPE_IPV6 : NETTYPE_IPV4;
+	// few different first bytes, so that ranges overlap and share prefixes
+	secure_random_fill(Addr.ip, Ipv6 ? 16 : 4);
+	Addr.ip[0] = 10 + Addr.ip[0] % 4;
+	return Addr;
+}
+
+static bool InRange(const CNetRange &Range, const NETADDR &Addr)
+{
+	const int Length = Addr.type == NETTYPE_IPV4 ? 4 : 16;
+	return Range.m_LB.type == Addr.type &&
+	       mem_comp(Range.m_LB.ip, Addr.ip, Length) <= 0 &&
+	       mem_comp(Range.m_UB.ip, Addr.ip, Length) >= 0;
+}
+
+TEST(NetBan, Ranges)
+{
+	auto pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan Ban;
+	Ban.Init(pConsole.get(), nullptr);
+
+	std::vector<CNetRange> vRanges;
+	for(int i = 0; i < 400; i++)
+	{
+		const bool Ipv6 = i % 4 == 3;
+		CNetRange Range;
+		Range.m_LB = RandomAddr(Ipv6);
+		Range.m_UB = Range.m_LB;
+		// spans from a few addresses up to a whole /8
+		const int Length = Ipv6 ? 16 : 4;
+		const int Start = 1 + secure_rand_below(Length - 1);
+		for(int b = Start; b < Length; b++)
+			Range.m_UB.ip[b] = 255;
+		Range.m_UB.ip[Start - 1] = std::min(255, Range.m_UB.ip[Start - 1] + (int)secure_rand_below(3));
+		if(!Range.IsValid())
+			continue;
+		ASSERT_EQ(Ban.BanRange(&Range, 0, "test"), 0);
+		vRanges.push_back(Range);
+	}
+
+	auto Check = [&]() {
+		for(int i = 0; i < 5000; i++)
+		{
+			NETADDR Addr;
+			if(i % 2 == 0 && !vRanges.empty())
+			{
+				// near a bound of a range
+				const CNetRange &Range = vRanges[i % vRanges.size()];
+				Addr = i % 4 == 0 ? Range.m_LB : Range.m_UB;
+				const int Length = Addr.type == NETTYPE_IPV4 ? 4 : 16;
+				Addr.ip[Length - 1] += (int)secure_rand_below(3) - 1;
+			}
+			else
+			{
+				Addr = RandomAddr(i % 3 == 0);
+			}
+
+			bool Expected = false;
+			for(const CNetRange &Range : vRanges)
+				Expected = Expected || InRange(Range, Addr);
+
+			char aBuf[256];
+			char aAddr[NETADDR_MAXSTRSIZE];
+			net_addr_str(&Addr, aAddr, sizeof(aAddr), false);
+			EXPECT_EQ(Ban.IsBanned(&Addr, aBuf, sizeof(aBuf)), Expected) << aAddr;
+		}
+	};
+	Check();
+
+	// the index follows removed bans
+	for(size_t i = 0; i < vRanges.size(); i += 2)
+		ASSERT_EQ(Ban.UnbanByRange(&vRanges[i]), 0);
+	std::vector<CNetRange> vRemaining;
+	for(size_t i = 1; i < vRanges.size(); i += 2)
+		vRemaining.push_back(vRanges[i]);
+	vRanges = vRemaining;
+	Check();
+
+	Ban.UnbanAll();
+	vRanges.clear();
+	Check();
+}
+
+TEST(NetBan, AddrAndRange)
+{
+	auto pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan Ban;
+	Ban.Init(pConsole.get(), nullptr);
+
+	NETADDR Addr, Other;
+	ASSERT_FALSE(net_addr_from_str(&Addr, "1.2.3.4:8303"));
+	ASSERT_FALSE(net_addr_from_str(&Other, "1.2.3.5"));
+	CNetRange Range;
+	ASSERT_FALSE(net_addr_from_str(&Range.m_LB, "[2001:db8::]"));
+	ASSERT_FALSE(net_addr_from_str(&Range.m_UB, "[2001:db8::ffff]"));
+
+	char aBuf[256];
+	EXPECT_FALSE(Ban.IsBanned(&Addr, aBuf, sizeof(aBuf)));
+	ASSERT_EQ(Ban.BanAddr(&Addr, 60, "addr", false), 0);
+	ASSERT_EQ(Ban.BanRange(&Range, 0, "range"), 0);
+
+	// the port does not matter
+	Addr.port = 1234;
+	EXPECT_TRUE(Ban.IsBanned(&Addr, aBuf, sizeof(aBuf)));
+	EXPECT_TRUE(str_find(aBuf, "addr"));
+	EXPECT_FALSE(Ban.IsBanned(&Other, aBuf, sizeof(aBuf)));
+
+	NETADDR Inside, Outside;
+	ASSERT_FALSE(net_addr_from_str(&Inside, "[2001:db8::1234]"));
+	ASSERT_FALSE(net_addr_from_str(&Outside, "[2001:db8::1:0]"));
+	EXPECT_TRUE(Ban.IsBanned(&Inside, aBuf, sizeof(aBuf)));
+	EXPECT_TRUE(str_find(aBuf, "range"));
+	EXPECT_FALSE(Ban.IsBanned(&Outside, aBuf, sizeof(aBuf)));
+
+	// websocket addresses are matched like the plain ones
+	Inside.type = NETTYPE_WEBSOCKET_IPV6;
+	EXPECT_TRUE(Ban.IsBanned(&Inside, aBuf, sizeof(aBuf)));
+}
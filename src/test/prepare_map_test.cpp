@@ -0,0 +1,156 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/map.h>
+#include <engine/server/server.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+
+#include <game/mapitems.h>
+#include <game/server/gamecontext.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(PrepareMap, VoteCommandMap)
+{
+	char aMap[IO_MAX_PATH_LENGTH];
+	EXPECT_TRUE(CGameContext::VoteCommandMap("change_map Kobra 4", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "Kobra 4");
+	EXPECT_TRUE(CGameContext::VoteCommandMap("sv_map coverage", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "coverage");
+	EXPECT_TRUE(CGameContext::VoteCommandMap("change_map   \"Kobra 4\"", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "Kobra 4");
+	EXPECT_TRUE(CGameContext::VoteCommandMap("change_map novice/Tutorial", aMap, sizeof(aMap)));
+	EXPECT_STREQ(aMap, "novice/Tutorial");
+
+	char aShort[4];
+	EXPECT_TRUE(CGameContext::VoteCommandMap("change_map coverage", aShort, sizeof(aShort)));
+	EXPECT_STREQ(aShort, "cov");
+
+	// commands that do more than changing the map or are not map changes
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map coverage; sv_map other", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map \"coverage\" other", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map \"coverage", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map \"cover\\\"age\"", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map ", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_map \"\"", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("change_mapcoverage", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("random_map", aMap, sizeof(aMap)));
+	EXPECT_FALSE(CGameContext::VoteCommandMap("say change_map coverage", aMap, sizeof(aMap)));
+}
+
+class CTestPrepareMap : public ::testing::Test
+{
+public:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IStorage> m_pStorage;
+	CJobPool m_Pool;
+
+	CTestPrepareMap()
+	{
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		EXPECT_NE(m_pStorage, nullptr);
+		m_Pool.Init(1);
+	}
+
+	~CTestPrepareMap() override
+	{
+		m_Pool.Shutdown();
+	}
+
+	std::shared_ptr<CServer::CPrepareMapJob> Prepare(const char *pMapName, bool Sixup)
+	{
+		auto pJob = std::make_shared<CServer::CPrepareMapJob>(m_pStorage.get(), pMapName, Sixup);
+		m_Pool.Add(pJob);
+		while(!pJob->Done())
+			std::this_thread::sleep_for(1ms);
+		return pJob;
+	}
+};
+
+TEST_F(CTestPrepareMap, Prepare)
+{
+	auto pJob = Prepare("coverage", false);
+	ASSERT_EQ(pJob->State(), IJob::STATE_DONE);
+	ASSERT_TRUE(pJob->m_Success);
+	ASSERT_NE(pJob->m_pMap, nullptr);
+	EXPECT_TRUE(pJob->m_pMap->IsLoaded());
+	ASSERT_NE(pJob->m_apData[CServer::MAP_TYPE_SIX], nullptr);
+	EXPECT_EQ(pJob->m_aSize[CServer::MAP_TYPE_SIX], (unsigned)pJob->m_pMap->Size());
+	EXPECT_EQ(sha256(pJob->m_apData[CServer::MAP_TYPE_SIX], pJob->m_aSize[CServer::MAP_TYPE_SIX]), pJob->m_pMap->Sha256());
+	EXPECT_GT(pJob->m_PrepareTime.count(), 0);
+
+	// the same map that was prepared can be used right away
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "coverage", "maps/coverage.map", false), pJob);
+}
+
+TEST_F(CTestPrepareMap, TakeOtherMap)
+{
+	EXPECT_EQ(CServer::TakePreparedMap(nullptr, "coverage", "maps/coverage.map", false), nullptr);
+
+	auto pJob = Prepare("coverage", false);
+	ASSERT_TRUE(pJob->m_Success);
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "other", "maps/other.map", false), nullptr);
+	// the map settings were imported into a temporary map
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "coverage", "maps/coverage.map.tmp", false), nullptr);
+	// sixup was enabled while the map was prepared
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "coverage", "maps/coverage.map", true), nullptr);
+}
+
+TEST_F(CTestPrepareMap, TakeQueued)
+{
+	auto pJob = std::make_shared<CServer::CPrepareMapJob>(m_pStorage.get(), "coverage", false);
+	ASSERT_EQ(pJob->State(), IJob::STATE_QUEUED);
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "coverage", "maps/coverage.map", false), nullptr);
+	EXPECT_EQ(pJob->State(), IJob::STATE_ABORTED);
+}
+
+TEST_F(CTestPrepareMap, TakeFailed)
+{
+	auto pJob = Prepare("does_not_exist", false);
+	EXPECT_FALSE(pJob->m_Success);
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "does_not_exist", "maps/does_not_exist.map", false), nullptr);
+}
+
+TEST_F(CTestPrepareMap, TakeModified)
+{
+	auto pJob = Prepare("coverage", false);
+	ASSERT_TRUE(pJob->m_Success);
+	// as if the file was written after the job read it
+	pJob->m_Modified--;
+	EXPECT_EQ(CServer::TakePreparedMap(pJob, "coverage", "maps/coverage.map", false), nullptr);
+}
+
+TEST_F(CTestPrepareMap, GameDataIndices)
+{
+	std::unique_ptr<IEngineMap> pMap(CreateEngineMap());
+	ASSERT_TRUE(pMap->Load(m_pStorage.get(), "maps/coverage.map", IStorage::TYPE_ALL));
+	const std::vector<int> vIndices = CServer::CPrepareMapJob::GameDataIndices(pMap.get());
+	EXPECT_TRUE(std::is_sorted(vIndices.begin(), vIndices.end()));
+	EXPECT_LT((int)vIndices.size(), pMap->NumData());
+
+	// all tilemaps are read, embedded images are not
+	int Start, Num;
+	pMap->GetType(MAPITEMTYPE_LAYER, &Start, &Num);
+	for(int i = Start; i < Start + Num; i++)
+	{
+		const CMapItemLayer *pLayer = static_cast<CMapItemLayer *>(pMap->GetItem(i));
+		if(pLayer->m_Type == LAYERTYPE_TILES)
+			EXPECT_TRUE(std::binary_search(vIndices.begin(), vIndices.end(), reinterpret_cast<const CMapItemLayerTilemap *>(pLayer)->m_Data));
+	}
+	pMap->GetType(MAPITEMTYPE_IMAGE, &Start, &Num);
+	for(int i = Start; i < Start + Num; i++)
+	{
+		const CMapItemImage *pImage = static_cast<CMapItemImage *>(pMap->GetItem(i));
+		if(!pImage->m_External)
+			EXPECT_FALSE(std::binary_search(vIndices.begin(), vIndices.end(), pImage->m_ImageData));
+	}
+}
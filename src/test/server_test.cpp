@@ -1,7 +1,11 @@
 #include <engine/server/server.h>
+#include <engine/shared/masterserver.h>
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 TEST(Server, StrHideIps)
 {
 	char aLine[512];
@@ -59,3 +63,82 @@ TEST(Server, StrHideIps)
 	EXPECT_STREQ(aLine, "<{<{a}>}>");
 	EXPECT_STREQ(aLineWithoutIps, "XXX}>}>");
 }
+
+static void ExpectSameCache(const CServer::CCache &Cache, const CServer::CCache &Expected, int Step)
+{
+	ASSERT_EQ(Cache.m_vCache.size(), Expected.m_vCache.size()) << "step " << Step;
+	for(size_t i = 0; i < Cache.m_vCache.size(); i++)
+	{
+		EXPECT_EQ(Cache.m_vCache[i].m_vData, Expected.m_vCache[i].m_vData) << "step " << Step << " chunk " << i;
+		EXPECT_EQ(Cache.m_vCache[i].m_EndClient, Expected.m_vCache[i].m_EndClient) << "step " << Step << " chunk " << i;
+		EXPECT_EQ(Cache.m_vCache[i].m_ClientsBefore, Expected.m_vCache[i].m_ClientsBefore) << "step " << Step << " chunk " << i;
+	}
+}
+
+TEST(Server, ServerInfoCacheMatchesRebuild)
+{
+	std::mt19937 Random(1337);
+	std::uniform_int_distribution<int> RandomClient(0, MAX_CLIENTS - 1);
+	std::uniform_int_distribution<int> RandomByte('a', 'z');
+	std::uniform_int_distribution<int> RandomEntrySize(10, 60);
+	auto RandomBytes = [&](int Size) {
+		std::vector<uint8_t> vData(Size);
+		for(uint8_t &Byte : vData)
+			Byte = RandomByte(Random);
+		vData.back() = 0;
+		return vData;
+	};
+
+	CServer::CServerInfoClient aClients[MAX_CLIENTS];
+	for(auto &Client : aClients)
+		Client.m_vEntry = RandomBytes(RandomEntrySize(Random));
+	std::vector<uint8_t> vHeader = RandomBytes(50);
+
+	const int aTypes[] = {SERVERINFO_VANILLA, SERVERINFO_64_LEGACY, SERVERINFO_EXTENDED, SERVERINFO_INGAME};
+	CServer::CCache aCaches[std::size(aTypes)][2];
+	for(int Step = 0; Step < 2000; Step++)
+	{
+		// joins and leaves with a changed player count in the header, renames and header only changes
+		int FirstChanged = MAX_CLIENTS;
+		const int Change = Step == 0 ? 0 : Random() % 4;
+		if(Change == 0 || Change == 1)
+		{
+			const int ClientId = RandomClient(Random);
+			aClients[ClientId].m_Included = !aClients[ClientId].m_Included;
+			FirstChanged = ClientId;
+			vHeader[Random() % (vHeader.size() - 1)] = RandomByte(Random);
+			if(Random() % 8 == 0)
+				vHeader.insert(vHeader.begin(), RandomByte(Random));
+			else if(Random() % 8 == 0 && vHeader.size() > 10)
+				vHeader.erase(vHeader.begin());
+		}
+		else if(Change == 2)
+		{
+			const int ClientId = RandomClient(Random);
+			aClients[ClientId].m_vEntry = RandomBytes(RandomEntrySize(Random));
+			FirstChanged = aClients[ClientId].m_Included ? ClientId : MAX_CLIENTS;
+		}
+		else
+		{
+			vHeader[Random() % (vHeader.size() - 1)] = RandomByte(Random);
+		}
+		if(Step == 0)
+			FirstChanged = 0;
+
+		for(size_t t = 0; t < std::size(aTypes); t++)
+		{
+			for(int SendClients = 0; SendClients < 2; SendClients++)
+			{
+				CServer::CacheServerInfoChunks(&aCaches[t][SendClients], aClients, aTypes[t], SendClients, vHeader.data(), vHeader.size(), FirstChanged);
+				CServer::CCache Rebuilt;
+				CServer::CacheServerInfoChunks(&Rebuilt, aClients, aTypes[t], SendClients, vHeader.data(), vHeader.size(), 0);
+				ExpectSameCache(aCaches[t][SendClients], Rebuilt, Step);
+			}
+		}
+		if(::testing::Test::HasFailure())
+			break;
+	}
+
+	// the extended info was split over more than one chunk
+	EXPECT_GT(aCaches[2][1].m_vCache.size(), 1u);
+}
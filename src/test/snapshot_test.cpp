@@ -1,11 +1,19 @@
+#include <base/logger.h>
 #include <base/system.h>
 
 #include <engine/shared/snapshot.h>
 
+#include <engine/shared/compression.h>
+
 #include <generated/protocol.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+
 TEST(Snapshot, CrcOneInt)
 {
 	CSnapshotBuilder Builder;
@@ -85,3 +93,245 @@ TEST(Snapshot, CrcOverflow)
 
 	ASSERT_EQ(pSnapshot->Crc(), 1);
 }
+
+// Snapshot with characters, player infos and extended character items
+// of 64 players, filled up with pickups to at most NumItems items
+static int BuildGameSnapshot(CSnapshot *pSnapshot, int NumItems, int Seed)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(int i = 0; i < 64; i++)
+	{
+		CNetObj_Character *pCharacter = static_cast<CNetObj_Character *>(Builder.NewItem(NETOBJTYPE_CHARACTER, i, sizeof(CNetObj_Character)));
+		CNetObj_PlayerInfo *pPlayerInfo = static_cast<CNetObj_PlayerInfo *>(Builder.NewItem(NETOBJTYPE_PLAYERINFO, i, sizeof(CNetObj_PlayerInfo)));
+		CNetObj_DDNetCharacter *pDDNetCharacter = static_cast<CNetObj_DDNetCharacter *>(Builder.NewItem(NETOBJTYPE_DDNETCHARACTER, i, sizeof(CNetObj_DDNetCharacter)));
+		EXPECT_TRUE(pCharacter && pPlayerInfo && pDDNetCharacter);
+		if(!pCharacter || !pPlayerInfo || !pDDNetCharacter)
+			return 0;
+		pCharacter->m_X = i * 32 + Seed;
+		pCharacter->m_Y = Seed;
+		pPlayerInfo->m_ClientId = i;
+		pDDNetCharacter->m_Flags = Seed;
+	}
+	for(int i = 0; i < NumItems - 3 * 64; i++)
+	{
+		// skip some ids to have deleted and new items between seeds
+		if((i + Seed) % 7 == 0)
+			continue;
+		CNetObj_Pickup *pPickup = static_cast<CNetObj_Pickup *>(Builder.NewItem(NETOBJTYPE_PICKUP, i, sizeof(CNetObj_Pickup)));
+		if(!pPickup)
+			break;
+		pPickup->m_X = i * Seed;
+		pPickup->m_Y = i;
+	}
+	return Builder.Finish(pSnapshot);
+}
+
+TEST(Snapshot, BuilderGetItemData)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	void *pFirst = Builder.NewItem(NETOBJTYPE_FLAG, 0, sizeof(CNetObj_Flag));
+	void *pSecond = Builder.NewItem(NETOBJTYPE_FLAG, 1, sizeof(CNetObj_Flag));
+	void *pDuplicate = Builder.NewItem(NETOBJTYPE_FLAG, 0, sizeof(CNetObj_Flag));
+	ASSERT_TRUE(pFirst && pSecond && pDuplicate);
+	EXPECT_EQ(Builder.GetItemData((NETOBJTYPE_FLAG << 16) | 0), pFirst);
+	EXPECT_EQ(Builder.GetItemData((NETOBJTYPE_FLAG << 16) | 1), pSecond);
+	EXPECT_EQ(Builder.GetItemData((NETOBJTYPE_FLAG << 16) | 2), nullptr);
+	EXPECT_EQ(Builder.GetItemData((NETOBJTYPE_PICKUP << 16) | 0), nullptr);
+
+	Builder.Init();
+	EXPECT_EQ(Builder.GetItemData((NETOBJTYPE_FLAG << 16) | 0), nullptr);
+}
+
+TEST(Snapshot, KeyIndexFindItem)
+{
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	BuildGameSnapshot(pSnapshot, CSnapshot::MAX_ITEMS, 1);
+	ASSERT_GT(pSnapshot->NumItems(), CSnapshot::MAX_ITEMS / 2);
+
+	CSnapshotKeyIndex Index;
+	Index.Build(pSnapshot);
+	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	{
+		const int Key = pSnapshot->GetItem(i)->Key();
+		EXPECT_EQ(Index.Find(Key), pSnapshot->GetItemIndex(Key));
+	}
+	const int aTypes[] = {NETOBJTYPE_CHARACTER, NETOBJTYPE_PLAYERINFO, NETOBJTYPE_DDNETCHARACTER, NETOBJTYPE_PICKUP, NETOBJTYPE_FLAG};
+	for(int Type : aTypes)
+	{
+		for(int Id = 0; Id < CSnapshot::MAX_ITEMS + 1; Id++)
+			EXPECT_EQ(Index.FindItem(pSnapshot, Type, Id), pSnapshot->FindItem(Type, Id));
+	}
+	EXPECT_NE(Index.FindItem(pSnapshot, NETOBJTYPE_DDNETCHARACTER, 63), nullptr);
+	EXPECT_EQ(Index.FindItem(pSnapshot, NETOBJTYPE_DDNETCHARACTER, 64), nullptr);
+}
+
+TEST(Snapshot, DeltaRoundtrip)
+{
+	char aFromData[CSnapshot::MAX_SIZE];
+	char aToData[CSnapshot::MAX_SIZE];
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	char aUnpackedData[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)aFromData;
+	CSnapshot *pTo = (CSnapshot *)aToData;
+	CSnapshot *pUnpacked = (CSnapshot *)aUnpackedData;
+	BuildGameSnapshot(pFrom, CSnapshot::MAX_ITEMS, 1);
+	const int ToSize = BuildGameSnapshot(pTo, CSnapshot::MAX_ITEMS, 2);
+
+	CSnapshotDelta Delta;
+	const int DeltaSize = Delta.CreateDelta(pFrom, pTo, aDeltaData);
+	ASSERT_GT(DeltaSize, 0);
+	const int UnpackedSize = Delta.UnpackDelta(pFrom, pUnpacked, aDeltaData, DeltaSize, false);
+	ASSERT_EQ(UnpackedSize, ToSize);
+	// items can be in a different order, compare them by key
+	ASSERT_EQ(pUnpacked->NumItems(), pTo->NumItems());
+	for(int i = 0; i < pTo->NumItems(); i++)
+	{
+		const int Index = pUnpacked->GetItemIndex(pTo->GetItem(i)->Key());
+		ASSERT_GE(Index, 0);
+		ASSERT_EQ(pUnpacked->GetItemSize(Index), pTo->GetItemSize(i));
+		EXPECT_EQ(mem_comp(pUnpacked->GetItem(Index)->Data(), pTo->GetItem(i)->Data(), pTo->GetItemSize(i)), 0);
+	}
+}
+
+// Best time of a few rounds, in nanoseconds per call of Func
+template<typename F>
+static double BenchmarkNs(int Calls, F &&Func)
+{
+	double Best = -1.0;
+	for(int Round = 0; Round < 5; Round++)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		for(int i = 0; i < Calls; i++)
+			Func();
+		const std::chrono::duration<double, std::nano> Duration = std::chrono::steady_clock::now() - Start;
+		const double Time = Duration.count() / Calls;
+		Best = Best < 0.0 ? Time : std::min(Best, Time);
+	}
+	return Best;
+}
+
+// Microbenchmarks, run with --gtest_also_run_disabled_tests
+TEST(Snapshot, DISABLED_BenchmarkKeyLookup)
+{
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	BuildGameSnapshot(pSnapshot, CSnapshot::MAX_ITEMS, 1);
+	CSnapshotKeyIndex Index;
+	Index.Build(pSnapshot);
+
+	// look up every item like the client does for the previous snapshot
+	int Found = 0;
+	const double LinearTime = BenchmarkNs(10, [&]() {
+		for(int i = 0; i < pSnapshot->NumItems(); i++)
+			Found += pSnapshot->GetItemIndex(pSnapshot->GetItem(i)->Key()) >= 0;
+	});
+	const double IndexTime = BenchmarkNs(10, [&]() {
+		Index.Build(pSnapshot);
+		for(int i = 0; i < pSnapshot->NumItems(); i++)
+			Found += Index.Find(pSnapshot->GetItem(i)->Key()) >= 0;
+	});
+	EXPECT_GT(Found, 0);
+	log_info("snapshot_test", "looking up %d items: linear %.1f us, index (including building it) %.1f us", pSnapshot->NumItems(), LinearTime / 1000.0, IndexTime / 1000.0);
+}
+
+TEST(Snapshot, DISABLED_BenchmarkUnpackDelta)
+{
+	// per item cost of unpacking a delta should not grow with the number of items
+	const int aNumItems[2] = {250, CSnapshot::MAX_ITEMS};
+	for(int Size = 0; Size < 2; Size++)
+	{
+		char aFromData[CSnapshot::MAX_SIZE];
+		char aToData[CSnapshot::MAX_SIZE];
+		char aDeltaData[CSnapshot::MAX_SIZE];
+		char aUnpackedData[CSnapshot::MAX_SIZE];
+		CSnapshot *pFrom = (CSnapshot *)aFromData;
+		CSnapshot *pTo = (CSnapshot *)aToData;
+		BuildGameSnapshot(pFrom, aNumItems[Size], 1);
+		BuildGameSnapshot(pTo, aNumItems[Size], 2);
+
+		CSnapshotDelta Delta;
+		const int DeltaSize = Delta.CreateDelta(pFrom, pTo, aDeltaData);
+		const double Time = BenchmarkNs(20, [&]() {
+			EXPECT_GT(Delta.UnpackDelta(pFrom, (CSnapshot *)aUnpackedData, aDeltaData, DeltaSize, false), 0);
+		});
+		log_info("snapshot_test", "unpacking delta of %d items: %.1f us, %.1f ns per item", pTo->NumItems(), Time / 1000.0, Time / pTo->NumItems());
+	}
+}
+
+// Scalar reference for the SIMD diff kernels
+static int DiffItemReference(const int *pPast, const int *pCurrent, int *pOut, int Size)
+{
+	int Needed = 0;
+	for(int i = 0; i < Size; i++)
+	{
+		pOut[i] = (unsigned)pCurrent[i] - (unsigned)pPast[i];
+		Needed |= pOut[i];
+	}
+	return Needed;
+}
+
+static void UndiffItemReference(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+{
+	for(int i = 0; i < Size; i++)
+	{
+		pOut[i] = (unsigned)pPast[i] + (unsigned)pDiff[i];
+		if(pDiff[i] == 0)
+			*pDataRate += 1;
+		else
+		{
+			unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+			unsigned char *pEnd = CVariableInt::Pack(aBuf, pDiff[i], sizeof(aBuf));
+			*pDataRate += (uint64_t)(pEnd - (unsigned char *)aBuf) * 8;
+		}
+	}
+}
+
+TEST(Snapshot, DiffItemFuzz)
+{
+	std::mt19937 Random(1337);
+	// values around the boundaries of the packed int sizes
+	const int aEdges[] = {0, 1, -1, 63, 64, -64, -65, 8191, 8192, -8192, -8193, (1 << 20) - 1, 1 << 20, -(1 << 20) - 1,
+		(1 << 27) - 1, 1 << 27, -(1 << 27) - 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+	auto RandomInt = [&]() {
+		switch(Random() % 4)
+		{
+		case 0: return aEdges[Random() % std::size(aEdges)];
+		case 1: return (int)(Random() % 128) - 64;
+		default: return (int)Random();
+		}
+	};
+
+	int aPast[72];
+	int aCurrent[72];
+	int aDiff[72];
+	int aDiffReference[72];
+	int aOut[72];
+	int aOutReference[72];
+	for(int Round = 0; Round < 20000; Round++)
+	{
+		const int Size = Random() % 65;
+		// unaligned starts and unchanged ints, like in real items
+		const int Offset = Random() % 8;
+		for(int i = 0; i < Size; i++)
+		{
+			aPast[Offset + i] = RandomInt();
+			aCurrent[Offset + i] = Random() % 3 == 0 ? aPast[Offset + i] : RandomInt();
+		}
+
+		const int Needed = CSnapshotDelta::DiffItem(aPast + Offset, aCurrent + Offset, aDiff + Offset, Size);
+		const int NeededReference = DiffItemReference(aPast + Offset, aCurrent + Offset, aDiffReference + Offset, Size);
+		ASSERT_EQ(Needed, NeededReference);
+		ASSERT_EQ(mem_comp(aDiff + Offset, aDiffReference + Offset, Size * sizeof(int)), 0);
+
+		uint64_t DataRate = Round;
+		uint64_t DataRateReference = Round;
+		CSnapshotDelta::UndiffItem(aPast + Offset, aDiff + Offset, aOut + Offset, Size, &DataRate);
+		UndiffItemReference(aPast + Offset, aDiff + Offset, aOutReference + Offset, Size, &DataRateReference);
+		ASSERT_EQ(DataRate, DataRateReference);
+		ASSERT_EQ(mem_comp(aOut + Offset, aOutReference + Offset, Size * sizeof(int)), 0);
+		ASSERT_EQ(mem_comp(aOut + Offset, aCurrent + Offset, Size * sizeof(int)), 0);
+	}
+}
@@ -0,0 +1,72 @@
+#include <engine/shared/spsc_queue.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+TEST(SpscQueue, Empty)
+{
+	CSpscQueue<int> Queue(4);
+	EXPECT_TRUE(Queue.Empty());
+	EXPECT_EQ(Queue.Front(), nullptr);
+}
+
+TEST(SpscQueue, Fifo)
+{
+	CSpscQueue<int> Queue(3);
+	for(int Round = 0; Round < 5; Round++)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			int *pElement = Queue.Back();
+			ASSERT_NE(pElement, nullptr);
+			*pElement = Round * 10 + i;
+			Queue.Push();
+		}
+		EXPECT_EQ(Queue.Back(), nullptr);
+		EXPECT_FALSE(Queue.Empty());
+		for(int i = 0; i < 3; i++)
+		{
+			int *pElement = Queue.Front();
+			ASSERT_NE(pElement, nullptr);
+			EXPECT_EQ(*pElement, Round * 10 + i);
+			Queue.Pop();
+		}
+		EXPECT_TRUE(Queue.Empty());
+	}
+}
+
+TEST(SpscQueue, TwoThreads)
+{
+	const int NumElements = 1000000;
+	CSpscQueue<int> Queue(64);
+	std::thread Producer([&]() {
+		for(int i = 0; i < NumElements; i++)
+		{
+			int *pElement;
+			while(!(pElement = Queue.Back()))
+				std::this_thread::yield();
+			*pElement = i;
+			Queue.Push();
+		}
+	});
+
+	int Expected = 0;
+	int NumWrong = 0;
+	while(Expected < NumElements)
+	{
+		int *pElement = Queue.Front();
+		if(!pElement)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if(*pElement != Expected)
+			NumWrong++;
+		Queue.Pop();
+		Expected++;
+	}
+	Producer.join();
+	EXPECT_EQ(NumWrong, 0);
+	EXPECT_TRUE(Queue.Empty());
+}
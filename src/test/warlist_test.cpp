@@ -0,0 +1,174 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <game/client/components/tclient/warlist_index.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+static void FillIndex(CWarEntryIndex &Index, int NumEntries)
+{
+	char aName[32];
+	char aClan[32];
+	for(int i = 0; i < NumEntries; i++)
+	{
+		// Every third entry is a clan entry, like in imported lists
+		if(i % 3 == 0)
+		{
+			str_format(aClan, sizeof(aClan), "clan%d", i);
+			Index.Add(i, "", aClan);
+		}
+		else
+		{
+			str_format(aName, sizeof(aName), "name%d", i);
+			Index.Add(i, aName, "");
+		}
+	}
+}
+
+TEST(WarList, IndexFind)
+{
+	CWarEntryIndex Index;
+	Index.Add(0, "foo", "");
+	Index.Add(1, "", "bar");
+	Index.Add(2, "foo", "");
+	Index.Add(3, "baz", "bar");
+
+	EXPECT_EQ(Index.FindName("foo"), std::vector<int>({0, 2}));
+	EXPECT_EQ(Index.FindName("baz"), std::vector<int>({3}));
+	EXPECT_EQ(Index.FindClan("bar"), std::vector<int>({1, 3}));
+	EXPECT_TRUE(Index.FindName("bar").empty());
+	EXPECT_TRUE(Index.FindClan("foo").empty());
+	EXPECT_TRUE(Index.FindName("").empty());
+	EXPECT_TRUE(Index.FindClan("").empty());
+	EXPECT_EQ(Index.NumNames(), 2);
+	EXPECT_EQ(Index.NumClans(), 1);
+
+	Index.Clear();
+	EXPECT_TRUE(Index.FindName("foo").empty());
+	EXPECT_EQ(Index.NumNames(), 0);
+	EXPECT_EQ(Index.NumClans(), 0);
+}
+
+TEST(WarList, IndexUpdate)
+{
+	CWarEntryIndex Index;
+	Index.Add(0, "foo", "");
+	Index.Add(1, "", "bar");
+	Index.Add(2, "foo", "");
+	Index.Add(3, "baz", "bar");
+
+	// Renaming an entry keeps the positions sorted
+	Index.Remove(0, "foo", "");
+	Index.Insert(0, "baz", "bar");
+	EXPECT_EQ(Index.FindName("foo"), std::vector<int>({2}));
+	EXPECT_EQ(Index.FindName("baz"), std::vector<int>({0, 3}));
+	EXPECT_EQ(Index.FindClan("bar"), std::vector<int>({0, 1, 3}));
+
+	// Erasing moves all following entries down
+	Index.Erase(1, "", "bar");
+	EXPECT_EQ(Index.FindName("foo"), std::vector<int>({1}));
+	EXPECT_EQ(Index.FindName("baz"), std::vector<int>({0, 2}));
+	EXPECT_EQ(Index.FindClan("bar"), std::vector<int>({0, 2}));
+
+	// Names without entries are dropped
+	Index.Erase(1, "foo", "");
+	EXPECT_TRUE(Index.FindName("foo").empty());
+	EXPECT_EQ(Index.NumNames(), 1);
+	EXPECT_EQ(Index.FindName("baz"), std::vector<int>({0, 1}));
+
+	// Removing an entry that is not indexed does nothing
+	Index.Remove(5, "baz", "qux");
+	EXPECT_EQ(Index.FindName("baz"), std::vector<int>({0, 1}));
+	EXPECT_EQ(Index.NumClans(), 1);
+}
+
+TEST(WarList, IndexFindMany)
+{
+	CWarEntryIndex Index;
+	FillIndex(Index, 100000);
+
+	EXPECT_EQ(Index.FindName("name99998"), std::vector<int>({99998}));
+	EXPECT_EQ(Index.FindClan("clan99999"), std::vector<int>({99999}));
+	EXPECT_TRUE(Index.FindName("name99999").empty());
+
+	Index.Erase(0, "", "clan0");
+	EXPECT_EQ(Index.FindName("name99998"), std::vector<int>({99997}));
+	EXPECT_EQ(Index.FindClan("clan99999"), std::vector<int>({99998}));
+	EXPECT_TRUE(Index.FindClan("clan0").empty());
+}
+
+class CTestWarEntry
+{
+public:
+	char m_aName[32];
+	char m_aClan[32];
+};
+
+// Positions of the entries with the given name or clan, by scanning the whole list
+static std::vector<int> ScanEntries(const std::vector<CTestWarEntry> &vEntries, const char *pName, const char *pClan)
+{
+	std::vector<int> vResult;
+	for(int i = 0; i < (int)vEntries.size(); i++)
+	{
+		if((pName[0] != '\0' && str_comp(vEntries[i].m_aName, pName) == 0) ||
+			(pClan[0] != '\0' && str_comp(vEntries[i].m_aClan, pClan) == 0))
+			vResult.push_back(i);
+	}
+	return vResult;
+}
+
+TEST(WarList, IndexMatchMany)
+{
+	// A large list with many repeated names and clans, like imported lists
+	std::vector<CTestWarEntry> vEntries(20000);
+	CWarEntryIndex Index;
+	for(int i = 0; i < (int)vEntries.size(); i++)
+	{
+		vEntries[i].m_aName[0] = '\0';
+		vEntries[i].m_aClan[0] = '\0';
+		if(i % 3 != 0)
+			str_format(vEntries[i].m_aName, sizeof(vEntries[i].m_aName), "name%d", (i * 7919) % 500);
+		if(i % 2 == 0)
+			str_format(vEntries[i].m_aClan, sizeof(vEntries[i].m_aClan), "clan%d", (i * 104729) % 100);
+		Index.Add(i, vEntries[i].m_aName, vEntries[i].m_aClan);
+	}
+
+	const auto CheckMatches = [&]() {
+		char aName[32];
+		char aClan[32];
+		for(int i = 0; i < 64; i++)
+		{
+			// Some of the players are not on the list
+			str_format(aName, sizeof(aName), "name%d", i * 11);
+			str_format(aClan, sizeof(aClan), "clan%d", i * 3);
+			std::vector<int> vFound = Index.FindName(aName);
+			vFound.insert(vFound.end(), Index.FindClan(aClan).begin(), Index.FindClan(aClan).end());
+			std::sort(vFound.begin(), vFound.end());
+			vFound.erase(std::unique(vFound.begin(), vFound.end()), vFound.end());
+			EXPECT_EQ(vFound, ScanEntries(vEntries, aName, aClan)) << aName << " " << aClan;
+		}
+	};
+	CheckMatches();
+
+	// Rename and erase entries all over the list
+	for(int i = 0; i < 500; i++)
+	{
+		const int Entry = (i * 7907) % vEntries.size();
+		if(i % 2 == 0)
+		{
+			Index.Remove(Entry, vEntries[Entry].m_aName, vEntries[Entry].m_aClan);
+			str_format(vEntries[Entry].m_aName, sizeof(vEntries[Entry].m_aName), "name%d", i);
+			Index.Insert(Entry, vEntries[Entry].m_aName, vEntries[Entry].m_aClan);
+		}
+		else
+		{
+			Index.Erase(Entry, vEntries[Entry].m_aName, vEntries[Entry].m_aClan);
+			vEntries.erase(vEntries.begin() + Entry);
+		}
+	}
+	CheckMatches();
+}
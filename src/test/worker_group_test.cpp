@@ -0,0 +1,102 @@
+#include "test.h"
+
+#include <engine/shared/worker_group.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+struct SWorkerGroupTestData
+{
+	std::vector<int> m_vValues;
+	std::atomic<int> m_NumCalls = 0;
+};
+
+static void SquareItem(void *pUser, int Index)
+{
+	SWorkerGroupTestData *pData = static_cast<SWorkerGroupTestData *>(pUser);
+	pData->m_vValues[Index] = Index * Index;
+	pData->m_NumCalls++;
+}
+
+static void TestWorkerGroup(int NumThreads)
+{
+	CWorkerGroup Group;
+	Group.Init(NumThreads);
+	EXPECT_EQ(Group.NumThreads(), NumThreads);
+
+	for(int NumItems : {0, 1, 2, 7, 64, 1000})
+	{
+		for(int Round = 0; Round < 20; Round++)
+		{
+			SWorkerGroupTestData Data;
+			Data.m_vValues.assign(NumItems, -1);
+			Group.Run(NumItems, SquareItem, &Data);
+			EXPECT_EQ(Data.m_NumCalls, NumItems);
+			for(int i = 0; i < NumItems; i++)
+				EXPECT_EQ(Data.m_vValues[i], i * i);
+		}
+	}
+	Group.Shutdown();
+	EXPECT_EQ(Group.NumThreads(), 0);
+}
+
+TEST(WorkerGroup, Serial)
+{
+	TestWorkerGroup(0);
+}
+
+TEST(WorkerGroup, Threads)
+{
+	TestWorkerGroup(1);
+	TestWorkerGroup(4);
+}
+
+TEST(WorkerGroup, Reinit)
+{
+	CWorkerGroup Group;
+	Group.Init(2);
+	Group.Init(3);
+	EXPECT_EQ(Group.NumThreads(), 3);
+	SWorkerGroupTestData Data;
+	Data.m_vValues.assign(10, -1);
+	Group.Run(10, SquareItem, &Data);
+	EXPECT_EQ(Data.m_NumCalls, 10);
+}
+
+struct SWorkerGroupRunData
+{
+	int m_Run;
+	std::vector<std::atomic<int>> m_vCalls;
+	std::vector<int> m_vRuns;
+};
+
+static void CountItem(void *pUser, int Index)
+{
+	SWorkerGroupRunData *pData = static_cast<SWorkerGroupRunData *>(pUser);
+	pData->m_vCalls[Index]++;
+	pData->m_vRuns[Index] = pData->m_Run;
+}
+
+TEST(WorkerGroup, BackToBackRuns)
+{
+	CWorkerGroup Group;
+	Group.Init(8);
+	for(int Run = 0; Run < 10000; Run++)
+	{
+		// a fresh allocation per run, like the callers whose data only lives for one run
+		const int NumItems = 2 + Run % 13;
+		auto pData = std::make_unique<SWorkerGroupRunData>();
+		pData->m_Run = Run;
+		pData->m_vCalls = std::vector<std::atomic<int>>(NumItems);
+		pData->m_vRuns.assign(NumItems, -1);
+		Group.Run(NumItems, CountItem, pData.get());
+		for(int i = 0; i < NumItems; i++)
+		{
+			ASSERT_EQ(pData->m_vCalls[i], 1) << "run " << Run << " item " << i;
+			ASSERT_EQ(pData->m_vRuns[i], Run) << "run " << Run << " item " << i;
+		}
+	}
+}